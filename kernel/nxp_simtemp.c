@@ -16,19 +16,85 @@
 #define DEVICE_NAME "simtemp"
 #define CLASS_NAME "simtemp"
 #define SIMTEMP_BUFFER_SIZE 1024
+#define SIMTEMP_AGG_BUFFER_SIZE 4096  /* per-file ring of the aggregate node */
+#define SIMTEMP_READER_CROSSINGS 16   /* pending crossings kept per threshold file */
+#define SIMTEMP_MAX_TEST_DEVICES 512
+#define SIMTEMP_MAX_TEST_PERIODS 16
+#define SIMTEMP_NO_BUS (-1)
+#define SIMTEMP_MAX_CONVERSION_US 1000000
+
+/* Timer wheel: 4 levels of 64 slots, 250 us ticks, about 70 minutes of range */
+#define SIMTEMP_WHEEL_TICK_NS     250000ULL
+#define SIMTEMP_WHEEL_BITS        6
+#define SIMTEMP_WHEEL_SLOTS       (1U << SIMTEMP_WHEEL_BITS)
+#define SIMTEMP_WHEEL_LEVELS      4
+#define SIMTEMP_WHEEL_DUE         SIMTEMP_WHEEL_LEVELS  /* channel level: on the due list */
+#define SIMTEMP_WHEEL_IDLE        0xff                  /* channel level: not queued */
+
+/* CPU budget governor */
+#define SIMTEMP_GOV_WINDOW_NS     NSEC_PER_SEC  /* accounting window */
+#define SIMTEMP_GOV_MAX_LEVEL     6             /* batch x2, x4, x8, then rate /2, /4, /8 */
+#define SIMTEMP_GOV_CALM_WINDOWS  3             /* windows under half the budget before stepping back */
 
 /* =============================================================================
  * DATA structures definitions
  * ============================================================================= */
 
 
+/*
+ * Shared bus model. Instances on the same bus id take turns: a conversion
+ * starts when the bus is free and holds it for the instance's conversion
+ * time, so instances requesting together are serialized.
+ */
+struct simtemp_bus {
+    struct list_head node;
+    int id;
+    unsigned int users;
+    u64 busy_until_ns;      /* end of the last conversion scheduled on the bus */
+    spinlock_t lock;
+};
+
+/* A device's entry in the timer wheel */
+struct simtemp_channel {
+    struct hlist_node node;
+    u64 expires_ns;         /* exact due time, used for sample timestamps */
+    u8 level;               /* wheel level, SIMTEMP_WHEEL_DUE or SIMTEMP_WHEEL_IDLE */
+    u8 slot;
+};
+
+/*
+ * Hierarchical timer wheel shared by all instances and driven by one
+ * hrtimer. Slots of level L are SIMTEMP_WHEEL_SLOTS^L ticks wide; a bit in
+ * occupied[L] is set while the slot holds channels.
+ */
+struct simtemp_wheel {
+    spinlock_t lock;
+    struct hrtimer timer;
+    u64 now_tick;           /* last tick processed */
+    u64 armed_tick;         /* tick the hrtimer is set for, U64_MAX = idle */
+    u64 occupied[SIMTEMP_WHEEL_LEVELS];
+    struct hlist_head slots[SIMTEMP_WHEEL_LEVELS][SIMTEMP_WHEEL_SLOTS];
+    struct hlist_head due;  /* expired, run in the current pass */
+};
+
+/* Ring occupancy telemetry since the last reset, kept under the ring's lock */
+struct simtemp_occupancy {
+    unsigned int high_watermark;    /* deepest count */
+    u64 high_since_ns;              /* start of the current stretch at 75% or more, 0 = below */
+    u64 high_total_ns;              /* finished stretches at 75% or more */
+    u64 overwritten;                /* samples dropped because the ring was full */
+};
+
 /* Ring buffer for samples */
 struct simtemp_buffer {
-    struct simtemp_sample samples[SIMTEMP_BUFFER_SIZE];
+    struct simtemp_sample_ext samples[SIMTEMP_BUFFER_SIZE];
     unsigned int head;
     unsigned int tail;
     unsigned int count;
+    __u64 next_seq;
     spinlock_t lock;
+    struct simtemp_occupancy occ;
+    struct list_head readers;   /* files with their own threshold */
 };
 
 /* Driver private data */
@@ -38,11 +104,15 @@ struct nxp_simtemp_data {
     struct device *dev;
     struct class *class;
     dev_t devt;
+    int id;                 /* instance number, 0 is "simtemp" */
+    char name[16];          /* misc device and class device name */
     
     /* Configuration */
     unsigned int sampling_ms;
     __s32 threshold_mC;
     simtemp_mode_t mode;
+    __u32 config_gen;       /* bumped on every configuration change */
+    __u32 sample_gen;       /* generation of the last produced sample */
     
     /* Statistics */
     unsigned long update_count;
@@ -57,8 +127,32 @@ struct nxp_simtemp_data {
     unsigned long ramp_counter;
     
     /* Timing */
-    struct hrtimer timer;
-    ktime_t period;
+    struct simtemp_channel channel;
+    ktime_t period;         /* nominal sampling period (sampling_ms) */
+    
+    /* CPU budget governor, updated from the timer callback under stats_lock */
+    unsigned int cpu_budget_us;     /* callback time allowed per second, 0 = unlimited */
+    unsigned int gov_level;         /* 0 = full rate, see nxp_simtemp_governor_apply() */
+    unsigned int batch;             /* samples produced per timer expiry */
+    unsigned int rate_div;          /* sampling period multiplier */
+    unsigned int calm_windows;      /* consecutive windows under half the budget */
+    u64 window_start_ns;
+    u64 window_busy_ns;
+    unsigned long cb_us;            /* callback time in the last full window, us */
+    unsigned long throttle_count;   /* governor step-ups */
+    
+    /* Shared bus model, NULL when the instance has its own bus */
+    struct simtemp_bus *bus;
+    int bus_id;
+    unsigned int conversion_us;
+    bool conv_pending;              /* conversion queued, timer set to its end */
+    u64 conv_request_ns;
+    u64 conv_start_ns;
+    u64 conv_end_ns;
+    unsigned long bus_conversions;
+    u64 bus_wait_total_ns;
+    u64 bus_wait_max_ns;
+    unsigned long bus_skipped;      /* request slots lost to a busy bus */
     
     /* Data buffer */
     struct simtemp_buffer buffer;
@@ -76,6 +170,56 @@ struct nxp_simtemp_data {
     struct device_attribute threshold_mC_attr;
     struct device_attribute mode_attr;
     struct device_attribute stats_attr;
+    struct device_attribute config_gen_attr;
+    struct device_attribute cpu_budget_us_attr;
+    struct device_attribute bus_attr;
+    struct device_attribute ring_attr;
+};
+
+/* Per-open file state */
+struct simtemp_reader {
+    struct nxp_simtemp_data *data;
+    __u32 format;           /* SIMTEMP_FORMAT_* */
+    
+    /*
+     * Per-file threshold, evaluated by the producer on every sample, so the
+     * crossing state follows the whole stream whichever file reads it. On
+     * buffer.readers while enabled; the fields below are under buffer.lock.
+     */
+    struct list_head node;
+    struct simtemp_threshold threshold;
+    bool above;             /* last produced sample was over the threshold */
+    struct simtemp_alert crossings[SIMTEMP_READER_CROSSINGS]; /* not yet received, oldest first */
+    unsigned int crossing_count;
+    unsigned int crossings_dropped;
+    
+    unsigned int fill_level; /* POLLRDBAND once this many samples are queued, 0 = off */
+};
+
+/*
+ * Aggregate node ("simtemp-all"). Every open file has its own ring, fed by
+ * the producer path of each selected instance, so one read drains samples
+ * from the whole board.
+ */
+struct simtemp_agg_reader {
+    struct list_head node;
+    struct simtemp_sample_tagged *samples;  /* SIMTEMP_AGG_BUFFER_SIZE entries */
+    unsigned int head;
+    unsigned int tail;
+    unsigned int count;
+    unsigned int fill_level;    /* POLLRDBAND once this many samples are queued, 0 = off */
+    struct simtemp_occupancy occ;
+    bool all;                   /* every instance, present and future */
+    DECLARE_BITMAP(select, SIMTEMP_AGG_MAX_DEVICES);
+};
+
+struct simtemp_aggregate {
+    spinlock_t lock;            /* readers and their rings */
+    struct list_head readers;
+    unsigned int reader_count;  /* read without the lock to skip idle work */
+    bool pending;               /* samples queued since the last wake-up, wheel lock held */
+    wait_queue_head_t wait;
+    bool registered;            /* misc device registered at load */
 };
 
 
@@ -93,6 +237,23 @@ static const struct file_operations nxp_simtemp_fops = {
     .unlocked_ioctl = nxp_simtemp_ioctl,
 };
 
+/* Aggregate node file operations */
+static const struct file_operations nxp_simtemp_agg_fops = {
+    .owner = THIS_MODULE,
+    .open = nxp_simtemp_agg_open,
+    .release = nxp_simtemp_agg_release,
+    .read = nxp_simtemp_agg_read,
+    .poll = nxp_simtemp_agg_poll,
+    .unlocked_ioctl = nxp_simtemp_agg_ioctl,
+};
+
+static struct miscdevice nxp_simtemp_agg_miscdev = {
+    .minor = MISC_DYNAMIC_MINOR,
+    .name = DEVICE_NAME "-all",
+    .fops = &nxp_simtemp_agg_fops,
+    .mode = 0444,
+};
+
 /* Device tree match table */
 static const struct of_device_id nxp_simtemp_of_match[] = {
     { .compatible = "nxp,simtemp" },
@@ -110,14 +271,56 @@ static struct platform_driver nxp_simtemp_driver = {
     },
 };
 
-/* Platform device for testing (when no device tree) */
-static struct platform_device *test_device;
+/* Platform devices for testing (when no device tree) */
+static struct platform_device *test_devices[SIMTEMP_MAX_TEST_DEVICES];
+
+/* Shared by all instances */
+static struct class *simtemp_class;
+static struct simtemp_wheel simtemp_wheel;
+static DEFINE_IDA(simtemp_ida);
+static LIST_HEAD(simtemp_buses);
+static DEFINE_MUTEX(simtemp_bus_mutex);
+static struct simtemp_aggregate simtemp_agg;
+
+/* Number of test platform devices created at load */
+static unsigned int test_count = 1;
+module_param_named(count, test_count, uint, 0444);
+MODULE_PARM_DESC(count, "Number of test devices to create when not bound via device tree (0-512)");
+
+/* Sampling periods of test devices, assigned round-robin by instance number */
+static unsigned int test_sampling_ms[SIMTEMP_MAX_TEST_PERIODS];
+static int test_sampling_count;
+module_param_array_named(sampling_ms, test_sampling_ms, uint, &test_sampling_count, 0444);
+MODULE_PARM_DESC(sampling_ms, "Sampling periods in ms for test devices, e.g. 10,250,1000");
+
+/* Bus model for devices without a device tree node */
+static int bus_id = SIMTEMP_NO_BUS;
+module_param(bus_id, int, 0444);
+MODULE_PARM_DESC(bus_id, "Shared bus for test devices (-1 = none)");
+
+static unsigned int conversion_us = 1000;
+module_param(conversion_us, uint, 0444);
+MODULE_PARM_DESC(conversion_us, "Conversion time of test devices on a shared bus in us");
+
+/* Aggregate node, costs nothing while no file has it open */
+static bool aggregate = true;
+module_param(aggregate, bool, 0444);
+MODULE_PARM_DESC(aggregate, "Create /dev/simtemp-all carrying the samples of every instance");
+
+/* Default CPU budget for new devices, in microseconds of callback time per second */
+static unsigned int cpu_budget_us = 20000;
+module_param(cpu_budget_us, uint, 0644);
+MODULE_PARM_DESC(cpu_budget_us, "Timer callback CPU budget per device in us/s (0 = unlimited)");
 
 /* Sysfs attribute definitions */
 static DEVICE_ATTR_RW(sampling_ms);
 static DEVICE_ATTR_RW(threshold_mC);
 static DEVICE_ATTR_RW(mode);
 static DEVICE_ATTR_RO(stats);
+static DEVICE_ATTR_RO(config_gen);
+static DEVICE_ATTR_RW(cpu_budget_us);
+static DEVICE_ATTR_RO(bus);
+static DEVICE_ATTR_RW(ring);
 
 /* =============================================================================
  * PRIVATE HELPER FUNCTIONS - DECLARATIONS
@@ -131,6 +334,48 @@ static void nxp_simtemp_init_ramp_mode(struct nxp_simtemp_data *data);
 static struct nxp_simtemp_data *nxp_simtemp_get_data(struct device *dev);
 /* Error logging helper */
 static void nxp_simtemp_log_error(const char *action, int error);
+/* Record copy helper */
+static int nxp_simtemp_copy_record(struct simtemp_reader *reader, char __user *buf,
+                                   const struct simtemp_sample_ext *sample);
+/* Per-file threshold helpers */
+static bool nxp_simtemp_reader_crossed(const struct simtemp_threshold *threshold, bool *above,
+                                       __s32 temp_mC);
+static void nxp_simtemp_reader_evaluate(struct simtemp_buffer *buffer,
+                                        const struct simtemp_sample_ext *sample);
+static void nxp_simtemp_reader_deliver(struct simtemp_reader *reader,
+                                       struct simtemp_sample_ext *sample);
+/* Aggregate node helpers */
+static void nxp_simtemp_agg_push(int id, const struct simtemp_sample_ext *sample);
+static unsigned int nxp_simtemp_agg_take(struct simtemp_agg_reader *reader,
+                                         struct simtemp_sample_tagged *records, unsigned int max);
+/* Ring occupancy helpers */
+static void nxp_simtemp_ring_account(struct simtemp_occupancy *occ, unsigned int count,
+                                     unsigned int capacity);
+static void nxp_simtemp_ring_snapshot(const struct simtemp_occupancy *occ, unsigned int count,
+                                      unsigned int capacity, struct simtemp_ring_stats *stats);
+static void nxp_simtemp_ring_reset(struct simtemp_occupancy *occ, unsigned int count,
+                                   unsigned int capacity);
+/* Configuration change notification helper */
+static void nxp_simtemp_config_bump(struct nxp_simtemp_data *data);
+static void nxp_simtemp_config_notify(struct nxp_simtemp_data *data, const char *attr_name);
+/* Timer interval helper */
+static ktime_t nxp_simtemp_timer_period(struct nxp_simtemp_data *data);
+/* CPU budget governor helpers */
+static void nxp_simtemp_governor_apply(struct nxp_simtemp_data *data);
+static void nxp_simtemp_governor_account(struct nxp_simtemp_data *data, u64 start_ns, u64 end_ns);
+/* Shared bus helpers */
+static struct simtemp_bus *nxp_simtemp_bus_get(int id);
+static void nxp_simtemp_bus_put(struct simtemp_bus *bus);
+static void nxp_simtemp_bus_request(struct nxp_simtemp_data *data, u64 now_ns);
+static void nxp_simtemp_bus_cancel(struct nxp_simtemp_data *data);
+/* Timer wheel helpers */
+static void nxp_simtemp_channel_start(struct nxp_simtemp_data *data, u64 expires_ns);
+static void nxp_simtemp_channel_stop(struct nxp_simtemp_data *data);
+static void nxp_simtemp_wheel_insert(struct simtemp_wheel *wheel, struct simtemp_channel *chan);
+static void nxp_simtemp_wheel_remove(struct simtemp_wheel *wheel, struct simtemp_channel *chan);
+static u64 nxp_simtemp_wheel_next_tick(struct simtemp_wheel *wheel);
+static void nxp_simtemp_wheel_advance(struct simtemp_wheel *wheel, u64 tick);
+static void nxp_simtemp_wheel_arm(struct simtemp_wheel *wheel);
 
 /* =============================================================================
  * CHARACTER DEVICE OPERATIONS
@@ -144,17 +389,28 @@ nxp_simtemp_open(
  * @brief Open the character device
  * 
  * This function is called when the character device is opened by user space.
- * It performs minimal initialization and sets the file private data pointer.
+ * It allocates the per-open reader state (record format, per-file threshold)
+ * and stores it in the file private data pointer. New readers start with the
+ * basic format and follow the device-wide threshold.
  * 
  * @param inode Pointer to the inode structure
  * @param file Pointer to the file structure
- * @return Always returns 0 (success)
+ * @return 0 on success, -ENOMEM if the reader state cannot be allocated
  **********************************************************************************/
 {
     struct nxp_simtemp_data *data;
+    struct simtemp_reader *reader;
     
     data = container_of(file->private_data, struct nxp_simtemp_data, miscdev);
-    file->private_data = data;
+    
+    reader = kzalloc(sizeof(*reader), GFP_KERNEL);
+    if (!reader) {
+        return -ENOMEM;
+    }
+    reader->data = data;
+    reader->format = SIMTEMP_FORMAT_BASIC;
+    INIT_LIST_HEAD(&reader->node);
+    file->private_data = reader;
     
     pr_debug("NXP SimTemp: Device opened\n");
     return 0;
@@ -169,14 +425,22 @@ nxp_simtemp_release(
  * @brief Close the character device
  * 
  * This function is called when the character device is closed by user space.
- * Currently performs minimal cleanup as the device doesn't maintain per-open
- * state that needs to be cleaned up.
+ * It frees the per-open reader state allocated in nxp_simtemp_open().
  * 
  * @param inode Pointer to the inode structure
  * @param file Pointer to the file structure
  * @return Always returns 0 (success)
  **********************************************************************************/
 {
+    struct simtemp_reader *reader = file->private_data;
+    unsigned long flags;
+    
+    /* Stop the producer evaluating this file's threshold */
+    spin_lock_irqsave(&reader->data->buffer.lock, flags);
+    list_del(&reader->node);
+    spin_unlock_irqrestore(&reader->data->buffer.lock, flags);
+    
+    kfree(reader);
     pr_debug("NXP SimTemp: Device closed\n");
     return 0;
 }
@@ -196,14 +460,26 @@ nxp_simtemp_read(
  * will wait until data is available. In non-blocking mode, it returns
  * immediately with -EAGAIN if no data is available.
  * 
- * Each read operation returns exactly one temperature sample containing:
+ * Each read operation returns as many whole temperature samples as fit in
+ * the user buffer (at least one), so consumers can drain a batch with a
+ * single syscall. Blocking readers only wait for the first sample; samples
+ * that are already queued are returned without further waiting. Each sample
+ * contains:
  * - Timestamp (nanoseconds)
  * - Temperature in milli-degrees Celsius
  * - Flags indicating sample status and threshold crossing
+ * - Sequence number (extended format only)
+ * 
+ * The record layout is chosen per open file with SIMTEMP_IOC_SET_FORMAT.
+ * If the file has its own threshold (SIMTEMP_IOC_SET_THRESHOLD), the
+ * THRESHOLD_CROSSED flag reflects that threshold instead: it is set on the
+ * samples the producer found crossing it. The threshold is evaluated on
+ * every sample, so files sharing the device see the same crossings; one
+ * consumed by another file stays pending for SIMTEMP_IOC_GET_ALERT.
  * 
  * @param file Pointer to the file structure
  * @param buf User space buffer to copy data to
- * @param count Number of bytes requested (must be >= sizeof(simtemp_sample))
+ * @param count Number of bytes requested (must be >= one record)
  * @param ppos File position (not used, always reads from current sample)
  * @return Number of bytes read on success, negative error code on failure
  *         -EINVAL: Invalid buffer size
@@ -211,11 +487,16 @@ nxp_simtemp_read(
  *         -EFAULT: Failed to copy data to user space
  **********************************************************************************/
 {
-    struct nxp_simtemp_data *data = file->private_data;
-    struct simtemp_sample sample;
+    struct simtemp_reader *reader = file->private_data;
+    struct nxp_simtemp_data *data = reader->data;
+    struct simtemp_sample_ext sample;
+    size_t record_size;
+    size_t copied = 0;
     int ret;
     
-    if (count < sizeof(sample)) {
+    record_size = (reader->format == SIMTEMP_FORMAT_EXTENDED) ?
+                  sizeof(struct simtemp_sample_ext) : sizeof(struct simtemp_sample);
+    if (count < record_size) {
         return -EINVAL;
     }
     
@@ -234,12 +515,17 @@ nxp_simtemp_read(
         }
     }
     
-    /* Copy sample to user space */
-    if (copy_to_user(buf, &sample, sizeof(sample))) {
-        return -EFAULT;
-    }
+    /* Copy samples to user space until the buffer is full or the ring is empty */
+    do {
+        nxp_simtemp_reader_deliver(reader, &sample);
+        if (nxp_simtemp_copy_record(reader, buf + copied, &sample)) {
+            return copied ? copied : -EFAULT;
+        }
+        copied += record_size;
+    } while (count - copied >= record_size &&
+             nxp_simtemp_get_sample(data, &sample) == 0);
     
-    return sizeof(sample);
+    return copied;
 }
 
 /**********************************************************************************/
@@ -255,14 +541,27 @@ nxp_simtemp_poll(
  * without blocking. The function registers the wait queues with the poll table
  * and returns the current status of data availability.
  * 
+ * A file with its own threshold also gets POLLPRI while a crossing of it is
+ * pending, that is until the crossing sample is read from this file or
+ * fetched with SIMTEMP_IOC_GET_ALERT. The producer latches the crossings
+ * per file, whichever file consumes the samples.
+ * 
+ * A file with a fill level (SIMTEMP_IOC_SET_FILL_LEVEL) gets POLLRDBAND
+ * while at least that many samples are queued. Pollers are woken on every
+ * expiry, so a consumer waiting for POLLRDBAND alone sleeps until the ring
+ * fills to its level.
+ * 
  * @param file Pointer to the file structure
  * @param wait Pointer to the poll table for registering wait queues
  * @return Poll mask indicating available operations:
  *         - POLLIN | POLLRDNORM: Data is available for reading
+ *         - POLLPRI: A crossing of this file's threshold is pending
+ *         - POLLRDBAND: The ring holds at least this file's fill level
  *         - 0: No data available
  **********************************************************************************/
 {
-    struct nxp_simtemp_data *data = file->private_data;
+    struct simtemp_reader *reader = file->private_data;
+    struct nxp_simtemp_data *data = reader->data;
     __poll_t mask = 0;
     unsigned long flags;
     
@@ -276,9 +575,15 @@ nxp_simtemp_poll(
         mask |= POLLIN | POLLRDNORM;
     }
     
-    /* Check if threshold was crossed (this would be set by the timer callback) */
-    /* For now, we'll implement a simple check - in a real implementation,
-     * we'd track threshold crossing events separately */
+    /* Check if a crossing of this file's threshold is pending */
+    if (reader->crossing_count) {
+        mask |= POLLPRI;
+    }
+    
+    /* Check if the ring has filled to this file's level */
+    if (reader->fill_level && data->buffer.count >= READ_ONCE(reader->fill_level)) {
+        mask |= POLLRDBAND;
+    }
     
     spin_unlock_irqrestore(&data->buffer.lock, flags);
     
@@ -294,8 +599,21 @@ nxp_simtemp_ioctl(
 /**
  * @brief Handle ioctl commands for the device
  * 
- * This function handles ioctl commands for atomic configuration of the device.
- * Currently not implemented - all commands return -ENOTTY.
+ * This function handles ioctl commands for the device. Supported commands:
+ * - SIMTEMP_IOC_SET_FORMAT: Select the record format returned by read() on
+ *   this open file (SIMTEMP_FORMAT_BASIC or SIMTEMP_FORMAT_EXTENDED)
+ * - SIMTEMP_IOC_SET_THRESHOLD: Give this open file its own threshold and
+ *   hysteresis (or return it to the device threshold). The crossing state
+ *   restarts below the threshold
+ * - SIMTEMP_IOC_GET_THRESHOLD: Read this file's threshold; when it follows
+ *   the device, the device threshold_mC is reported with enabled = 0
+ * - SIMTEMP_IOC_GET_RING: Read the ring occupancy (depth, high-watermark,
+ *   time at least 75% full, overwritten samples) and this file's fill level
+ * - SIMTEMP_IOC_RESET_RING: Restart the ring occupancy counters
+ * - SIMTEMP_IOC_SET_FILL_LEVEL: Raise POLLRDBAND on this file while at least
+ *   this many samples are queued (0 disables)
+ * - SIMTEMP_IOC_GET_ALERT: Fetch and acknowledge the oldest pending crossing
+ *   of this file's threshold
  * 
  * Future implementation could support:
  * - Atomic configuration changes
@@ -305,11 +623,373 @@ nxp_simtemp_ioctl(
  * @param file Pointer to the file structure
  * @param cmd Ioctl command number
  * @param arg Command argument (user space pointer)
- * @return -ENOTTY (not implemented)
+ * @return 0 on success, negative error code on failure:
+ *         -ENOTTY: Unknown or unimplemented command
+ *         -EFAULT: Failed to copy the argument from user space
+ *         -EINVAL: Invalid argument value
+ **********************************************************************************/
+{
+    struct simtemp_reader *reader = file->private_data;
+    struct simtemp_buffer *buffer = &reader->data->buffer;
+    struct simtemp_threshold threshold;
+    struct simtemp_ring_stats ring;
+    struct simtemp_alert alert;
+    unsigned long flags;
+    __u32 format;
+    __u32 level;
+    
+    if (_IOC_TYPE(cmd) != SIMTEMP_IOC_MAGIC || _IOC_NR(cmd) > SIMTEMP_IOC_MAXNR) {
+        return -ENOTTY;
+    }
+    
+    switch (cmd) {
+    case SIMTEMP_IOC_SET_FORMAT:
+        if (get_user(format, (__u32 __user *)arg)) {
+            return -EFAULT;
+        }
+        if (format != SIMTEMP_FORMAT_BASIC && format != SIMTEMP_FORMAT_EXTENDED) {
+            return -EINVAL;
+        }
+        reader->format = format;
+        return 0;
+        
+    case SIMTEMP_IOC_SET_THRESHOLD:
+        if (copy_from_user(&threshold, (void __user *)arg, sizeof(threshold))) {
+            return -EFAULT;
+        }
+        if (threshold.enabled > 1) {
+            return -EINVAL;
+        }
+        spin_lock_irqsave(&buffer->lock, flags);
+        reader->threshold = threshold;
+        reader->above = false;
+        reader->crossing_count = 0;
+        reader->crossings_dropped = 0;
+        list_del_init(&reader->node);
+        if (threshold.enabled) {
+            list_add_tail(&reader->node, &buffer->readers);
+        }
+        spin_unlock_irqrestore(&buffer->lock, flags);
+        return 0;
+        
+    case SIMTEMP_IOC_GET_THRESHOLD:
+        spin_lock_irqsave(&buffer->lock, flags);
+        threshold = reader->threshold;
+        spin_unlock_irqrestore(&buffer->lock, flags);
+        if (!threshold.enabled) {
+            threshold.threshold_mC = READ_ONCE(reader->data->threshold_mC);
+            threshold.hysteresis_mC = 0;
+        }
+        return copy_to_user((void __user *)arg, &threshold, sizeof(threshold)) ? -EFAULT : 0;
+        
+    case SIMTEMP_IOC_GET_RING:
+        spin_lock_irqsave(&buffer->lock, flags);
+        nxp_simtemp_ring_snapshot(&buffer->occ, buffer->count, SIMTEMP_BUFFER_SIZE, &ring);
+        spin_unlock_irqrestore(&buffer->lock, flags);
+        ring.fill_level = READ_ONCE(reader->fill_level);
+        return copy_to_user((void __user *)arg, &ring, sizeof(ring)) ? -EFAULT : 0;
+        
+    case SIMTEMP_IOC_RESET_RING:
+        spin_lock_irqsave(&buffer->lock, flags);
+        nxp_simtemp_ring_reset(&buffer->occ, buffer->count, SIMTEMP_BUFFER_SIZE);
+        spin_unlock_irqrestore(&buffer->lock, flags);
+        return 0;
+        
+    case SIMTEMP_IOC_SET_FILL_LEVEL:
+        if (get_user(level, (__u32 __user *)arg)) {
+            return -EFAULT;
+        }
+        if (level > SIMTEMP_BUFFER_SIZE) {
+            return -EINVAL;
+        }
+        WRITE_ONCE(reader->fill_level, level);
+        return 0;
+        
+    case SIMTEMP_IOC_GET_ALERT:
+        memset(&alert, 0, sizeof(alert));
+        spin_lock_irqsave(&buffer->lock, flags);
+        if (reader->crossing_count) {
+            alert = reader->crossings[0];
+            reader->crossing_count--;
+            memmove(&reader->crossings[0], &reader->crossings[1],
+                    reader->crossing_count * sizeof(reader->crossings[0]));
+        }
+        alert.pending = reader->crossing_count;
+        alert.dropped = reader->crossings_dropped;
+        spin_unlock_irqrestore(&buffer->lock, flags);
+        return copy_to_user((void __user *)arg, &alert, sizeof(alert)) ? -EFAULT : 0;
+        
+    default:
+        /* TODO: Implement ioctl commands for atomic configuration */
+        return -ENOTTY;
+    }
+}
+
+/* =============================================================================
+ * AGGREGATE NODE OPERATIONS
+ * ============================================================================= */
+
+int
+nxp_simtemp_agg_open(
+    struct inode *inode,
+    struct file *file)
+/**
+ * @brief Open the aggregate node
+ * 
+ * Allocates this file's ring and adds it to the aggregate readers, selecting
+ * every instance. From here on each selected instance's producer path also
+ * queues its samples, tagged with the instance number, into this ring.
+ * 
+ * @param inode Pointer to the inode structure
+ * @param file Pointer to the file structure
+ * @return 0 on success, -ENOMEM if the ring cannot be allocated
+ **********************************************************************************/
+{
+    struct simtemp_agg_reader *reader;
+    unsigned long flags;
+    
+    reader = kzalloc(sizeof(*reader), GFP_KERNEL);
+    if (!reader) {
+        return -ENOMEM;
+    }
+    reader->samples = kvmalloc_array(SIMTEMP_AGG_BUFFER_SIZE, sizeof(*reader->samples), GFP_KERNEL);
+    if (!reader->samples) {
+        kfree(reader);
+        return -ENOMEM;
+    }
+    reader->all = true;
+    file->private_data = reader;
+    
+    spin_lock_irqsave(&simtemp_agg.lock, flags);
+    list_add_tail(&reader->node, &simtemp_agg.readers);
+    WRITE_ONCE(simtemp_agg.reader_count, simtemp_agg.reader_count + 1);
+    spin_unlock_irqrestore(&simtemp_agg.lock, flags);
+    
+    pr_debug("NXP SimTemp: Aggregate node opened\n");
+    return 0;
+}
+
+/**********************************************************************************/
+int
+nxp_simtemp_agg_release(
+    struct inode *inode,
+    struct file *file)
+/**
+ * @brief Close the aggregate node
+ * 
+ * Removes this file from the aggregate readers and frees its ring.
+ * 
+ * @param inode Pointer to the inode structure
+ * @param file Pointer to the file structure
+ * @return Always returns 0 (success)
+ **********************************************************************************/
+{
+    struct simtemp_agg_reader *reader = file->private_data;
+    unsigned long flags;
+    
+    spin_lock_irqsave(&simtemp_agg.lock, flags);
+    list_del(&reader->node);
+    WRITE_ONCE(simtemp_agg.reader_count, simtemp_agg.reader_count - 1);
+    spin_unlock_irqrestore(&simtemp_agg.lock, flags);
+    
+    kvfree(reader->samples);
+    kfree(reader);
+    pr_debug("NXP SimTemp: Aggregate node closed\n");
+    return 0;
+}
+
+/**********************************************************************************/
+ssize_t
+nxp_simtemp_agg_read(
+    struct file *file,
+    char __user *buf,
+    size_t count,
+    loff_t *ppos)
+/**
+ * @brief Read tagged samples of all selected instances
+ * 
+ * Returns as many whole struct simtemp_sample_tagged records as fit in the
+ * user buffer (at least one), in the order the instances produced them.
+ * Blocking readers wait for the first record only. Records are taken from
+ * the ring in chunks, so the lock is held once per chunk rather than once
+ * per record.
+ * 
+ * @param file Pointer to the file structure
+ * @param buf User space buffer to copy data to
+ * @param count Number of bytes requested (must be >= one record)
+ * @param ppos File position (not used)
+ * @return Number of bytes read on success, negative error code on failure
+ *         -EINVAL: Buffer smaller than one record
+ *         -EAGAIN: No data available (non-blocking mode)
+ *         -EFAULT: Failed to copy data to user space
+ **********************************************************************************/
+{
+    struct simtemp_agg_reader *reader = file->private_data;
+    struct simtemp_sample_tagged chunk[8];
+    size_t record_size = sizeof(chunk[0]);
+    size_t copied = 0;
+    unsigned int n;
+    int ret;
+    
+    if (count < record_size) {
+        return -EINVAL;
+    }
+    
+    while (count - copied >= record_size) {
+        n = nxp_simtemp_agg_take(reader, chunk,
+                                 min_t(size_t, ARRAY_SIZE(chunk), (count - copied) / record_size));
+        if (!n) {
+            if (copied) {
+                break;
+            }
+            if (file->f_flags & O_NONBLOCK) {
+                return -EAGAIN;
+            }
+            
+            /* Block until a selected instance produces */
+            ret = wait_event_interruptible(simtemp_agg.wait, READ_ONCE(reader->count) > 0);
+            if (ret) {
+                return ret;
+            }
+            continue;
+        }
+        
+        if (copy_to_user(buf + copied, chunk, n * record_size)) {
+            return copied ? copied : -EFAULT;
+        }
+        copied += n * record_size;
+    }
+    
+    return copied;
+}
+
+/**********************************************************************************/
+__poll_t
+nxp_simtemp_agg_poll(
+    struct file *file,
+    poll_table *wait)
+/**
+ * @brief Poll the aggregate node
+ * 
+ * The aggregate wait queue is woken once per timer wheel pass that queued
+ * samples for any aggregate file, however many instances were due in it.
+ * 
+ * @param file Pointer to the file structure
+ * @param wait Pointer to the poll table for registering wait queues
+ * @return Poll mask indicating available operations:
+ *         - POLLIN | POLLRDNORM: Records are available for reading
+ *         - POLLRDBAND: At least this file's fill level is queued
+ *         - 0: No data available
+ **********************************************************************************/
+{
+    struct simtemp_agg_reader *reader = file->private_data;
+    __poll_t mask = 0;
+    unsigned long flags;
+    
+    poll_wait(file, &simtemp_agg.wait, wait);
+    
+    spin_lock_irqsave(&simtemp_agg.lock, flags);
+    if (reader->count > 0) {
+        mask |= POLLIN | POLLRDNORM;
+    }
+    if (reader->fill_level && reader->count >= reader->fill_level) {
+        mask |= POLLRDBAND;
+    }
+    spin_unlock_irqrestore(&simtemp_agg.lock, flags);
+    
+    return mask;
+}
+
+/**********************************************************************************/
+long
+nxp_simtemp_agg_ioctl(
+    struct file *file,
+    unsigned int cmd,
+    unsigned long arg)
+/**
+ * @brief Handle ioctl commands for the aggregate node
+ * 
+ * Supported commands:
+ * - SIMTEMP_IOC_SET_SELECT: Choose the instances feeding this file (all, or
+ *   a bitmap of instance numbers). Applies to samples produced afterwards;
+ *   records already queued stay
+ * - SIMTEMP_IOC_GET_SELECT: Read the selection
+ * - SIMTEMP_IOC_GET_RING / SIMTEMP_IOC_RESET_RING: Occupancy of this file's
+ *   ring, as for an instance
+ * - SIMTEMP_IOC_SET_FILL_LEVEL: POLLRDBAND while at least this many records
+ *   are queued (0 disables, up to the ring size)
+ * 
+ * Instance commands (record format, thresholds, configuration) do not apply.
+ * 
+ * @param file Pointer to the file structure
+ * @param cmd Ioctl command number
+ * @param arg Command argument (user space pointer)
+ * @return 0 on success, negative error code on failure:
+ *         -ENOTTY: Command not supported on the aggregate node
+ *         -EFAULT: Failed to copy the argument
+ *         -EINVAL: Invalid argument value
  **********************************************************************************/
 {
-    /* TODO: Implement ioctl commands for atomic configuration */
-    return -ENOTTY;
+    struct simtemp_agg_reader *reader = file->private_data;
+    struct simtemp_select select;
+    struct simtemp_ring_stats ring;
+    unsigned long flags;
+    __u32 level;
+    
+    if (_IOC_TYPE(cmd) != SIMTEMP_IOC_MAGIC || _IOC_NR(cmd) > SIMTEMP_IOC_MAXNR) {
+        return -ENOTTY;
+    }
+    
+    switch (cmd) {
+    case SIMTEMP_IOC_SET_SELECT:
+        if (copy_from_user(&select, (void __user *)arg, sizeof(select))) {
+            return -EFAULT;
+        }
+        if (select.all > 1 || select.reserved) {
+            return -EINVAL;
+        }
+        spin_lock_irqsave(&simtemp_agg.lock, flags);
+        reader->all = select.all;
+        bitmap_from_arr64(reader->select, select.mask, SIMTEMP_AGG_MAX_DEVICES);
+        spin_unlock_irqrestore(&simtemp_agg.lock, flags);
+        return 0;
+        
+    case SIMTEMP_IOC_GET_SELECT:
+        memset(&select, 0, sizeof(select));
+        spin_lock_irqsave(&simtemp_agg.lock, flags);
+        select.all = reader->all;
+        bitmap_to_arr64(select.mask, reader->select, SIMTEMP_AGG_MAX_DEVICES);
+        spin_unlock_irqrestore(&simtemp_agg.lock, flags);
+        return copy_to_user((void __user *)arg, &select, sizeof(select)) ? -EFAULT : 0;
+        
+    case SIMTEMP_IOC_GET_RING:
+        spin_lock_irqsave(&simtemp_agg.lock, flags);
+        nxp_simtemp_ring_snapshot(&reader->occ, reader->count, SIMTEMP_AGG_BUFFER_SIZE, &ring);
+        ring.fill_level = reader->fill_level;
+        spin_unlock_irqrestore(&simtemp_agg.lock, flags);
+        return copy_to_user((void __user *)arg, &ring, sizeof(ring)) ? -EFAULT : 0;
+        
+    case SIMTEMP_IOC_RESET_RING:
+        spin_lock_irqsave(&simtemp_agg.lock, flags);
+        nxp_simtemp_ring_reset(&reader->occ, reader->count, SIMTEMP_AGG_BUFFER_SIZE);
+        spin_unlock_irqrestore(&simtemp_agg.lock, flags);
+        return 0;
+        
+    case SIMTEMP_IOC_SET_FILL_LEVEL:
+        if (get_user(level, (__u32 __user *)arg)) {
+            return -EFAULT;
+        }
+        if (level > SIMTEMP_AGG_BUFFER_SIZE) {
+            return -EINVAL;
+        }
+        spin_lock_irqsave(&simtemp_agg.lock, flags);
+        reader->fill_level = level;
+        spin_unlock_irqrestore(&simtemp_agg.lock, flags);
+        return 0;
+        
+    default:
+        return -ENOTTY;
+    }
 }
 
 /* =============================================================================
@@ -327,7 +1007,9 @@ nxp_simtemp_probe(
  * - Memory allocation for driver data
  * - Default configuration setup
  * - Synchronization primitives initialization
+ * - Instance number allocation ("simtemp", "simtemp1", ...)
  * - Device tree parsing (optional)
+ * - Shared bus attachment (optional)
  * - High-resolution timer setup
  * - Character device registration
  * - Sysfs attribute creation
@@ -366,32 +1048,72 @@ nxp_simtemp_probe(
     data->last_temp_mC = 25000;  /* Initialize to base temperature */
     data->ramp_direction = 1;    /* Will be adjusted when switching to ramp mode */
     data->ramp_counter = 0;
+    data->cpu_budget_us = cpu_budget_us;
+    data->batch = 1;
+    data->rate_div = 1;
+    data->bus_id = bus_id;
+    data->conversion_us = clamp(conversion_us, 1U, (unsigned int)SIMTEMP_MAX_CONVERSION_US);
+    data->channel.level = SIMTEMP_WHEEL_IDLE;
     
     /* Initialize synchronization primitives */
     mutex_init(&data->config_mutex);
     spin_lock_init(&data->stats_lock);
     spin_lock_init(&data->buffer.lock);
+    INIT_LIST_HEAD(&data->buffer.readers);
     
     /* Initialize wait queues */
     init_waitqueue_head(&data->read_wait);
     init_waitqueue_head(&data->poll_wait);
     
+    /* Allocate the instance number; the first instance keeps the plain name */
+    data->id = ida_alloc(&simtemp_ida, GFP_KERNEL);
+    if (data->id < 0) {
+        nxp_simtemp_log_error("allocate instance number", data->id);
+        return data->id;
+    }
+    if (data->id == 0) {
+        strscpy(data->name, DEVICE_NAME, sizeof(data->name));
+    } else {
+        snprintf(data->name, sizeof(data->name), DEVICE_NAME "%d", data->id);
+    }
+    
+    /* Test device periods from the module parameter (DT overrides below) */
+    if (test_sampling_count > 0) {
+        unsigned int ms = test_sampling_ms[data->id % test_sampling_count];
+        
+        if (ms >= 1 && ms <= 10000) {
+            data->sampling_ms = ms;
+        }
+    }
+    
     /* Parse device tree */
     ret = nxp_simtemp_parse_dt(data);
     if (ret) {
         pr_warn("Failed to parse device tree, using defaults: %d\n", ret);
     }
     
+    /* Join the shared bus, if any */
+    if (data->bus_id != SIMTEMP_NO_BUS) {
+        data->bus = nxp_simtemp_bus_get(data->bus_id);
+        if (!data->bus) {
+            ret = -ENOMEM;
+            nxp_simtemp_log_error("attach shared bus", ret);
+            goto cleanup_id;
+        }
+        pr_info("NXP SimTemp: %s on bus %d, conversion %u us\n",
+                data->name, data->bus_id, data->conversion_us);
+    }
+    
     /* Initialize timer */
     ret = nxp_simtemp_init_timer(data);
     if (ret) {
         nxp_simtemp_log_error("initialize timer", ret);
-        return ret;
+        goto cleanup_bus;
     }
     
     /* Create character device */
     data->miscdev.minor = MISC_DYNAMIC_MINOR;
-    data->miscdev.name = DEVICE_NAME;
+    data->miscdev.name = data->name;
     data->miscdev.fops = &nxp_simtemp_fops;
     data->miscdev.parent = &pdev->dev;
     data->miscdev.mode = 0666;  /* Set permissions to rw-rw-rw- */
@@ -416,6 +1138,10 @@ cleanup_misc:
     misc_deregister(&data->miscdev);
 cleanup_timer:
     nxp_simtemp_cleanup_timer(data);
+cleanup_bus:
+    nxp_simtemp_bus_put(data->bus);
+cleanup_id:
+    ida_free(&simtemp_ida, data->id);
     return ret;
 }
 
@@ -431,6 +1157,7 @@ nxp_simtemp_remove(
  * - Stop the high-resolution timer
  * - Remove sysfs attributes
  * - Unregister the character device
+ * - Leave the shared bus and release the instance number
  * 
  * The function ensures proper resource cleanup to prevent memory leaks and
  * system instability.
@@ -451,6 +1178,9 @@ nxp_simtemp_remove(
     /* Unregister misc device */
     misc_deregister(&data->miscdev);
     
+    nxp_simtemp_bus_put(data->bus);
+    ida_free(&simtemp_ida, data->id);
+    
     pr_info("NXP SimTemp: Device removed successfully\n");
 }
 
@@ -469,6 +1199,9 @@ nxp_simtemp_parse_dt(
  * - sampling-ms: Temperature sampling period (1-10000 ms)
  * - threshold-mC: Temperature threshold in milli-degrees Celsius
  * - mode: Simulation mode ("normal", "noisy", or "ramp")
+ * - bus-id: Shared bus the sensor sits on; sensors with the same id have
+ *   their conversions serialized
+ * - conversion-us: Time one conversion holds the bus (1-1000000 us)
  * 
  * If properties are missing or invalid, default values are used and warnings
  * are logged. The function is called during device probe.
@@ -513,6 +1246,25 @@ nxp_simtemp_parse_dt(
         pr_info("DT: mode = %s\n", mode_str);
     }
     
+    /* Parse bus-id and conversion-us properties */
+    if (of_property_read_u32(np, "bus-id", &val) == 0) {
+        if (val <= INT_MAX) {
+            data->bus_id = (int)val;
+            pr_info("DT: bus-id = %u\n", val);
+        } else {
+            pr_warn("DT: Invalid bus-id value %u, ignoring\n", val);
+        }
+    }
+    
+    if (of_property_read_u32(np, "conversion-us", &val) == 0) {
+        if (val > 0 && val <= SIMTEMP_MAX_CONVERSION_US) {
+            data->conversion_us = val;
+            pr_info("DT: conversion-us = %u\n", val);
+        } else {
+            pr_warn("DT: Invalid conversion-us value %u, using default\n", val);
+        }
+    }
+    
     return 0;
 }
 
@@ -524,26 +1276,23 @@ int
 nxp_simtemp_init_timer(
     struct nxp_simtemp_data *data)
 /**
- * @brief Initialize the high-resolution timer for temperature sampling
- * 
- * This function sets up a high-resolution timer that periodically generates
- * temperature samples. The timer uses CLOCK_MONOTONIC and runs in relative
- * mode, restarting automatically after each callback.
+ * @brief Schedule the device on the driver's timer wheel
  * 
- * The timer period is calculated from the sampling_ms configuration and
- * converted to nanoseconds for the kernel timer subsystem.
+ * All instances share one hierarchical timer wheel driven by a single
+ * high-resolution timer (CLOCK_MONOTONIC, absolute expiries). This function
+ * computes the sampling period from the sampling_ms configuration and queues
+ * the device's first expiry one period from now.
  * 
  * @param data Pointer to the driver data structure
  * @return 0 on success (always succeeds)
  **********************************************************************************/
 {
-    hrtimer_init(&data->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
-    data->timer.function = nxp_simtemp_timer_callback;
+    data->period = ms_to_ktime(data->sampling_ms);
+    data->window_start_ns = ktime_get_ns();
     
-    data->period = ktime_set(0, data->sampling_ms * 1000000);  /* Convert ms to ns */
-    
-    /* Start the timer */
-    hrtimer_start(&data->timer, data->period, HRTIMER_MODE_REL);
+    /* Queue the first expiry */
+    nxp_simtemp_channel_start(data, data->window_start_ns +
+                              ktime_to_ns(nxp_simtemp_timer_period(data)));
     
     pr_info("NXP SimTemp: Timer initialized with period %u ms\n", data->sampling_ms);
     return 0;
@@ -554,71 +1303,205 @@ void
 nxp_simtemp_cleanup_timer(
     struct nxp_simtemp_data *data)
 /**
- * @brief Cleanup and stop the high-resolution timer
+ * @brief Remove the device from the timer wheel
  * 
- * This function stops the temperature sampling timer and performs cleanup.
- * It is called during device removal to ensure no more samples are generated
- * and to prevent use-after-free issues.
+ * This function stops the temperature sampling of the device. Channels run
+ * under the wheel lock, so once the device is dequeued its expiry function
+ * is not running and will not run again, which prevents use-after-free
+ * issues on removal.
  * 
  * @param data Pointer to the driver data structure
  **********************************************************************************/
 {
-    hrtimer_cancel(&data->timer);
+    nxp_simtemp_channel_stop(data);
+    nxp_simtemp_bus_cancel(data);
     pr_info("NXP SimTemp: Timer cleaned up\n");
 }
 
 /**********************************************************************************/
-enum hrtimer_restart
-nxp_simtemp_timer_callback(
-    struct hrtimer *timer)
+u64
+nxp_simtemp_channel_expire(
+    struct nxp_simtemp_data *data,
+    u64 due_ns)
 /**
- * @brief High-resolution timer callback for temperature sampling
+ * @brief Timer wheel expiry function for temperature sampling
  * 
- * This function is called periodically by the high-resolution timer to generate
- * temperature samples. It performs the following operations:
- * - Generates a new temperature sample based on the current simulation mode
- * - Adds the sample to the ring buffer
+ * This function is called by the timer wheel, with the wheel lock held, for
+ * every device whose expiry is due. It performs the following operations:
+ * - Generates the batch of temperature samples due at due_ns (one at full
+ *   rate), timestamped one sampling period apart
+ * - Adds the samples to the ring buffer
  * - Wakes up any waiting readers (blocking I/O)
  * - Wakes up any polling processes (non-blocking I/O)
- * - Restarts the timer for the next sample
+ * - Charges its own run time to the CPU budget governor
+ * - Returns the next expiry
  * 
- * The function always returns HRTIMER_RESTART to continue periodic sampling.
+ * Samples are stamped from due_ns, the exact grid time of the expiry, not
+ * from the time the wheel got to it, so the wheel's tick granularity only
+ * delays delivery and never moves timestamps.
  * 
- * @param timer Pointer to the high-resolution timer structure
- * @return HRTIMER_RESTART to continue periodic sampling
+ * Under the governor the expiries are batch * rate_div sampling periods
+ * apart and produce batch samples, so waking readers is amortized over the
+ * batch and, at the higher levels, fewer samples are produced.
+ * 
+ * On a shared bus each period takes two expiries. The first requests a
+ * conversion, which starts once the bus is free, and returns the end of the
+ * conversion; the second publishes the samples stamped with the conversion
+ * end time and the queueing delay, then returns the next request on the
+ * grid. Grid slots that passed while waiting are skipped.
+ * 
+ * @param data Pointer to the driver data structure
+ * @param due_ns Expiry time the device was queued for
+ * @return Next expiry time (monotonic ns), always in the future
  **********************************************************************************/
 {
-    struct nxp_simtemp_data *data = container_of(timer, struct nxp_simtemp_data, timer);
+    u64 start_ns = ktime_get_ns();
+    u64 sample_ns = due_ns;
+    u64 period_ns;
+    u64 next_ns;
+    u64 missed;
+    u64 step_ns;
+    unsigned int batch;
+    unsigned int i;
     __s32 temp_mC;
     int ret;
     
-    /* Generate temperature sample */
-    temp_mC = nxp_simtemp_generate_temp(data);
+    if (data->bus) {
+        if (!data->conv_pending) {
+            /* Queue the conversion and come back when it completes */
+            nxp_simtemp_bus_request(data, due_ns);
+            nxp_simtemp_governor_account(data, start_ns, ktime_get_ns());
+            return data->conv_end_ns;
+        }
+        sample_ns = data->conv_end_ns;
+    }
+    
+    batch = READ_ONCE(data->batch);
+    step_ns = ktime_to_ns(data->period) * READ_ONCE(data->rate_div);
     
-    /* Add sample to buffer */
-    ret = nxp_simtemp_add_sample(data, temp_mC);
-    if (ret) {
-        pr_warn("NXP SimTemp: Failed to add sample: %d\n", ret);
+    for (i = 0; i < batch; i++) {
+        /* Generate temperature sample */
+        temp_mC = nxp_simtemp_generate_temp(data);
+        
+        /* Add sample to buffer, backdated to its slot in the batch */
+        ret = nxp_simtemp_add_sample(data, temp_mC, sample_ns - (u64)(batch - 1 - i) * step_ns);
+        if (ret) {
+            pr_warn("NXP SimTemp: Failed to add sample: %d\n", ret);
+        }
     }
     
     /* Wake up any waiting readers */
     wake_up_interruptible(&data->read_wait);
     wake_up_interruptible(&data->poll_wait);
     
-    /* Restart timer */
-    hrtimer_forward_now(timer, data->period);
-    return HRTIMER_RESTART;
+    nxp_simtemp_governor_account(data, start_ns, ktime_get_ns());
+    
+    /* Next expiry on the grid, skipping slots that have already passed */
+    period_ns = ktime_to_ns(nxp_simtemp_timer_period(data));
+    next_ns = (data->bus ? data->conv_request_ns : due_ns) + period_ns;
+    start_ns = ktime_get_ns();
+    missed = 0;
+    if (next_ns <= start_ns) {
+        missed = div64_u64(start_ns - next_ns, period_ns) + 1;
+        next_ns += missed * period_ns;
+    }
+    
+    if (data->bus) {
+        data->conv_pending = false;
+        if (missed) {
+            unsigned long flags;
+            
+            spin_lock_irqsave(&data->stats_lock, flags);
+            data->bus_skipped += missed;
+            spin_unlock_irqrestore(&data->stats_lock, flags);
+        }
+    }
+    return next_ns;
 }
 
-/* =============================================================================
- * TEMPERATURE SIMULATION FUNCTIONS
- * ============================================================================= */
-
-__s32
-nxp_simtemp_generate_temp(
-    struct nxp_simtemp_data *data)
-/**
- * @brief Generate a temperature sample based on the current simulation mode
+/**********************************************************************************/
+enum hrtimer_restart
+nxp_simtemp_wheel_callback(
+    struct hrtimer *timer)
+/**
+ * @brief High-resolution timer callback driving the timer wheel
+ * 
+ * The wheel has SIMTEMP_WHEEL_LEVELS levels of SIMTEMP_WHEEL_SLOTS slots.
+ * Level 0 slots are one tick (SIMTEMP_WHEEL_TICK_NS) wide and each level
+ * up is SIMTEMP_WHEEL_SLOTS times coarser. A device is queued in the level
+ * whose range covers its expiry. When the wheel reaches the start of an
+ * upper-level slot, the slot's devices cascade down, so each device is
+ * touched at most once per level per period.
+ * 
+ * This callback walks the wheel from the last processed tick to now, but
+ * only stops at ticks where something happens. Those ticks are found from
+ * per-level occupancy bitmaps, so empty ticks cost nothing. At each stop
+ * it cascades the upper slots that start there and runs every device due.
+ * Each run returns the device's next expiry, which is queued again. The
+ * work is proportional to the devices due, not to the number of devices.
+ * 
+ * Readers of the aggregate node are woken once at the end of the pass.
+ * 
+ * The hrtimer is then set to the next tick with work and the callback
+ * returns HRTIMER_NORESTART. Re-arming always goes through hrtimer_start()
+ * under the wheel lock, so it is safe against devices being queued from
+ * process context at the same time.
+ * 
+ * @param timer Pointer to the wheel's high-resolution timer
+ * @return HRTIMER_NORESTART (re-armed with hrtimer_start())
+ **********************************************************************************/
+{
+    struct simtemp_wheel *wheel = container_of(timer, struct simtemp_wheel, timer);
+    struct simtemp_channel *chan;
+    struct nxp_simtemp_data *data;
+    unsigned long flags;
+    u64 now_tick;
+    u64 next;
+    
+    spin_lock_irqsave(&wheel->lock, flags);
+    wheel->armed_tick = U64_MAX;
+    now_tick = div_u64(ktime_get_ns(), SIMTEMP_WHEEL_TICK_NS);
+    
+    for (;;) {
+        next = nxp_simtemp_wheel_next_tick(wheel);
+        if (next > now_tick) {
+            break;
+        }
+        if (next > wheel->now_tick) {
+            nxp_simtemp_wheel_advance(wheel, next);
+        }
+        
+        /* Run everything due; a bus conversion may come straight back here */
+        while (!hlist_empty(&wheel->due)) {
+            chan = hlist_entry(wheel->due.first, struct simtemp_channel, node);
+            nxp_simtemp_wheel_remove(wheel, chan);
+            data = container_of(chan, struct nxp_simtemp_data, channel);
+            chan->expires_ns = nxp_simtemp_channel_expire(data, chan->expires_ns);
+            nxp_simtemp_wheel_insert(wheel, chan);
+        }
+    }
+    
+    /* One wake-up for the aggregate readers, however many instances ran */
+    if (simtemp_agg.pending) {
+        simtemp_agg.pending = false;
+        wake_up_interruptible(&simtemp_agg.wait);
+    }
+    
+    nxp_simtemp_wheel_arm(wheel);
+    spin_unlock_irqrestore(&wheel->lock, flags);
+    
+    return HRTIMER_NORESTART;
+}
+
+/* =============================================================================
+ * TEMPERATURE SIMULATION FUNCTIONS
+ * ============================================================================= */
+
+__s32
+nxp_simtemp_generate_temp(
+    struct nxp_simtemp_data *data)
+/**
+ * @brief Generate a temperature sample based on the current simulation mode
  * 
  * This function generates temperature samples according to the configured
  * simulation mode. It supports three modes:
@@ -690,33 +1573,51 @@ nxp_simtemp_generate_temp(
 int
 nxp_simtemp_add_sample(
     struct nxp_simtemp_data *data,
-    __s32 temp_mC)
+    __s32 temp_mC,
+    u64 timestamp_ns)
 /**
  * @brief Add a temperature sample to the ring buffer
  * 
  * This function adds a new temperature sample to the ring buffer with proper
  * timestamp and threshold crossing detection. It performs the following:
- * - Creates a sample with current timestamp and temperature
+ * - Creates a sample with the given timestamp and temperature
  * - Detects threshold crossing by comparing with previous temperature
- * - Adds the sample to the ring buffer (overwrites oldest if full)
+ * - Assigns the next sequence number, so overwritten samples show up as
+ *   gaps in the sequence seen by readers
+ * - Tags the sample with the configuration generation and flags the first
+ *   sample produced after a configuration change
+ * - Flags samples produced while the CPU budget governor is degrading
+ * - Records the shared bus queueing delay of the conversion, if any
+ * - Adds the sample to the ring buffer (overwrites oldest if full, counting
+ *   the overwritten sample) and updates the occupancy telemetry
  * - Updates alert statistics if threshold was crossed
- * - Wakes up any waiting readers
+ * - Queues a tagged copy for every open aggregate file selecting this
+ *   instance (the wheel callback wakes their readers once per pass)
  * 
  * The function is thread-safe and uses spinlock protection for buffer access.
  * 
  * @param data Pointer to the driver data structure
  * @param temp_mC Temperature in milli-degrees Celsius
+ * @param timestamp_ns Monotonic time the sample stands for
  * @return 0 on success (always succeeds)
  **********************************************************************************/
 {
-    struct simtemp_sample sample;
+    struct simtemp_sample_ext sample;
     unsigned long flags;
     bool threshold_crossed = false;
     
     /* Prepare sample */
-    sample.timestamp_ns = ktime_get_ns();
+    memset(&sample, 0, sizeof(sample));
+    sample.timestamp_ns = timestamp_ns;
     sample.temp_mC = temp_mC;
     sample.flags = 0x01;  /* NEW_SAMPLE bit */
+    if (READ_ONCE(data->gov_level)) {
+        sample.flags |= SIMTEMP_FLAG_DEGRADED;
+    }
+    if (data->bus) {
+        sample.queue_delay_us = (__u32)min_t(u64, U32_MAX,
+            div_u64(data->conv_start_ns - data->conv_request_ns, NSEC_PER_USEC));
+    }
     
     /* Check for threshold crossing */
     if ((temp_mC > data->threshold_mC) != (data->last_temp_mC > data->threshold_mC)) {
@@ -727,6 +1628,20 @@ nxp_simtemp_add_sample(
     
     spin_lock_irqsave(&data->buffer.lock, flags);
     
+    sample.seq = ++data->buffer.next_seq;
+    
+    /*
+     * Mark the first sample produced under a new configuration. Pairs with
+     * the smp_wmb() in nxp_simtemp_config_bump(): a sample generated from
+     * a new value also sees the generation bumped after it.
+     */
+    smp_rmb();
+    sample.config_gen = READ_ONCE(data->config_gen);
+    if (sample.config_gen != data->sample_gen) {
+        sample.flags |= SIMTEMP_FLAG_CONFIG_CHANGED;
+        data->sample_gen = sample.config_gen;
+    }
+    
     /* Add to ring buffer */
     data->buffer.samples[data->buffer.head] = sample;
     data->buffer.head = (data->buffer.head + 1) % SIMTEMP_BUFFER_SIZE;
@@ -736,7 +1651,12 @@ nxp_simtemp_add_sample(
     } else {
         /* Buffer full, advance tail */
         data->buffer.tail = (data->buffer.tail + 1) % SIMTEMP_BUFFER_SIZE;
+        data->buffer.occ.overwritten++;
     }
+    nxp_simtemp_ring_account(&data->buffer.occ, data->buffer.count, SIMTEMP_BUFFER_SIZE);
+    
+    /* Evaluate the per-file thresholds on every sample */
+    nxp_simtemp_reader_evaluate(&data->buffer, &sample);
     
     if (threshold_crossed) {
         data->alert_count++;
@@ -744,6 +1664,11 @@ nxp_simtemp_add_sample(
     
     spin_unlock_irqrestore(&data->buffer.lock, flags);
     
+    /* Copy into the aggregate files, if any are open */
+    if (READ_ONCE(simtemp_agg.reader_count)) {
+        nxp_simtemp_agg_push(data->id, &sample);
+    }
+    
     return 0;
 }
 
@@ -751,7 +1676,7 @@ nxp_simtemp_add_sample(
 int
 nxp_simtemp_get_sample(
     struct nxp_simtemp_data *data,
-    struct simtemp_sample *sample)
+    struct simtemp_sample_ext *sample)
 /**
  * @brief Retrieve a temperature sample from the ring buffer
  * 
@@ -776,6 +1701,7 @@ nxp_simtemp_get_sample(
         *sample = data->buffer.samples[data->buffer.tail];
         data->buffer.tail = (data->buffer.tail + 1) % SIMTEMP_BUFFER_SIZE;
         data->buffer.count--;
+        nxp_simtemp_ring_account(&data->buffer.occ, data->buffer.count, SIMTEMP_BUFFER_SIZE);
         ret = 0;
     }
     
@@ -820,8 +1746,11 @@ sampling_ms_store(
  * @brief Set the sampling period via sysfs
  * 
  * This function allows changing the temperature sampling period through sysfs.
- * It validates the input value (1-10000 ms range) and updates the high-resolution
- * timer accordingly. The timer is restarted with the new period immediately.
+ * It validates the input value (1-10000 ms range) and requeues the device on the
+ * timer wheel, so the new period applies from now.
+ * 
+ * The change bumps the configuration generation and notifies pollers of
+ * this attribute and of config_gen (sysfs_notify).
  * 
  * The function is thread-safe and uses mutex protection for configuration changes.
  * 
@@ -849,14 +1778,17 @@ sampling_ms_store(
     
     mutex_lock(&data->config_mutex);
     data->sampling_ms = val;
-    data->period = ktime_set(0, val * 1000000);
+    data->period = ms_to_ktime(val);
+    nxp_simtemp_config_bump(data);
     
-    /* Restart timer with new period */
-    hrtimer_cancel(&data->timer);
-    hrtimer_start(&data->timer, data->period, HRTIMER_MODE_REL);
+    /* Requeue with the new period; a queued conversion is abandoned */
+    nxp_simtemp_channel_stop(data);
+    nxp_simtemp_bus_cancel(data);
+    nxp_simtemp_channel_start(data, ktime_get_ns() + ktime_to_ns(nxp_simtemp_timer_period(data)));
     
     mutex_unlock(&data->config_mutex);
     
+    nxp_simtemp_config_notify(data, "sampling_ms");
     return count;
 }
 
@@ -896,6 +1828,9 @@ threshold_mC_store(
  * The threshold is used to detect temperature crossing events and trigger
  * alerts. The value is stored in milli-degrees Celsius.
  * 
+ * The change bumps the configuration generation and notifies pollers of
+ * this attribute and of config_gen (sysfs_notify).
+ * 
  * The function is thread-safe and uses mutex protection for configuration changes.
  * 
  * @param dev Pointer to the device structure
@@ -917,8 +1852,10 @@ threshold_mC_store(
     
     mutex_lock(&data->config_mutex);
     data->threshold_mC = val;
+    nxp_simtemp_config_bump(data);
     mutex_unlock(&data->config_mutex);
     
+    nxp_simtemp_config_notify(data, "threshold_mC");
     return count;
 }
 
@@ -977,6 +1914,9 @@ mode_store(
  * threshold position relative to the base temperature to ensure threshold
  * crossing occurs quickly.
  * 
+ * The change bumps the configuration generation and notifies pollers of
+ * this attribute and of config_gen (sysfs_notify).
+ * 
  * The function is thread-safe and uses mutex protection for configuration
  * changes.
  * 
@@ -1016,9 +1956,11 @@ mode_store(
     }
     
     data->mode = mode;
+    nxp_simtemp_config_bump(data);
     pr_info("NXP SimTemp: Mode set to %d\n", mode);
     mutex_unlock(&data->config_mutex);
     
+    nxp_simtemp_config_notify(data, "mode");
     return count;
 }
 
@@ -1037,6 +1979,8 @@ stats_show(
  * - Number of threshold crossing alerts
  * - Number of errors encountered
  * - Last error code
+ * - CPU budget governor state: level, batch factor, rate divider, callback
+ *   time in the last second (us) and number of step-ups
  * 
  * The function is thread-safe and uses spinlock protection for statistics access.
  * 
@@ -1049,6 +1993,8 @@ stats_show(
     struct nxp_simtemp_data *data = nxp_simtemp_get_data(dev);
     unsigned long flags;
     unsigned long updates, alerts, errors;
+    unsigned long cb_us, throttles;
+    unsigned int level, batch, rate_div;
     __s32 last_error;
     
     spin_lock_irqsave(&data->stats_lock, flags);
@@ -1056,10 +2002,231 @@ stats_show(
     alerts = data->alert_count;
     errors = data->error_count;
     last_error = data->last_error;
+    level = data->gov_level;
+    batch = data->batch;
+    rate_div = data->rate_div;
+    cb_us = data->cb_us;
+    throttles = data->throttle_count;
+    spin_unlock_irqrestore(&data->stats_lock, flags);
+    
+    return sprintf(buf, "updates=%lu alerts=%lu errors=%lu last_error=%d "
+                   "gov_level=%u batch=%u rate_div=%u cb_us=%lu throttles=%lu\n",
+                   updates, alerts, errors, last_error,
+                   level, batch, rate_div, cb_us, throttles);
+}
+
+/**********************************************************************************/
+ssize_t
+config_gen_show(
+    struct device *dev,
+    struct device_attribute *attr,
+    char *buf)
+/**
+ * @brief Show the configuration generation via sysfs
+ * 
+ * The generation starts at 0 and is incremented on every successful write to
+ * sampling_ms, threshold_mC or mode. User space can poll() this attribute
+ * for POLLPRI to learn about configuration changes without rereading every
+ * attribute, and match it against the config_gen field of extended records.
+ * 
+ * @param dev Pointer to the device structure
+ * @param attr Pointer to the device attribute structure
+ * @param buf Buffer to write the generation string
+ * @return Number of characters written to the buffer
+ **********************************************************************************/
+{
+    struct nxp_simtemp_data *data = nxp_simtemp_get_data(dev);
+    return sprintf(buf, "%u\n", READ_ONCE(data->config_gen));
+}
+
+/**********************************************************************************/
+ssize_t
+cpu_budget_us_show(
+    struct device *dev,
+    struct device_attribute *attr,
+    char *buf)
+/**
+ * @brief Show the timer callback CPU budget via sysfs
+ * 
+ * The budget is the callback time, in microseconds, the device may spend per
+ * second before the governor degrades it. 0 means unlimited.
+ * 
+ * @param dev Pointer to the device structure
+ * @param attr Pointer to the device attribute structure
+ * @param buf Buffer to write the budget string
+ * @return Number of characters written to the buffer
+ **********************************************************************************/
+{
+    struct nxp_simtemp_data *data = nxp_simtemp_get_data(dev);
+    return sprintf(buf, "%u\n", READ_ONCE(data->cpu_budget_us));
+}
+
+/**********************************************************************************/
+ssize_t
+cpu_budget_us_store(
+    struct device *dev,
+    struct device_attribute *attr,
+    const char *buf,
+    size_t count)
+/**
+ * @brief Set the timer callback CPU budget via sysfs
+ * 
+ * The new budget applies from the next accounting window. Writing 0 disables
+ * the governor and returns the device to full rate at the next expiry. The
+ * budget guards the host rather than shaping the stream, so the
+ * configuration generation is not bumped.
+ * 
+ * @param dev Pointer to the device structure
+ * @param attr Pointer to the device attribute structure
+ * @param buf Buffer containing the budget in us per second (0-1000000)
+ * @param count Number of characters in the buffer
+ * @return Number of characters processed on success, negative error code on failure:
+ *         -EINVAL: Value above one second per second
+ *         -ERANGE: Conversion error
+ **********************************************************************************/
+{
+    struct nxp_simtemp_data *data = nxp_simtemp_get_data(dev);
+    unsigned long flags;
+    unsigned int val;
+    int ret;
+    
+    ret = kstrtouint(buf, 10, &val);
+    if (ret) {
+        return ret;
+    }
+    
+    if (val > USEC_PER_SEC) {
+        return -EINVAL;
+    }
+    
+    spin_lock_irqsave(&data->stats_lock, flags);
+    data->cpu_budget_us = val;
+    data->calm_windows = 0;
+    if (val == 0 && data->gov_level) {
+        data->gov_level = 0;
+        nxp_simtemp_governor_apply(data);
+    }
+    spin_unlock_irqrestore(&data->stats_lock, flags);
+    
+    return count;
+}
+
+/**********************************************************************************/
+ssize_t
+bus_show(
+    struct device *dev,
+    struct device_attribute *attr,
+    char *buf)
+/**
+ * @brief Show the shared bus model state via sysfs
+ * 
+ * Prints "none" for an instance with its own bus. Otherwise prints the bus
+ * id, the conversion time, and this instance's conversion count, mean and
+ * maximum queueing delay (us) and request slots skipped while the bus was
+ * busy.
+ * 
+ * @param dev Pointer to the device structure
+ * @param attr Pointer to the device attribute structure
+ * @param buf Buffer to write the bus state string
+ * @return Number of characters written to the buffer
+ **********************************************************************************/
+{
+    struct nxp_simtemp_data *data = nxp_simtemp_get_data(dev);
+    unsigned long flags;
+    unsigned long conversions, skipped;
+    u64 wait_total_ns, wait_max_ns;
+    
+    if (!data->bus) {
+        return sprintf(buf, "none\n");
+    }
+    
+    spin_lock_irqsave(&data->stats_lock, flags);
+    conversions = data->bus_conversions;
+    wait_total_ns = data->bus_wait_total_ns;
+    wait_max_ns = data->bus_wait_max_ns;
+    skipped = data->bus_skipped;
     spin_unlock_irqrestore(&data->stats_lock, flags);
     
-    return sprintf(buf, "updates=%lu alerts=%lu errors=%lu last_error=%d\n",
-                   updates, alerts, errors, last_error);
+    return sprintf(buf, "bus=%d conversion_us=%u conversions=%lu wait_avg_us=%llu "
+                   "wait_max_us=%llu skipped=%lu\n",
+                   data->bus_id, data->conversion_us, conversions,
+                   conversions ? div64_u64(wait_total_ns, (u64)conversions * NSEC_PER_USEC) : 0,
+                   div_u64(wait_max_ns, NSEC_PER_USEC), skipped);
+}
+
+/**********************************************************************************/
+ssize_t
+ring_show(
+    struct device *dev,
+    struct device_attribute *attr,
+    char *buf)
+/**
+ * @brief Show the ring buffer occupancy via sysfs
+ * 
+ * Prints the samples queued now, the ring capacity, the high-watermark, the
+ * time (ms) the ring spent at least 75% full and the samples overwritten
+ * because it was full. Everything but the depth counts from the last reset.
+ * 
+ * @param dev Pointer to the device structure
+ * @param attr Pointer to the device attribute structure
+ * @param buf Buffer to write the occupancy string
+ * @return Number of characters written to the buffer
+ **********************************************************************************/
+{
+    struct nxp_simtemp_data *data = nxp_simtemp_get_data(dev);
+    struct simtemp_ring_stats ring;
+    unsigned long flags;
+    
+    spin_lock_irqsave(&data->buffer.lock, flags);
+    nxp_simtemp_ring_snapshot(&data->buffer.occ, data->buffer.count, SIMTEMP_BUFFER_SIZE, &ring);
+    spin_unlock_irqrestore(&data->buffer.lock, flags);
+    
+    return sprintf(buf, "depth=%u capacity=%u high_watermark=%u high_ms=%llu overwritten=%llu\n",
+                   ring.depth, ring.capacity, ring.high_watermark,
+                   div_u64(ring.high_ns, NSEC_PER_MSEC), ring.overwritten);
+}
+
+/**********************************************************************************/
+ssize_t
+ring_store(
+    struct device *dev,
+    struct device_attribute *attr,
+    const char *buf,
+    size_t count)
+/**
+ * @brief Reset the ring buffer occupancy counters via sysfs
+ * 
+ * Writing 0 restarts the high-watermark from the current depth and clears
+ * the time at 75% and the overwritten count (same as SIMTEMP_IOC_RESET_RING).
+ * 
+ * @param dev Pointer to the device structure
+ * @param attr Pointer to the device attribute structure
+ * @param buf Buffer containing "0"
+ * @param count Number of characters in the buffer
+ * @return Number of characters processed on success, negative error code on failure:
+ *         -EINVAL: Any value other than 0
+ *         -ERANGE: Conversion error
+ **********************************************************************************/
+{
+    struct nxp_simtemp_data *data = nxp_simtemp_get_data(dev);
+    unsigned long flags;
+    unsigned int val;
+    int ret;
+    
+    ret = kstrtouint(buf, 10, &val);
+    if (ret) {
+        return ret;
+    }
+    
+    if (val != 0) {
+        return -EINVAL;
+    }
+    
+    spin_lock_irqsave(&data->buffer.lock, flags);
+    nxp_simtemp_ring_reset(&data->buffer.occ, data->buffer.count, SIMTEMP_BUFFER_SIZE);
+    spin_unlock_irqrestore(&data->buffer.lock, flags);
+    
+    return count;
 }
 
 /**********************************************************************************/
@@ -1071,13 +2238,17 @@ nxp_simtemp_create_sysfs(
  * 
  * This function creates the sysfs interface for the temperature sensor device.
  * It performs the following operations:
- * - Creates a device class for sysfs organization
- * - Creates a device instance in the class
+ * - Creates a device instance, named after the instance, in the driver's
+ *   class (created once at module load)
  * - Creates individual sysfs attributes for:
  *   - sampling_ms: Temperature sampling period
  *   - threshold_mC: Temperature threshold
  *   - mode: Simulation mode
  *   - stats: Device statistics
+ *   - config_gen: Configuration generation (pollable)
+ *   - cpu_budget_us: Timer callback CPU budget
+ *   - bus: Shared bus model state
+ *   - ring: Ring buffer occupancy (write 0 to reset)
  * 
  * The function implements proper error handling with cleanup on failure.
  * 
@@ -1087,21 +2258,15 @@ nxp_simtemp_create_sysfs(
 {
     int ret;
     
-    /* Create device class */
-    data->class = class_create(CLASS_NAME);
-    if (IS_ERR(data->class)) {
-        ret = PTR_ERR(data->class);
-        pr_err("Failed to create device class: %d\n", ret);
-        return ret;
-    }
-    
     /* Create device */
+    data->class = simtemp_class;
     data->devt = MKDEV(MAJOR(data->miscdev.minor), data->miscdev.minor);
-    data->dev = device_create(data->class, NULL, data->devt, data, DEVICE_NAME);
+    data->dev = device_create(data->class, NULL, data->devt, data, "%s", data->name);
     if (IS_ERR(data->dev)) {
         ret = PTR_ERR(data->dev);
         pr_err("Failed to create device: %d\n", ret);
-        goto cleanup_class;
+        data->dev = NULL;
+        return ret;
     }
     
     /* Create sysfs attributes */
@@ -1129,9 +2294,41 @@ nxp_simtemp_create_sysfs(
         goto cleanup_mode;
     }
     
+    ret = device_create_file(data->dev, &dev_attr_config_gen);
+    if (ret) {
+        pr_err("Failed to create config_gen attribute: %d\n", ret);
+        goto cleanup_stats;
+    }
+    
+    ret = device_create_file(data->dev, &dev_attr_cpu_budget_us);
+    if (ret) {
+        pr_err("Failed to create cpu_budget_us attribute: %d\n", ret);
+        goto cleanup_config_gen;
+    }
+    
+    ret = device_create_file(data->dev, &dev_attr_bus);
+    if (ret) {
+        pr_err("Failed to create bus attribute: %d\n", ret);
+        goto cleanup_cpu_budget_us;
+    }
+    
+    ret = device_create_file(data->dev, &dev_attr_ring);
+    if (ret) {
+        pr_err("Failed to create ring attribute: %d\n", ret);
+        goto cleanup_bus;
+    }
+    
     pr_info("NXP SimTemp: Sysfs attributes created successfully\n");
     return 0;
     
+cleanup_bus:
+    device_remove_file(data->dev, &dev_attr_bus);
+cleanup_cpu_budget_us:
+    device_remove_file(data->dev, &dev_attr_cpu_budget_us);
+cleanup_config_gen:
+    device_remove_file(data->dev, &dev_attr_config_gen);
+cleanup_stats:
+    device_remove_file(data->dev, &dev_attr_stats);
 cleanup_mode:
     device_remove_file(data->dev, &dev_attr_mode);
 cleanup_threshold_mC:
@@ -1140,8 +2337,7 @@ cleanup_sampling_ms:
     device_remove_file(data->dev, &dev_attr_sampling_ms);
 cleanup_device:
     device_destroy(data->class, data->devt);
-cleanup_class:
-    class_destroy(data->class);
+    data->dev = NULL;
     return ret;
 }
 
@@ -1156,7 +2352,8 @@ nxp_simtemp_remove_sysfs(
  * It performs cleanup in reverse order of creation:
  * - Removes all device attributes
  * - Destroys the device instance
- * - Destroys the device class
+ * 
+ * The class is shared by all instances and destroyed at module unload.
  * 
  * The function is safe to call even if some resources were not created.
  * 
@@ -1164,15 +2361,16 @@ nxp_simtemp_remove_sysfs(
  **********************************************************************************/
 {
     if (data->dev) {
+        device_remove_file(data->dev, &dev_attr_ring);
+        device_remove_file(data->dev, &dev_attr_bus);
+        device_remove_file(data->dev, &dev_attr_cpu_budget_us);
+        device_remove_file(data->dev, &dev_attr_config_gen);
         device_remove_file(data->dev, &dev_attr_stats);
         device_remove_file(data->dev, &dev_attr_mode);
         device_remove_file(data->dev, &dev_attr_threshold_mC);
         device_remove_file(data->dev, &dev_attr_sampling_ms);
         device_destroy(data->class, data->devt);
-    }
-    
-    if (data->class) {
-        class_destroy(data->class);
+        data->dev = NULL;
     }
     
     pr_info("NXP SimTemp: Sysfs attributes removed\n");
@@ -1184,32 +2382,73 @@ nxp_simtemp_remove_sysfs(
 
 static int __init nxp_simtemp_init(void)
 {
+    struct platform_device *pdev;
+    unsigned int i;
     int ret;
     
     pr_info("NXP Simulated Temperature Driver: Initializing\n");
     
+    if (test_count > SIMTEMP_MAX_TEST_DEVICES) {
+        pr_warn("count=%u too large, creating %d test devices\n", test_count, SIMTEMP_MAX_TEST_DEVICES);
+        test_count = SIMTEMP_MAX_TEST_DEVICES;
+    }
+    
+    /* One timer wheel for all instances */
+    spin_lock_init(&simtemp_wheel.lock);
+    hrtimer_init(&simtemp_wheel.timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+    simtemp_wheel.timer.function = nxp_simtemp_wheel_callback;
+    simtemp_wheel.now_tick = div_u64(ktime_get_ns(), SIMTEMP_WHEEL_TICK_NS);
+    simtemp_wheel.armed_tick = U64_MAX;
+    
+    spin_lock_init(&simtemp_agg.lock);
+    INIT_LIST_HEAD(&simtemp_agg.readers);
+    init_waitqueue_head(&simtemp_agg.wait);
+    
+    /* One class for all instances */
+    simtemp_class = class_create(CLASS_NAME);
+    if (IS_ERR(simtemp_class)) {
+        ret = PTR_ERR(simtemp_class);
+        nxp_simtemp_log_error("create device class", ret);
+        return ret;
+    }
+    
     ret = platform_driver_register(&nxp_simtemp_driver);
     if (ret) {
         nxp_simtemp_log_error("register platform driver", ret);
+        class_destroy(simtemp_class);
         return ret;
     }
     
-    /* Create a test platform device if no device tree binding exists */
-    test_device = platform_device_alloc("nxp_simtemp", -1);
-    if (!test_device) {
-        pr_warn("Failed to allocate test platform device\n");
-        /* Continue anyway - driver might be bound via device tree */
-    } else {
-        ret = platform_device_add(test_device);
+    /* The aggregate node is optional; instances work without it */
+    if (aggregate) {
+        ret = misc_register(&nxp_simtemp_agg_miscdev);
         if (ret) {
-            pr_warn("Failed to add test platform device: %d\n", ret);
-            platform_device_put(test_device);
-            test_device = NULL;
+            pr_warn("Failed to register /dev/%s: %d\n", nxp_simtemp_agg_miscdev.name, ret);
         } else {
-            pr_info("Test platform device created successfully\n");
+            simtemp_agg.registered = true;
         }
     }
     
+    /* Create test platform devices if no device tree binding exists */
+    for (i = 0; i < test_count; i++) {
+        pdev = platform_device_alloc("nxp_simtemp", test_count == 1 ? -1 : (int)i);
+        if (!pdev) {
+            pr_warn("Failed to allocate test platform device %u\n", i);
+            /* Continue anyway - driver might be bound via device tree */
+            break;
+        }
+        ret = platform_device_add(pdev);
+        if (ret) {
+            pr_warn("Failed to add test platform device %u: %d\n", i, ret);
+            platform_device_put(pdev);
+            break;
+        }
+        test_devices[i] = pdev;
+    }
+    if (i > 0) {
+        pr_info("%u test platform device(s) created successfully\n", i);
+    }
+    
     pr_info("NXP Simulated Temperature Driver: Registered successfully\n");
     return 0;
 }
@@ -1217,17 +2456,24 @@ static int __init nxp_simtemp_init(void)
 /**********************************************************************************/
 static void __exit nxp_simtemp_exit(void)
 {
+    unsigned int i;
+    
     pr_info("NXP Simulated Temperature Driver: Unregistering\n");
     
-    /* Clean up test device if it was created */
-    if (test_device) {
-        platform_device_del(test_device);
-        platform_device_put(test_device);
-        test_device = NULL;
-        pr_info("Test platform device removed\n");
+    /* Clean up test devices that were created */
+    for (i = 0; i < SIMTEMP_MAX_TEST_DEVICES; i++) {
+        if (test_devices[i]) {
+            platform_device_unregister(test_devices[i]);
+            test_devices[i] = NULL;
+        }
     }
     
     platform_driver_unregister(&nxp_simtemp_driver);
+    if (simtemp_agg.registered) {
+        misc_deregister(&nxp_simtemp_agg_miscdev);
+    }
+    hrtimer_cancel(&simtemp_wheel.timer);
+    class_destroy(simtemp_class);
     pr_info("NXP Simulated Temperature Driver: Unregistered\n");
 }
 
@@ -1311,4 +2557,811 @@ MODULE_VERSION("1.0");
  {
      pr_err("Failed to %s: %d\n", action, error);
  }
- 
\ No newline at end of file
+ 
+ 
+ /**
+  * @brief Copy one sample to user space in the reader's record format
+  * 
+  * @param reader Pointer to the per-open reader state
+  * @param buf User space destination
+  * @param sample Sample to copy
+  * @return 0 on success, -EFAULT on copy failure
+  */
+ static int
+ nxp_simtemp_copy_record(
+     struct simtemp_reader *reader,
+     char __user *buf,
+     const struct simtemp_sample_ext *sample)
+ {
+     struct simtemp_sample basic;
+     
+     if (reader->format == SIMTEMP_FORMAT_EXTENDED) {
+         return copy_to_user(buf, sample, sizeof(*sample)) ? -EFAULT : 0;
+     }
+     
+     basic.timestamp_ns = sample->timestamp_ns;
+     basic.temp_mC = sample->temp_mC;
+     basic.flags = sample->flags;
+     return copy_to_user(buf, &basic, sizeof(basic)) ? -EFAULT : 0;
+ }
+ 
+ 
+ /**
+  * @brief Record a configuration change
+  * 
+  * Bumps the configuration generation, picked up by the next sample. Called
+  * with config_mutex held, in the section that stores the new values and
+  * after them, so no sample can run under the new configuration with the
+  * old generation.
+  * 
+  * @param data Pointer to the driver data structure
+  */
+ static void
+ nxp_simtemp_config_bump(
+     struct nxp_simtemp_data *data)
+ {
+     lockdep_assert_held(&data->config_mutex);
+     
+     /* New values before the new generation; pairs with add_sample */
+     smp_wmb();
+     WRITE_ONCE(data->config_gen, data->config_gen + 1);
+ }
+ 
+ 
+ /**
+  * @brief Notify sysfs pollers of a configuration change
+  * 
+  * Wakes poll()/select() waiters on the changed attribute and on config_gen
+  * with POLLPRI | POLLERR. Called after config_mutex is released, once
+  * nxp_simtemp_config_bump() has recorded the change.
+  * 
+  * @param data Pointer to the driver data structure
+  * @param attr_name Name of the attribute that changed
+  */
+ static void
+ nxp_simtemp_config_notify(
+     struct nxp_simtemp_data *data,
+     const char *attr_name)
+ {
+     if (data->dev) {
+         sysfs_notify(&data->dev->kobj, NULL, attr_name);
+         sysfs_notify(&data->dev->kobj, NULL, "config_gen");
+     }
+ }
+ 
+ 
+ /**
+  * @brief Timer interval for the current governor level
+  * 
+  * @param data Pointer to the driver data structure
+  * @return Sampling period times batch factor times rate divider
+  */
+ static ktime_t
+ nxp_simtemp_timer_period(
+     struct nxp_simtemp_data *data)
+ {
+     return ns_to_ktime(ktime_to_ns(data->period) *
+                        READ_ONCE(data->batch) * READ_ONCE(data->rate_div));
+ }
+ 
+ 
+ /**
+  * @brief Set batch factor and rate divider for the governor level
+  * 
+  * Levels 1-3 first batch 2, 4 and 8 samples per timer expiry (same sample
+  * rate, fewer callbacks and wakeups); levels 4-6 then keep the batch of 8
+  * and divide the sample rate by 2, 4 and 8. Called with stats_lock held;
+  * the new interval takes effect at the next expiry.
+  * 
+  * @param data Pointer to the driver data structure
+  */
+ static void
+ nxp_simtemp_governor_apply(
+     struct nxp_simtemp_data *data)
+ {
+     unsigned int level = data->gov_level;
+     
+     WRITE_ONCE(data->batch, 1U << min(level, 3U));
+     WRITE_ONCE(data->rate_div, level > 3 ? 1U << (level - 3) : 1U);
+ }
+ 
+ 
+ /**
+  * @brief Charge one callback run to the CPU budget and adjust the level
+  * 
+  * Callback time is summed over windows of about one second. A window that
+  * used more than cpu_budget_us (scaled to one second) raises the level one
+  * step; SIMTEMP_GOV_CALM_WINDOWS consecutive windows under half the budget
+  * lower it one step, so the device returns to its configured rate once the
+  * load subsides without oscillating around the budget.
+  * 
+  * @param data Pointer to the driver data structure
+  * @param start_ns Callback entry time
+  * @param end_ns Callback exit time
+  */
+ static void
+ nxp_simtemp_governor_account(
+     struct nxp_simtemp_data *data,
+     u64 start_ns,
+     u64 end_ns)
+ {
+     unsigned long flags;
+     unsigned int old_level, new_level, budget;
+     u64 elapsed_ns;
+     u64 used_us;
+     
+     spin_lock_irqsave(&data->stats_lock, flags);
+     
+     data->window_busy_ns += end_ns - start_ns;
+     elapsed_ns = end_ns - data->window_start_ns;
+     if (elapsed_ns < SIMTEMP_GOV_WINDOW_NS) {
+         spin_unlock_irqrestore(&data->stats_lock, flags);
+         return;
+     }
+     
+     /* Callback time per second of wall time, in us */
+     used_us = div64_u64(data->window_busy_ns * USEC_PER_SEC, elapsed_ns);
+     data->cb_us = (unsigned long)used_us;
+     data->window_busy_ns = 0;
+     data->window_start_ns = end_ns;
+     
+     budget = data->cpu_budget_us;
+     old_level = data->gov_level;
+     if (budget == 0) {
+         data->gov_level = 0;
+         data->calm_windows = 0;
+     } else if (used_us > budget) {
+         data->calm_windows = 0;
+         if (data->gov_level < SIMTEMP_GOV_MAX_LEVEL) {
+             data->gov_level++;
+             data->throttle_count++;
+         }
+     } else if (data->gov_level && used_us < budget / 2) {
+         if (++data->calm_windows >= SIMTEMP_GOV_CALM_WINDOWS) {
+             data->gov_level--;
+             data->calm_windows = 0;
+         }
+     } else {
+         data->calm_windows = 0;
+     }
+     
+     new_level = data->gov_level;
+     if (new_level != old_level) {
+         nxp_simtemp_governor_apply(data);
+     }
+     
+     spin_unlock_irqrestore(&data->stats_lock, flags);
+     
+     if (new_level != old_level) {
+         pr_info("NXP SimTemp: CPU governor level %u -> %u (%llu us/s, budget %u us/s)\n",
+                 old_level, new_level, used_us, budget);
+     }
+ }
+ 
+ 
+ /**
+  * @brief Find or create the shared bus with the given id
+  * 
+  * @param id Bus id from the device tree or module parameter
+  * @return Referenced bus, NULL on allocation failure
+  */
+ static struct simtemp_bus *
+ nxp_simtemp_bus_get(
+     int id)
+ {
+     struct simtemp_bus *bus;
+     
+     mutex_lock(&simtemp_bus_mutex);
+     list_for_each_entry(bus, &simtemp_buses, node) {
+         if (bus->id == id) {
+             bus->users++;
+             goto out;
+         }
+     }
+     
+     bus = kzalloc(sizeof(*bus), GFP_KERNEL);
+     if (bus) {
+         bus->id = id;
+         bus->users = 1;
+         spin_lock_init(&bus->lock);
+         list_add(&bus->node, &simtemp_buses);
+     }
+ out:
+     mutex_unlock(&simtemp_bus_mutex);
+     return bus;
+ }
+ 
+ 
+ /**
+  * @brief Drop a reference to a shared bus, freeing it with the last user
+  * 
+  * @param bus Bus from nxp_simtemp_bus_get(), or NULL
+  */
+ static void
+ nxp_simtemp_bus_put(
+     struct simtemp_bus *bus)
+ {
+     if (!bus) {
+         return;
+     }
+     
+     mutex_lock(&simtemp_bus_mutex);
+     if (--bus->users == 0) {
+         list_del(&bus->node);
+         kfree(bus);
+     }
+     mutex_unlock(&simtemp_bus_mutex);
+ }
+ 
+ 
+ /**
+  * @brief Schedule one conversion on the instance's shared bus
+  * 
+  * The conversion starts at the later of now and the end of the last
+  * conversion already scheduled on the bus, and holds the bus for
+  * conversion_us per sample of the governor batch. Called from the channel
+  * expiry only.
+  * 
+  * @param data Pointer to the driver data structure
+  * @param now_ns Request time
+  */
+ static void
+ nxp_simtemp_bus_request(
+     struct nxp_simtemp_data *data,
+     u64 now_ns)
+ {
+     struct simtemp_bus *bus = data->bus;
+     unsigned long flags;
+     u64 start_ns;
+     u64 wait_ns;
+     
+     spin_lock_irqsave(&bus->lock, flags);
+     start_ns = max(now_ns, bus->busy_until_ns);
+     bus->busy_until_ns = start_ns +
+         (u64)data->conversion_us * NSEC_PER_USEC * READ_ONCE(data->batch);
+     data->conv_end_ns = bus->busy_until_ns;
+     spin_unlock_irqrestore(&bus->lock, flags);
+     
+     data->conv_request_ns = now_ns;
+     data->conv_start_ns = start_ns;
+     data->conv_pending = true;
+     
+     wait_ns = start_ns - now_ns;
+     spin_lock_irqsave(&data->stats_lock, flags);
+     data->bus_conversions++;
+     data->bus_wait_total_ns += wait_ns;
+     if (wait_ns > data->bus_wait_max_ns) {
+         data->bus_wait_max_ns = wait_ns;
+     }
+     spin_unlock_irqrestore(&data->stats_lock, flags);
+ }
+ 
+ 
+ /**
+  * @brief Abandon the instance's queued conversion, if any
+  * 
+  * Gives the bus time it reserved back when it is still the last
+  * conversion scheduled, so the other instances do not queue behind a
+  * conversion that never runs. A reservation followed by other
+  * conversions stays: those are already timed after it. Called with the
+  * channel stopped, so the expiry cannot complete the conversion
+  * concurrently.
+  * 
+  * @param data Pointer to the driver data structure
+  */
+ static void
+ nxp_simtemp_bus_cancel(
+     struct nxp_simtemp_data *data)
+ {
+     struct simtemp_bus *bus = data->bus;
+     unsigned long flags;
+     
+     if (!bus || !data->conv_pending) {
+         return;
+     }
+     
+     spin_lock_irqsave(&bus->lock, flags);
+     if (bus->busy_until_ns == data->conv_end_ns) {
+         bus->busy_until_ns = data->conv_start_ns;
+     }
+     spin_unlock_irqrestore(&bus->lock, flags);
+     
+     data->conv_pending = false;
+ }
+ 
+ 
+ /**
+  * @brief Advance a per-file crossing state by one sample
+  * 
+  * The state goes above when a sample exceeds the threshold and back below
+  * once a sample is at or under threshold - hysteresis; both transitions
+  * are crossings.
+  * 
+  * @param threshold Per-file threshold
+  * @param above Crossing state, updated
+  * @param temp_mC Sample temperature
+  * @return true if the sample is a crossing
+  */
+ static bool
+ nxp_simtemp_reader_crossed(
+     const struct simtemp_threshold *threshold,
+     bool *above,
+     __s32 temp_mC)
+ {
+     if (!*above && temp_mC > threshold->threshold_mC) {
+         *above = true;
+         return true;
+     }
+     if (*above && (s64)temp_mC <= (s64)threshold->threshold_mC - threshold->hysteresis_mC) {
+         *above = false;
+         return true;
+     }
+     return false;
+ }
+ 
+ 
+ /**
+  * @brief Latch the crossings of a sample for every per-file threshold
+  * 
+  * Called from the producer path with the buffer lock held, once per sample,
+  * so each file's crossing state follows the whole stream rather than the
+  * samples that file happens to read. A file with too many crossings pending
+  * loses its oldest one, counted in crossings_dropped.
+  * 
+  * @param buffer Device ring buffer (locked)
+  * @param sample Sample just stored in the ring
+  */
+ static void
+ nxp_simtemp_reader_evaluate(
+     struct simtemp_buffer *buffer,
+     const struct simtemp_sample_ext *sample)
+ {
+     struct simtemp_reader *reader;
+     struct simtemp_alert *alert;
+     
+     list_for_each_entry(reader, &buffer->readers, node) {
+         if (!nxp_simtemp_reader_crossed(&reader->threshold, &reader->above, sample->temp_mC)) {
+             continue;
+         }
+         if (reader->crossing_count == SIMTEMP_READER_CROSSINGS) {
+             reader->crossing_count--;
+             memmove(&reader->crossings[0], &reader->crossings[1],
+                     reader->crossing_count * sizeof(reader->crossings[0]));
+             reader->crossings_dropped++;
+         }
+         alert = &reader->crossings[reader->crossing_count++];
+         memset(alert, 0, sizeof(*alert));
+         alert->seq = sample->seq;
+         alert->timestamp_ns = sample->timestamp_ns;
+         alert->temp_mC = sample->temp_mC;
+     }
+ }
+ 
+ 
+ /**
+  * @brief Set THRESHOLD_CROSSED on a sample delivered to this file
+  * 
+  * The flag is set when the producer latched the sample as a crossing of
+  * this file's threshold; delivering it acknowledges the crossing. Older
+  * crossings, consumed by other files, stay pending.
+  * 
+  * @param reader Pointer to the per-open reader state
+  * @param sample Sample about to be copied out, flags updated in place
+  */
+ static void
+ nxp_simtemp_reader_deliver(
+     struct simtemp_reader *reader,
+     struct simtemp_sample_ext *sample)
+ {
+     struct simtemp_buffer *buffer = &reader->data->buffer;
+     unsigned long flags;
+     unsigned int i;
+     
+     spin_lock_irqsave(&buffer->lock, flags);
+     if (reader->threshold.enabled) {
+         sample->flags &= ~SIMTEMP_FLAG_THRESHOLD_CROSSED;
+         for (i = 0; i < reader->crossing_count; i++) {
+             if (reader->crossings[i].seq != sample->seq) {
+                 continue;
+             }
+             sample->flags |= SIMTEMP_FLAG_THRESHOLD_CROSSED;
+             reader->crossing_count--;
+             memmove(&reader->crossings[i], &reader->crossings[i + 1],
+                     (reader->crossing_count - i) * sizeof(reader->crossings[0]));
+             break;
+         }
+     }
+     spin_unlock_irqrestore(&buffer->lock, flags);
+ }
+ 
+ 
+ /**
+  * @brief Queue a tagged copy of a sample for the aggregate files
+  * 
+  * Called from the producer path (wheel lock held) after the sample went
+  * into the instance ring. Files that do not select the instance are
+  * skipped; a full ring overwrites its oldest record, as instance rings do.
+  * 
+  * @param id Instance number of the producer
+  * @param sample Sample as stored in the instance ring
+  */
+ static void
+ nxp_simtemp_agg_push(
+     int id,
+     const struct simtemp_sample_ext *sample)
+ {
+     struct simtemp_agg_reader *reader;
+     struct simtemp_sample_tagged *record;
+     unsigned long flags;
+     
+     spin_lock_irqsave(&simtemp_agg.lock, flags);
+     list_for_each_entry(reader, &simtemp_agg.readers, node) {
+         if (!reader->all && (id >= SIMTEMP_AGG_MAX_DEVICES || !test_bit(id, reader->select))) {
+             continue;
+         }
+         
+         record = &reader->samples[reader->head];
+         record->timestamp_ns = sample->timestamp_ns;
+         record->temp_mC = sample->temp_mC;
+         record->flags = sample->flags;
+         record->seq = sample->seq;
+         record->device_id = id;
+         record->config_gen = sample->config_gen;
+         reader->head = (reader->head + 1) % SIMTEMP_AGG_BUFFER_SIZE;
+         
+         if (reader->count < SIMTEMP_AGG_BUFFER_SIZE) {
+             reader->count++;
+         } else {
+             reader->tail = (reader->tail + 1) % SIMTEMP_AGG_BUFFER_SIZE;
+             reader->occ.overwritten++;
+         }
+         nxp_simtemp_ring_account(&reader->occ, reader->count, SIMTEMP_AGG_BUFFER_SIZE);
+         simtemp_agg.pending = true;
+     }
+     spin_unlock_irqrestore(&simtemp_agg.lock, flags);
+ }
+ 
+ 
+ /**
+  * @brief Take up to max records from an aggregate file's ring
+  * 
+  * @param reader Aggregate file state
+  * @param records Destination, oldest first
+  * @param max Capacity of records
+  * @return Number of records taken, 0 when the ring is empty
+  */
+ static unsigned int
+ nxp_simtemp_agg_take(
+     struct simtemp_agg_reader *reader,
+     struct simtemp_sample_tagged *records,
+     unsigned int max)
+ {
+     unsigned long flags;
+     unsigned int n = 0;
+     
+     spin_lock_irqsave(&simtemp_agg.lock, flags);
+     while (n < max && reader->count > 0) {
+         records[n++] = reader->samples[reader->tail];
+         reader->tail = (reader->tail + 1) % SIMTEMP_AGG_BUFFER_SIZE;
+         reader->count--;
+     }
+     if (n) {
+         nxp_simtemp_ring_account(&reader->occ, reader->count, SIMTEMP_AGG_BUFFER_SIZE);
+     }
+     spin_unlock_irqrestore(&simtemp_agg.lock, flags);
+     
+     return n;
+ }
+ 
+ 
+ /**
+  * @brief Update the occupancy telemetry after a ring count changed
+  * 
+  * Called with the ring's lock held from every producer and consumer step.
+  * The clock is only read when the count crosses 75% of the capacity.
+  * 
+  * @param occ Occupancy of the ring (locked)
+  * @param count Samples now in the ring
+  * @param capacity Ring size
+  */
+ static void
+ nxp_simtemp_ring_account(
+     struct simtemp_occupancy *occ,
+     unsigned int count,
+     unsigned int capacity)
+ {
+     u64 now_ns;
+     
+     if (count > occ->high_watermark) {
+         occ->high_watermark = count;
+     }
+     
+     if ((count >= capacity / 4 * 3) == (occ->high_since_ns != 0)) {
+         return;
+     }
+     now_ns = ktime_get_ns();
+     if (occ->high_since_ns) {
+         occ->high_total_ns += now_ns - occ->high_since_ns;
+         occ->high_since_ns = 0;
+     } else {
+         occ->high_since_ns = now_ns;
+     }
+ }
+ 
+ 
+ /**
+  * @brief Copy the occupancy telemetry, including a stretch still running
+  * 
+  * @param occ Occupancy of the ring (locked)
+  * @param count Samples now in the ring
+  * @param capacity Ring size
+  * @param stats Filled in; fill_level is left to the caller
+  */
+ static void
+ nxp_simtemp_ring_snapshot(
+     const struct simtemp_occupancy *occ,
+     unsigned int count,
+     unsigned int capacity,
+     struct simtemp_ring_stats *stats)
+ {
+     memset(stats, 0, sizeof(*stats));
+     stats->depth = count;
+     stats->capacity = capacity;
+     stats->high_watermark = occ->high_watermark;
+     stats->high_ns = occ->high_total_ns;
+     if (occ->high_since_ns) {
+         stats->high_ns += ktime_get_ns() - occ->high_since_ns;
+     }
+     stats->overwritten = occ->overwritten;
+ }
+ 
+ 
+ /**
+  * @brief Restart the occupancy telemetry from the current depth
+  * 
+  * @param occ Occupancy of the ring (locked)
+  * @param count Samples now in the ring
+  * @param capacity Ring size
+  */
+ static void
+ nxp_simtemp_ring_reset(
+     struct simtemp_occupancy *occ,
+     unsigned int count,
+     unsigned int capacity)
+ {
+     occ->high_watermark = count;
+     occ->high_total_ns = 0;
+     occ->high_since_ns = count >= capacity / 4 * 3 ? ktime_get_ns() : 0;
+     occ->overwritten = 0;
+ }
+ 
+ 
+ /**
+  * @brief Queue a device on the timer wheel
+  * 
+  * @param data Pointer to the driver data structure
+  * @param expires_ns First expiry (monotonic ns)
+  */
+ static void
+ nxp_simtemp_channel_start(
+     struct nxp_simtemp_data *data,
+     u64 expires_ns)
+ {
+     struct simtemp_wheel *wheel = &simtemp_wheel;
+     unsigned long flags;
+     unsigned int level;
+     bool empty;
+     
+     spin_lock_irqsave(&wheel->lock, flags);
+     
+     /* An idle wheel restarts from the current tick */
+     empty = hlist_empty(&wheel->due);
+     for (level = 0; level < SIMTEMP_WHEEL_LEVELS; level++) {
+         empty = empty && !wheel->occupied[level];
+     }
+     if (empty) {
+         wheel->now_tick = div_u64(ktime_get_ns(), SIMTEMP_WHEEL_TICK_NS);
+     }
+     
+     data->channel.expires_ns = expires_ns;
+     nxp_simtemp_wheel_insert(wheel, &data->channel);
+     nxp_simtemp_wheel_arm(wheel);
+     
+     spin_unlock_irqrestore(&wheel->lock, flags);
+ }
+ 
+ 
+ /**
+  * @brief Dequeue a device from the timer wheel
+  * 
+  * Channels run under the wheel lock, so on return the device's expiry
+  * function is neither running nor queued.
+  * 
+  * @param data Pointer to the driver data structure
+  */
+ static void
+ nxp_simtemp_channel_stop(
+     struct nxp_simtemp_data *data)
+ {
+     unsigned long flags;
+     
+     spin_lock_irqsave(&simtemp_wheel.lock, flags);
+     if (data->channel.level != SIMTEMP_WHEEL_IDLE) {
+         nxp_simtemp_wheel_remove(&simtemp_wheel, &data->channel);
+     }
+     spin_unlock_irqrestore(&simtemp_wheel.lock, flags);
+ }
+ 
+ 
+ /**
+  * @brief Queue a channel in the level whose range covers its expiry
+  * 
+  * A channel due within SIMTEMP_WHEEL_SLOTS^(L+1) ticks goes to level L, in
+  * the slot holding its expiry tick; that slot is reached (run or cascaded)
+  * exactly at the start of the slot. Expired channels go to the due list.
+  * Called with the wheel lock held.
+  * 
+  * @param wheel Timer wheel
+  * @param chan Channel with expires_ns set
+  */
+ static void
+ nxp_simtemp_wheel_insert(
+     struct simtemp_wheel *wheel,
+     struct simtemp_channel *chan)
+ {
+     u64 tick = DIV_ROUND_UP_ULL(chan->expires_ns, SIMTEMP_WHEEL_TICK_NS);
+     u64 delta;
+     unsigned int level;
+     unsigned int slot;
+     
+     if (tick <= wheel->now_tick) {
+         hlist_add_head(&chan->node, &wheel->due);
+         chan->level = SIMTEMP_WHEEL_DUE;
+         return;
+     }
+     
+     delta = tick - wheel->now_tick;
+     for (level = 0; level < SIMTEMP_WHEEL_LEVELS - 1; level++) {
+         if (delta < 1ULL << ((level + 1) * SIMTEMP_WHEEL_BITS)) {
+             break;
+         }
+     }
+     if (delta >= 1ULL << (SIMTEMP_WHEEL_LEVELS * SIMTEMP_WHEEL_BITS)) {
+         /* Beyond the wheel: park in the farthest slot, requeued from there */
+         tick = wheel->now_tick + (1ULL << (SIMTEMP_WHEEL_LEVELS * SIMTEMP_WHEEL_BITS)) - 1;
+     }
+     
+     slot = (tick >> (level * SIMTEMP_WHEEL_BITS)) & (SIMTEMP_WHEEL_SLOTS - 1);
+     hlist_add_head(&chan->node, &wheel->slots[level][slot]);
+     wheel->occupied[level] |= 1ULL << slot;
+     chan->level = level;
+     chan->slot = slot;
+ }
+ 
+ 
+ /**
+  * @brief Unlink a queued channel
+  * 
+  * @param wheel Timer wheel (locked)
+  * @param chan Queued channel
+  */
+ static void
+ nxp_simtemp_wheel_remove(
+     struct simtemp_wheel *wheel,
+     struct simtemp_channel *chan)
+ {
+     hlist_del_init(&chan->node);
+     if (chan->level < SIMTEMP_WHEEL_LEVELS &&
+         hlist_empty(&wheel->slots[chan->level][chan->slot])) {
+         wheel->occupied[chan->level] &= ~(1ULL << chan->slot);
+     }
+     chan->level = SIMTEMP_WHEEL_IDLE;
+ }
+ 
+ 
+ /**
+  * @brief First tick after now_tick at which the wheel has work
+  * 
+  * For each level, the next occupied slot in circular order from the
+  * current position is found in the occupancy bitmap; that slot is reached
+  * at the start of its range.
+  * 
+  * @param wheel Timer wheel (locked)
+  * @return Tick to process next, now_tick if channels are due, U64_MAX if empty
+  */
+ static u64
+ nxp_simtemp_wheel_next_tick(
+     struct simtemp_wheel *wheel)
+ {
+     unsigned int level;
+     unsigned int shift;
+     unsigned int first;
+     u64 best = U64_MAX;
+     u64 base;
+     u64 tick;
+     
+     if (!hlist_empty(&wheel->due)) {
+         return wheel->now_tick;
+     }
+     
+     for (level = 0; level < SIMTEMP_WHEEL_LEVELS; level++) {
+         if (!wheel->occupied[level]) {
+             continue;
+         }
+         shift = level * SIMTEMP_WHEEL_BITS;
+         base = (wheel->now_tick >> shift) + 1;
+         first = __ffs64(ror64(wheel->occupied[level],
+                               (unsigned int)(base & (SIMTEMP_WHEEL_SLOTS - 1))));
+         tick = (base + first) << shift;
+         if (tick < best) {
+             best = tick;
+         }
+     }
+     return best;
+ }
+ 
+ 
+ /**
+  * @brief Move the wheel to tick and collect what is due there
+  * 
+  * Upper-level slots starting at tick cascade down, highest level first,
+  * then the level 0 slot of tick moves to the due list. No tick between
+  * now_tick and tick has work (see nxp_simtemp_wheel_next_tick()).
+  * 
+  * @param wheel Timer wheel (locked)
+  * @param tick Tick to move to
+  */
+ static void
+ nxp_simtemp_wheel_advance(
+     struct simtemp_wheel *wheel,
+     u64 tick)
+ {
+     struct simtemp_channel *chan;
+     struct hlist_node *tmp;
+     struct hlist_head list;
+     unsigned int level;
+     unsigned int shift;
+     unsigned int slot;
+     
+     wheel->now_tick = tick;
+     
+     for (level = SIMTEMP_WHEEL_LEVELS; level-- > 0; ) {
+         shift = level * SIMTEMP_WHEEL_BITS;
+         if (tick & ((1ULL << shift) - 1)) {
+             continue;
+         }
+         slot = (tick >> shift) & (SIMTEMP_WHEEL_SLOTS - 1);
+         if (!(wheel->occupied[level] & (1ULL << slot))) {
+             continue;
+         }
+         
+         hlist_move_list(&wheel->slots[level][slot], &list);
+         wheel->occupied[level] &= ~(1ULL << slot);
+         hlist_for_each_entry_safe(chan, tmp, &list, node) {
+             hlist_del(&chan->node);
+             nxp_simtemp_wheel_insert(wheel, chan);
+         }
+     }
+ }
+ 
+ 
+ /**
+  * @brief Program the hrtimer for the next tick with work
+  * 
+  * Only moves the timer earlier, except from the callback, which clears
+  * armed_tick first.
+  * 
+  * @param wheel Timer wheel (locked)
+  */
+ static void
+ nxp_simtemp_wheel_arm(
+     struct simtemp_wheel *wheel)
+ {
+     u64 next = nxp_simtemp_wheel_next_tick(wheel);
+     
+     if (next == U64_MAX || next >= wheel->armed_tick) {
+         return;
+     }
+     wheel->armed_tick = next;
+     hrtimer_start(&wheel->timer, ns_to_ktime(next * SIMTEMP_WHEEL_TICK_NS), HRTIMER_MODE_ABS);
+ }
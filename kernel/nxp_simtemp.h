@@ -33,6 +33,10 @@
 #include <linux/ktime.h>
 #include <linux/string.h>
 #include <linux/random.h>
+#include <linux/idr.h>
+#include <linux/list.h>
+#include <linux/bitmap.h>
+#include <linux/mm.h>
 
 /* =============================================================================
  * FORWARD DECLARATIONS
@@ -47,13 +51,31 @@ struct nxp_simtemp_data;
 /* Flag definitions for temperature samples */
 #define SIMTEMP_FLAG_NEW_SAMPLE        0x01
 #define SIMTEMP_FLAG_THRESHOLD_CROSSED 0x02
+#define SIMTEMP_FLAG_CONFIG_CHANGED    0x04  /* first sample under a new configuration */
+#define SIMTEMP_FLAG_DEGRADED          0x08  /* produced while the CPU budget governor is active */
 
-/* IOCTL commands (for future use) */
+/* Aggregate node: instance numbers selectable one by one */
+#define SIMTEMP_AGG_MAX_DEVICES  1024
+
+/* Record formats, selected per open file with SIMTEMP_IOC_SET_FORMAT */
+#define SIMTEMP_FORMAT_BASIC     0  /* struct simtemp_sample (default) */
+#define SIMTEMP_FORMAT_EXTENDED  1  /* struct simtemp_sample_ext */
+
+/* IOCTL commands */
 #define SIMTEMP_IOC_MAGIC 's'
 #define SIMTEMP_IOC_GET_CONFIG    _IOR(SIMTEMP_IOC_MAGIC, 1, struct simtemp_config)
 #define SIMTEMP_IOC_SET_CONFIG    _IOW(SIMTEMP_IOC_MAGIC, 2, struct simtemp_config)
 #define SIMTEMP_IOC_GET_STATS     _IOR(SIMTEMP_IOC_MAGIC, 3, struct simtemp_stats)
-#define SIMTEMP_IOC_MAXNR         3
+#define SIMTEMP_IOC_SET_FORMAT    _IOW(SIMTEMP_IOC_MAGIC, 4, __u32)
+#define SIMTEMP_IOC_SET_THRESHOLD _IOW(SIMTEMP_IOC_MAGIC, 5, struct simtemp_threshold)
+#define SIMTEMP_IOC_GET_THRESHOLD _IOR(SIMTEMP_IOC_MAGIC, 6, struct simtemp_threshold)
+#define SIMTEMP_IOC_GET_RING      _IOR(SIMTEMP_IOC_MAGIC, 7, struct simtemp_ring_stats)
+#define SIMTEMP_IOC_RESET_RING    _IO(SIMTEMP_IOC_MAGIC, 8)
+#define SIMTEMP_IOC_SET_FILL_LEVEL _IOW(SIMTEMP_IOC_MAGIC, 9, __u32)
+#define SIMTEMP_IOC_SET_SELECT    _IOW(SIMTEMP_IOC_MAGIC, 10, struct simtemp_select)
+#define SIMTEMP_IOC_GET_SELECT    _IOR(SIMTEMP_IOC_MAGIC, 11, struct simtemp_select)
+#define SIMTEMP_IOC_GET_ALERT     _IOR(SIMTEMP_IOC_MAGIC, 12, struct simtemp_alert)
+#define SIMTEMP_IOC_MAXNR         12
 
 /* =============================================================================
  * DATA TYPES definitions
@@ -78,6 +100,33 @@ struct simtemp_sample {
     __u32 flags;          /* bit0=NEW_SAMPLE, bit1=THRESHOLD_CROSSED */
 } __attribute__((packed));
 
+/* Extended record format: basic record plus a per-device sequence number */
+struct simtemp_sample_ext {
+    __u64 timestamp_ns;   /* monotonic timestamp */
+    __s32 temp_mC;        /* milli-degree Celsius */
+    __u32 flags;          /* same bits as struct simtemp_sample */
+    __u64 seq;            /* producer sequence number, starts at 1, no gaps */
+    __u32 config_gen;     /* configuration generation the sample was produced under */
+    __u32 queue_delay_us; /* shared bus wait before the conversion started, 0 off-bus */
+} __attribute__((packed));
+
+/* Record read from the aggregate node: a sample tagged with its instance */
+struct simtemp_sample_tagged {
+    __u64 timestamp_ns;   /* monotonic timestamp */
+    __s32 temp_mC;        /* milli-degree Celsius */
+    __u32 flags;          /* same bits as struct simtemp_sample */
+    __u64 seq;            /* the instance's sequence number */
+    __u32 device_id;      /* instance number: 0 = simtemp, N = simtempN */
+    __u32 config_gen;     /* the instance's configuration generation */
+} __attribute__((packed));
+
+/* Instances feeding an aggregate file, for SIMTEMP_IOC_SET_SELECT / SIMTEMP_IOC_GET_SELECT */
+struct simtemp_select {
+    __u32 all;            /* 1: every instance, present and future; mask ignored */
+    __u32 reserved;
+    __u64 mask[SIMTEMP_AGG_MAX_DEVICES / 64];  /* bit N selects instance N */
+};
+
 /* Configuration structure for ioctl */
 struct simtemp_config {
     __u32 sampling_ms;
@@ -85,6 +134,36 @@ struct simtemp_config {
     __u32 mode;
 };
 
+/* Per-file threshold for SIMTEMP_IOC_SET_THRESHOLD / SIMTEMP_IOC_GET_THRESHOLD */
+struct simtemp_threshold {
+    __s32 threshold_mC;   /* crossing level */
+    __u32 hysteresis_mC;  /* band below the level a sample must reach to re-arm */
+    __u32 enabled;        /* 0: follow the device threshold_mC */
+};
+
+/*
+ * Oldest crossing of a per-file threshold this file has not received, for
+ * SIMTEMP_IOC_GET_ALERT (which acknowledges it)
+ */
+struct simtemp_alert {
+    __u64 seq;            /* crossing sample, 0 = none pending */
+    __u64 timestamp_ns;
+    __s32 temp_mC;
+    __u32 pending;        /* crossings still pending after this one */
+    __u32 dropped;        /* crossings discarded while too many were pending */
+    __u32 reserved;
+};
+
+/* Ring occupancy for SIMTEMP_IOC_GET_RING; counters run from the last reset */
+struct simtemp_ring_stats {
+    __u32 depth;          /* samples queued now */
+    __u32 capacity;       /* ring size in samples */
+    __u32 high_watermark; /* deepest queue */
+    __u32 fill_level;     /* this file's POLLRDBAND level, 0 = off */
+    __u64 high_ns;        /* time spent at least 75% full */
+    __u64 overwritten;    /* samples lost to a full ring */
+};
+
 /* Statistics structure for ioctl */
 struct simtemp_stats {
     __u64 update_count;
@@ -108,18 +187,26 @@ extern ssize_t nxp_simtemp_read(struct file *file, char __user *buf, size_t coun
 extern __poll_t nxp_simtemp_poll(struct file *file, poll_table *wait);
 extern long nxp_simtemp_ioctl(struct file *file, unsigned int cmd, unsigned long arg);
 
+/* Aggregate node operations */
+extern int nxp_simtemp_agg_open(struct inode *inode, struct file *file);
+extern int nxp_simtemp_agg_release(struct inode *inode, struct file *file);
+extern ssize_t nxp_simtemp_agg_read(struct file *file, char __user *buf, size_t count, loff_t *ppos);
+extern __poll_t nxp_simtemp_agg_poll(struct file *file, poll_table *wait);
+extern long nxp_simtemp_agg_ioctl(struct file *file, unsigned int cmd, unsigned long arg);
+
 /* Device tree functions */
 extern int nxp_simtemp_parse_dt(struct nxp_simtemp_data *data);
 
 /* Timer functions */
 extern int nxp_simtemp_init_timer(struct nxp_simtemp_data *data);
 extern void nxp_simtemp_cleanup_timer(struct nxp_simtemp_data *data);
-extern enum hrtimer_restart nxp_simtemp_timer_callback(struct hrtimer *timer);
+extern u64 nxp_simtemp_channel_expire(struct nxp_simtemp_data *data, u64 due_ns);
+extern enum hrtimer_restart nxp_simtemp_wheel_callback(struct hrtimer *timer);
 
 /* Temperature simulation functions */
 extern __s32 nxp_simtemp_generate_temp(struct nxp_simtemp_data *data);
-extern int nxp_simtemp_add_sample(struct nxp_simtemp_data *data, __s32 temp_mC);
-extern int nxp_simtemp_get_sample(struct nxp_simtemp_data *data, struct simtemp_sample *sample);
+extern int nxp_simtemp_add_sample(struct nxp_simtemp_data *data, __s32 temp_mC, u64 timestamp_ns);
+extern int nxp_simtemp_get_sample(struct nxp_simtemp_data *data, struct simtemp_sample_ext *sample);
 
 /* Sysfs functions */
 extern int nxp_simtemp_create_sysfs(struct nxp_simtemp_data *data);
@@ -131,5 +218,11 @@ extern ssize_t threshold_mC_store(struct device *dev, struct device_attribute *a
 extern ssize_t mode_show(struct device *dev, struct device_attribute *attr, char *buf);
 extern ssize_t mode_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count);
 extern ssize_t stats_show(struct device *dev, struct device_attribute *attr, char *buf);
+extern ssize_t config_gen_show(struct device *dev, struct device_attribute *attr, char *buf);
+extern ssize_t cpu_budget_us_show(struct device *dev, struct device_attribute *attr, char *buf);
+extern ssize_t cpu_budget_us_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count);
+extern ssize_t bus_show(struct device *dev, struct device_attribute *attr, char *buf);
+extern ssize_t ring_show(struct device *dev, struct device_attribute *attr, char *buf);
+extern ssize_t ring_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count);
 
 #endif /* _NXP_SIMTEMP_H_ */
\ No newline at end of file
@@ -272,6 +272,7 @@ main() {
     if [ "$build_user" = true ]; then
         echo "  Python CLI:    out/user/cli/main.py"
         echo "  C++ CLI:       out/user/cli/main"
+        echo "  libsimtemp:    out/user/lib/libsimtemp.a"
     fi
     echo ""
     echo "Next steps:"
@@ -42,6 +42,18 @@ is_module_loaded() {
     lsmod | grep -q nxp_simtemp
 }
 
+# Function to wait (up to 2 s) for udev to create a device node
+wait_for_device() {
+    local node="${1:-/dev/simtemp}"
+    local tries=200
+    
+    while [ ! -c "$node" ] && [ $tries -gt 0 ]; do
+        sleep 0.01
+        tries=$((tries - 1))
+    done
+    [ -c "$node" ]
+}
+
 # Function to load the module
 load_module() {
     print_step "Loading kernel module..."
@@ -52,7 +64,7 @@ load_module() {
     fi
     
     # Load the module
-    insmod "$(dirname "$0")/../out/kernel/nxp_simtemp.ko"
+    insmod "$(dirname "$0")/../out/kernel/nxp_simtemp.ko" "$@"
     
     if [ $? -eq 0 ]; then
         print_status "Module loaded successfully"
@@ -61,8 +73,8 @@ load_module() {
         exit 1
     fi
     
-    # Wait a moment for device to be created
-    sleep 1
+    # Wait for the device node instead of a fixed delay
+    wait_for_device || print_warning "/dev/simtemp did not appear within 2 seconds"
 }
 
 # Function to unload the module
@@ -160,7 +172,6 @@ test_configuration() {
     # Test changing sampling period
     print_status "Changing sampling period to 50ms..."
     if echo 50 | sudo tee /sys/class/simtemp/simtemp/sampling_ms >/dev/null; then
-        sleep 1
         echo "New sampling period: $(cat /sys/class/simtemp/simtemp/sampling_ms) ms"
     else
         print_warning "Failed to change sampling period (permission denied or device not ready)"
@@ -169,7 +180,6 @@ test_configuration() {
     # Test changing threshold
     print_status "Changing threshold to 30000 mC (30°C)..."
     if echo 30000 | sudo tee /sys/class/simtemp/simtemp/threshold_mC >/dev/null; then
-        sleep 1
         echo "New threshold: $(cat /sys/class/simtemp/simtemp/threshold_mC) mC"
     else
         print_warning "Failed to change threshold (permission denied or device not ready)"
@@ -178,7 +188,6 @@ test_configuration() {
     # Test changing mode
     print_status "Changing mode to noisy..."
     if echo noisy | sudo tee /sys/class/simtemp/simtemp/mode >/dev/null; then
-        sleep 1
         echo "New mode: $(cat /sys/class/simtemp/simtemp/mode)"
     else
         print_warning "Failed to change mode (permission denied or device not ready)"
@@ -263,9 +272,6 @@ test_alert_mode() {
         return 1
     fi
     
-    # Wait for device to settle
-    sleep 0.1
-    
     print_status "Monitoring for alert within ${max_wait_time} seconds..."
     
     # Use Python CLI to monitor and detect alerts
@@ -455,7 +461,7 @@ test_device_tree_default() {
     
     # Load module
     insmod out/kernel/nxp_simtemp.ko
-    sleep 1
+    wait_for_device
     
     # Check configuration
     print_status "Default configuration:"
@@ -535,7 +541,7 @@ EOF
     # Load module
     print_status "Loading module with device tree..."
     insmod out/kernel/nxp_simtemp.ko
-    sleep 1
+    wait_for_device
     
     # Check configuration
     print_status "Device tree configuration:"
@@ -579,6 +585,24 @@ EOF
 }
 
 
+# Function to run the concurrent C++ self-test (event-driven, no sleeps)
+run_selftest() {
+    print_step "Running self-test scenarios..."
+    
+    local cli="$(dirname "$0")/../out/user/cli/simtemp_cli_cpp"
+    if [ ! -x "$cli" ]; then
+        print_error "C++ CLI not found at $cli. Run 'make user' first."
+        return 1
+    fi
+    
+    # One instance per scenario so every scenario runs concurrently
+    if ! is_module_loaded; then
+        load_module count=6
+    fi
+    
+    "$cli" --selftest
+}
+
 # Function to show usage
 show_usage() {
     echo "Usage: $0 [OPTIONS]"
@@ -588,6 +612,7 @@ show_usage() {
     echo "  --unload-only   Only unload the module"
     echo "  --test-only     Only run tests (assumes module is loaded)"
     echo "  --test-alert    Test alert mode: verify alert occurs within 2 periods"
+    echo "  --selftest      Run the C++ self-test scenarios concurrently (loads 6 instances if needed)"
     echo "  --test-dt       Test device tree functionality (default values only)"
     echo "  --test-dt-custom Test device tree functionality (custom values only)"
     echo "  --help          Show this help message"
@@ -628,6 +653,15 @@ main() {
                 exit 1
             fi
             ;;
+        --selftest)
+            check_root
+            if run_selftest; then
+                print_status "Self-test PASSED"
+            else
+                print_error "Self-test FAILED"
+                exit 1
+            fi
+            ;;
         --test-dt)
             check_root
             test_device_tree_default
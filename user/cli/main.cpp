@@ -5,203 +5,694 @@
  * NXP simulated temperature sensor driver.
  */
 
-#include <iostream>
-#include <fstream>
 #include <string>
 #include <vector>
 #include <chrono>
 #include <thread>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <cstdint>
 #include <unistd.h>
-#include <fcntl.h>
-#include <poll.h>
-#include <sys/select.h>
-#include <iomanip>
-#include <sstream>
-
-// Device paths
-const std::string DEVICE_PATH = "/dev/simtemp";
-const std::string SYSFS_BASE = "/sys/class/simtemp/simtemp";
-
-// Binary record format (matches kernel structure)
-struct SimTempSample {
-    uint64_t timestamp_ns;
-    int32_t temp_mC;
-    uint32_t flags;
-} __attribute__((packed));
-
-// Flag definitions
-const uint32_t FLAG_NEW_SAMPLE = 0x01;
-const uint32_t FLAG_THRESHOLD_CROSSED = 0x02;
-
-class SimTempDevice {
+
+#include "simtemp.h"
+#include "format.h"
+#include "stats.h"
+#include "recording.h"
+#include "checkpoint.h"
+#include "sink.h"
+#include "predict.h"
+#include "filter.h"
+#include "sysfs.h"
+#include "merge.h"
+#include "resample.h"
+#include "correlate.h"
+#include "topk.h"
+#include "jitter.h"
+#include "arrow.h"
+#include "handoff.h"
+#include "selftest.h"
+#include "aggregate.h"
+
+using namespace simtemp;
+
+/*
+ * Output goes through stdio and the libsimtemp formatter only: without
+ * <iostream> there is no iostream static initialisation at startup, which
+ * matters for the statically linked build that scripts run many times.
+ * Streaming modes flush once per batch instead of once per line.
+ */
+
+// Argument for a "%llu" conversion
+static inline unsigned long long ull(uint64_t value) {
+    return static_cast<unsigned long long>(value);
+}
+
+// Temperature/timestamp text for status lines (sample lines use the
+// buffer forms directly)
+struct Temp {
+    char text[32];
+    explicit Temp(int64_t temp_mC) { formatTemperature(text, sizeof(text), static_cast<int32_t>(temp_mC)); }
+};
+
+struct Time {
+    char text[48];
+    explicit Time(uint64_t timestamp_ns) { formatTimestamp(text, sizeof(text), timestamp_ns); }
+};
+
+void printSampleLine(uint64_t timestamp_ns, int32_t temp_mC, uint32_t flags) {
+    char line[FORMAT_LINE_MAX];
+    int len = formatSampleLine(line, sizeof(line), timestamp_ns, temp_mC, flags);
+    fwrite(line, 1, len, stdout);
+}
+
+void printSample(const SimTempSample& sample) {
+    printSampleLine(sample.timestamp_ns, sample.temp_mC, sample.flags);
+}
+
+// Device node opened on first use, with the per-fd threshold if one was given
+bool openDevice(SimTempDevice& device, const ReaderThreshold& fd_threshold) {
+    if (device.isOpen()) {
+        return true;
+    }
+    if (access(device.path().c_str(), F_OK) != 0) {
+        fprintf(stderr, "Error: Device %s not found\n", device.path().c_str());
+        fprintf(stderr, "Make sure the kernel module is loaded and device is created\n");
+        return false;
+    }
+    if (!device.open()) {
+        return false;
+    }
+    if (fd_threshold.enabled &&
+        !device.setThreshold(fd_threshold.threshold_mC, fd_threshold.hysteresis_mC)) {
+        fprintf(stderr, "Failed to set per-fd threshold: %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void monitorMode(SimTempDevice& device, double duration = -1.0, FilterChain* filters = NULL) {
+    printf("Monitoring temperature readings...\n");
+    if (filters) {
+        printf("Smoothing with %s\n", filters->describe().c_str());
+    }
+    printf("Press Ctrl+C to stop\n\n");
+    fflush(stdout);
+    
+    auto start_time = std::chrono::steady_clock::now();
+    
+    while (true) {
+        if (duration > 0.0) {
+            auto elapsed = std::chrono::steady_clock::now() - start_time;
+            if (std::chrono::duration<double>(elapsed).count() >= duration) {
+                break;
+            }
+        }
+        
+        SimTempSample sample;
+        if (device.readSample(sample, 1.0)) {
+            if (filters) {
+                int32_t raw_mC = sample.temp_mC;
+                int32_t smoothed_mC;
+                filters->process(&raw_mC, &smoothed_mC, 1);
+                printf("%s temp=%s filtered=%s alert=%d\n", Time(sample.timestamp_ns).text,
+                       Temp(sample.temp_mC).text, Temp(smoothed_mC).text,
+                       (sample.flags & FLAG_THRESHOLD_CROSSED) ? 1 : 0);
+            } else {
+                printSample(sample);
+            }
+            fflush(stdout);
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+}
+
+void printSinkCounters(FILE* out, const SinkCounters& c) {
+    fprintf(out, "Sink: in=%llu written=%llu dropped=%llu (%llu batches)"
+            " summarized=%llu (%llu summaries written, %llu dropped) spilled=%llu batches (peak %llu bytes)"
+            " blocked=%llu (%llu ms) peak_depth=%zu errors=%llu\n",
+            ull(c.samples_in), ull(c.samples_written), ull(c.samples_dropped), ull(c.batches_dropped),
+            ull(c.samples_summarized), ull(c.summaries_written), ull(c.summaries_dropped), ull(c.batches_spilled),
+            ull(c.spill_peak_bytes), ull(c.blocked), ull(c.blocked_ns / 1000000), c.peak_depth,
+            ull(c.write_errors));
+}
+
+// Per-batch status line for a recording, printed by the queue's sink
+// thread after the write, so a stalled terminal holds up the sink (where
+// the policy applies) rather than the device reader
+class StatusSink : public SampleSink {
 private:
-    std::string device_path;
-    std::string sysfs_base;
-    int device_fd;
-    bool is_open;
+    SampleSink& sink;
+    FILE* out;
 
 public:
-    SimTempDevice(const std::string& path = DEVICE_PATH) 
-        : device_path(path), sysfs_base(SYSFS_BASE), device_fd(-1), is_open(false) {}
+    StatusSink(SampleSink& sink, FILE* out) : sink(sink), out(out) {}
+
+    bool write(const SampleBatch& batch) {
+        bool ok = sink.write(batch);
+        BatchStats stats = computeStats(batch.temp_mC.data(), batch.flags.data(), batch.size());
+        fprintf(out, "batch=%zu min=%s max=%s alerts=%zu\n", stats.count,
+                Temp(stats.min_mC).text, Temp(stats.max_mC).text, stats.alerts);
+        fflush(out);
+        return ok;
+    }
+    bool writeSummary(const SampleSummary& summary) { return sink.writeSummary(summary); }
+    bool flush() { return sink.flush(); }
+    bool storesSummaries() const { return sink.storesSummaries(); }
+};
+
+void recordMode(SimTempDevice& device, const std::string& path, const SinkConfig& sink_config,
+                double duration = -1.0) {
+    // "-" streams samples as text to stdout; status then goes to stderr
+    bool to_stdout = (path == "-");
+    FILE* status = to_stdout ? stderr : stdout;
     
-    ~SimTempDevice() {
-        close();
+    RecordingWriter writer;
+    if (!to_stdout && !writer.open(path)) {
+        fprintf(stderr, "Failed to create %s: %s\n", path.c_str(), strerror(errno));
+        exit(1);
     }
+    RecordingSink recording_sink(writer);
+    StatusSink status_sink(recording_sink, status);
+    TextSink text_sink(STDOUT_FILENO);
+    QueuedSink queue(to_stdout ? static_cast<SampleSink&>(text_sink) : status_sink, sink_config);
     
-    bool open() {
-        device_fd = ::open(device_path.c_str(), O_RDONLY | O_NONBLOCK);
-        if (device_fd < 0) {
-            std::cerr << "Failed to open device " << device_path << ": " << strerror(errno) << std::endl;
-            return false;
+    fprintf(status, "Recording temperature samples to %s (sink policy %s, queue %zu batches)...\n",
+            to_stdout ? "stdout" : path.c_str(), sinkPolicyName(sink_config.policy),
+            sink_config.max_batches);
+    if (!to_stdout && sink_config.policy == SINK_SUMMARIZE) {
+        fprintf(status, "Note: recordings hold raw samples only; summarized samples are lost\n");
+    }
+    fprintf(status, "Press Ctrl+C to stop\n\n");
+    fflush(status);
+    
+    SampleBatch batch;
+    auto start_time = std::chrono::steady_clock::now();
+    
+    while (true) {
+        if (duration > 0.0) {
+            auto elapsed = std::chrono::steady_clock::now() - start_time;
+            if (std::chrono::duration<double>(elapsed).count() >= duration) {
+                break;
+            }
+        }
+    
+        batch.clear();
+        if (device.readBatch(batch, DEFAULT_CHUNK_SAMPLES, 1.0) > 0) {
+            queue.push(batch);
         }
-        is_open = true;
-        return true;
     }
     
-    void close() {
-        if (is_open && device_fd >= 0) {
-            ::close(device_fd);
-            device_fd = -1;
-            is_open = false;
+    queue.close();
+    writer.close();
+    printSinkCounters(status, queue.counters());
+    if (!to_stdout) {
+        printf("Recorded %llu samples (%llu bytes)\n", ull(writer.samplesWritten()),
+               ull(writer.bytesWritten()));
+    }
+}
+
+void checkpointedRecordMode(SimTempDevice& device, const std::string& path,
+                            const std::string& checkpoint_path, const std::string& handoff_path,
+                            double duration = -1.0) {
+    // Take over from a running collector first: it commits before handing
+    // over, so the checkpoint opened below is exactly where it stopped.
+    // Confirm before touching the recording: once its timeout has passed
+    // the predecessor keeps collecting, and the files stay its own.
+    HandoffClient predecessor;
+    HandoffState handoff;
+    bool took_over = false;
+    if (!handoff_path.empty()) {
+        if (predecessor.take(handoff_path, handoff)) {
+            device.adopt(handoff.sources[0].fd, handoff.sources[0].format);
+            for (size_t i = 1; i < handoff.sources.size(); ++i) {
+                close(handoff.sources[i].fd);
+            }
+            if (!predecessor.confirm()) {
+                fprintf(stderr, "Handoff from pid %u not confirmed: %s; predecessor keeps collecting\n",
+                        handoff.pid, strerror(errno));
+                exit(1);
+            }
+            took_over = true;
+        } else if (errno != ENOENT && errno != ECONNREFUSED) {
+            fprintf(stderr, "Handoff from %s failed: %s\n", handoff_path.c_str(), strerror(errno));
+            exit(1);
         }
     }
     
-    bool readSample(SimTempSample& sample, double timeout_sec = -1.0) {
-        if (!is_open) {
-            std::cerr << "Device not open" << std::endl;
-            return false;
+    CheckpointedRecorder recorder;
+    bool resumed = false;
+    if (!recorder.open(path, checkpoint_path, resumed)) {
+        fprintf(stderr, "Failed to open %s with checkpoint %s: %s\n", path.c_str(),
+                checkpoint_path.c_str(), strerror(errno));
+        exit(1);
+    }
+    
+    if (took_over) {
+        const HandoffSource& src = handoff.sources[0];
+        printf("Took over from pid %u at seq=%llu (%zu pending samples)\n", handoff.pid,
+               ull(src.last_seq), src.pending.size());
+        if (src.last_seq != recorder.sequence().lastSeq()) {
+            fprintf(stderr, "Warning: checkpoint is at seq=%llu\n", ull(recorder.sequence().lastSeq()));
         }
-        
-        if (timeout_sec > 0.0) {
-            // Use poll for timeout
-            struct pollfd pfd;
-            pfd.fd = device_fd;
-            pfd.events = POLLIN;
-            pfd.revents = 0;
-            
-            int timeout_ms = static_cast<int>(timeout_sec * 1000);
-            int ret = poll(&pfd, 1, timeout_ms);
-            
-            if (ret == 0) {
-                std::cerr << "Read timeout" << std::endl;
-                return false;
-            } else if (ret < 0) {
-                std::cerr << "Poll error: " << strerror(errno) << std::endl;
-                return false;
+        SampleBatch pending(src.pending);
+        if (!pending.empty() && !recorder.append(pending)) {
+            fprintf(stderr, "Write error: %s\n", strerror(errno));
+            exit(1);
+        }
+    } else if (resumed) {
+        const Checkpoint& ckpt = recorder.checkpoint();
+        printf("Resuming %s at seq=%llu offset=%llu (%llu samples recorded)\n", path.c_str(),
+               ull(ckpt.last_seq), ull(ckpt.sink_offset), ull(ckpt.samples));
+    } else {
+        printf("Recording temperature samples to %s...\n", path.c_str());
+    }
+    printf("Press Ctrl+C to stop\n\n");
+    fflush(stdout);
+    
+    // After a takeover, listen for the next upgrade on the same path
+    HandoffListener listener;
+    if (!handoff_path.empty() && !listener.open(handoff_path)) {
+        fprintf(stderr, "Failed to listen on %s: %s\n", handoff_path.c_str(), strerror(errno));
+        if (!took_over) {
+            exit(1);
+        }
+    }
+    
+    SampleBatch batch;
+    std::vector<SequenceGap> gaps;
+    bool handed_off = false;
+    auto start_time = std::chrono::steady_clock::now();
+    
+    while (true) {
+        if (duration > 0.0) {
+            auto elapsed = std::chrono::steady_clock::now() - start_time;
+            if (std::chrono::duration<double>(elapsed).count() >= duration) {
+                break;
             }
         }
         
-        ssize_t bytes_read = ::read(device_fd, &sample, sizeof(sample));
-        if (bytes_read != sizeof(sample)) {
-            if (errno == EAGAIN) {
-                std::cerr << "No data available" << std::endl;
-            } else {
-                std::cerr << "Read error: " << strerror(errno) << std::endl;
+        // A successor is connecting: commit, pass the device and cursor, and
+        // stop once it drains; if it never confirms, keep collecting
+        int successor = listener.isOpen() ? listener.accept() : -1;
+        if (successor >= 0) {
+            HandoffState state;
+            state.pid = getpid();
+            state.sources.resize(1);
+            state.sources[0].fd = device.fd();
+            state.sources[0].format = device.recordFormat();
+            state.sources[0].last_seq = recorder.sequence().lastSeq();
+            state.sources[0].last_timestamp_ns = recorder.sequence().lastTimestamp();
+            if (recorder.commit() && listener.handOff(successor, state)) {
+                handed_off = true;
+                break;
             }
-            return false;
+            fprintf(stderr, "Handoff failed: %s; still collecting\n", strerror(errno));
+        }
+    
+        batch.clear();
+        gaps.clear();
+        if (device.readBatch(batch, DEFAULT_CHUNK_SAMPLES, 1.0) > 0) {
+            if (!recorder.append(batch, &gaps)) {
+                fprintf(stderr, "Write error: %s\n", strerror(errno));
+                break;
+            }
+            for (const auto& gap : gaps) {
+                printf("gap: lost %llu samples (seq %llu-%llu)\n", ull(gap.lost()),
+                       ull(gap.first_seq), ull(gap.last_seq));
+            }
+            if (!batch.empty()) {
+                printf("batch=%zu seq=%llu-%llu\n", batch.size(), ull(batch.seq.front()),
+                       ull(batch.seq.back()));
+            }
+            fflush(stdout);
         }
-        
-        return true;
     }
     
-    std::vector<SimTempSample> readSamples(int count, double timeout_sec = -1.0) {
-        std::vector<SimTempSample> samples;
-        samples.reserve(count);
-        
-        for (int i = 0; i < count; ++i) {
-            SimTempSample sample;
-            if (readSample(sample, timeout_sec)) {
-                samples.push_back(sample);
-            } else {
+    if (handed_off) {
+        recorder.detach();
+        printf("Handed off to successor at seq=%llu\n", ull(recorder.sequence().lastSeq()));
+    } else if (!recorder.close()) {
+        fprintf(stderr, "Checkpoint error: %s\n", strerror(errno));
+    }
+    const SequenceCursor& cursor = recorder.sequence();
+    printf("Recorded %llu samples, last seq=%llu, lost=%llu, duplicates dropped=%llu, checkpoints=%llu\n",
+           ull(recorder.checkpoint().samples), ull(cursor.lastSeq()), ull(cursor.samplesLost()),
+           ull(cursor.duplicatesDropped()), ull(recorder.syncCount()));
+}
+
+void predictMode(SimTempDevice& device, double horizon_sec, double duration = -1.0) {
+    // Follow threshold changes: refreshed only on POLLPRI or a flagged sample
+    ConfigCache config_cache;
+    int32_t threshold_mC = 45000;
+    if (config_cache.open()) {
+        threshold_mC = config_cache.config().threshold_mC;
+    } else {
+        std::string threshold_str = device.getConfig("threshold_mC");
+        threshold_mC = threshold_str.empty() ? 45000 : std::stoi(threshold_str);
+    }
+    PredictorConfig config(threshold_mC, static_cast<uint64_t>(horizon_sec * 1e9));
+    ThresholdPredictor predictor(config);
+    
+    printf("Predicting threshold crossings (threshold %s, horizon %g s)...\n",
+           Temp(threshold_mC).text, horizon_sec);
+    printf("Press Ctrl+C to stop\n\n");
+    fflush(stdout);
+    
+    SampleBatch batch;
+    std::vector<uint32_t> indices;
+    auto start_time = std::chrono::steady_clock::now();
+    
+    while (true) {
+        if (duration > 0.0) {
+            auto elapsed = std::chrono::steady_clock::now() - start_time;
+            if (std::chrono::duration<double>(elapsed).count() >= duration) {
                 break;
             }
         }
+    
+        batch.clear();
+        ssize_t got = device.readBatch(batch, DEFAULT_CHUNK_SAMPLES, 1.0);
+        if (config_cache.pollFd() >= 0 &&
+            (config_cache.noteBatch(batch) || config_cache.poll(0)) &&
+            config_cache.config().threshold_mC != threshold_mC) {
+            threshold_mC = config_cache.config().threshold_mC;
+            predictor.setThreshold(threshold_mC);
+            printf("Threshold changed to %s (config generation %u)\n", Temp(threshold_mC).text,
+                   config_cache.config().generation);
+        }
+        if (got <= 0) {
+            continue;
+        }
+        
+        indices.resize(batch.size());
+        size_t alerts = predictor.updateBatch(batch.timestamp_ns.data(), batch.temp_mC.data(),
+                                              batch.size(), indices.data());
+        for (size_t i = 0; i < alerts; ++i) {
+            printf("%s *** PRE-ALERT: threshold expected in less than %g s ***\n",
+                   Time(batch.timestamp_ns[indices[i]]).text, horizon_sec);
+        }
         
-        return samples;
+        const Prediction& p = predictor.last();
+        printf("%s temp=%s", Time(batch.timestamp_ns.back()).text, Temp(batch.temp_mC.back()).text);
+        if (!p.valid) {
+            printf(" (collecting samples)\n");
+        } else if (p.crossing) {
+            printf(" slope=%.1f mC/s eta=%.2f s confidence=%.2f\n", p.slope_mC_per_s,
+                   p.eta_ns / 1e9, p.confidence);
+        } else {
+            printf(" slope=%.1f mC/s eta=none\n", p.slope_mC_per_s);
+        }
+        fflush(stdout);
+    }
+}
+
+void watchStatsMode(SimTempDevice& device, double interval_sec, double duration = -1.0) {
+    StatsWatcher watcher;
+    DriverStats prev;
+    DriverStats cur;
+    if (!watcher.open() || !watcher.sample(prev)) {
+        fprintf(stderr, "Failed to read %s/stats: %s\n", SYSFS_BASE.c_str(), strerror(errno));
+        exit(1);
     }
     
-    bool configure(const std::string& param, const std::string& value) {
-        std::string sysfs_path = sysfs_base + "/" + param;
-        std::ofstream file(sysfs_path);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open " << sysfs_path << ": " << strerror(errno) << std::endl;
-            return false;
+    bool has_seq = (device.recordFormat() == RECORD_EXTENDED);
+    printf("Watching driver statistics every %g s...\n", interval_sec);
+    printf("Press Ctrl+C to stop\n\n");
+    fflush(stdout);
+    
+    SequenceCursor cursor;
+    SampleBatch batch;
+    uint64_t received = 0;
+    uint64_t prev_received = 0;
+    uint64_t prev_lost = 0;
+    auto interval = std::chrono::duration<double>(interval_sec);
+    auto start_time = std::chrono::steady_clock::now();
+    auto last_tick = start_time;
+    
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        if (duration > 0.0 && std::chrono::duration<double>(now - start_time).count() >= duration) {
+            break;
+        }
+    
+        // Consume samples until the next tick so received/dropped stay current
+        double remaining = std::chrono::duration<double>(last_tick + interval - now).count();
+        if (remaining > 0.0) {
+            batch.clear();
+            if (device.readBatch(batch, DEFAULT_CHUNK_SAMPLES, remaining) > 0) {
+                cursor.advance(batch);
+                received += batch.size();
+            }
+            continue;
         }
         
-        file << value;
-        file.close();
-        return true;
+        double elapsed = std::chrono::duration<double>(now - last_tick).count();
+        last_tick = now;
+        if (!watcher.sample(cur)) {
+            fprintf(stderr, "Stats read error: %s\n", strerror(errno));
+            continue;
+        }
+        
+        StatsDelta d = statsDelta(prev, cur, elapsed);
+        uint64_t lost = cursor.samplesLost();
+        printf("updates=%llu (+%llu, %.1f/s) alerts=%llu (+%llu, %.1f/s) errors=%llu (+%llu, %.1f/s)"
+               " last_error=%d",
+               ull(cur.updates), ull(d.updates), d.updates_per_s,
+               ull(cur.alerts), ull(d.alerts), d.alerts_per_s,
+               ull(cur.errors), ull(d.errors), d.errors_per_s, cur.last_error);
+        if (cur.batch) {
+            printf(" cb=%lluus/s", ull(cur.cb_us));
+            if (cur.gov_level) {
+                printf(" DEGRADED(level=%u batch=%u rate/%u)", cur.gov_level, cur.batch, cur.rate_div);
+            }
+        }
+        printf(" | received=%llu (+%llu, %.1f/s)", ull(received), ull(received - prev_received),
+               (received - prev_received) / elapsed);
+        if (has_seq) {
+            printf(" dropped=%llu (+%llu)", ull(lost), ull(lost - prev_lost));
+        } else {
+            printf(" dropped=n/a");
+        }
+        RingStats ring;
+        if (device.ringStats(ring)) {
+            printf(" | ring=%u/%u hwm=%u high=%llums overwritten=%llu", ring.depth, ring.capacity,
+                   ring.high_watermark, ull(ring.high_ns / 1000000), ull(ring.overwritten));
+        }
+        printf("\n");
+        fflush(stdout);
+        
+        prev = cur;
+        prev_received = received;
+        prev_lost = lost;
     }
+}
+
+void resampleMode(SimTempDevice& device, const ResamplerConfig& config, double duration = -1.0) {
+    std::string sampling_str = device.getConfig("sampling_ms");
+    uint64_t input_period_ns = (sampling_str.empty() ? 100 : std::stoul(sampling_str)) * 1000000ULL;
+    Resampler resampler(config, input_period_ns);
     
-    std::string getConfig(const std::string& param) {
-        std::string sysfs_path = sysfs_base + "/" + param;
-        std::ifstream file(sysfs_path);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open " << sysfs_path << ": " << strerror(errno) << std::endl;
-            return "";
+    printf("Resampling onto a %s grid...\n", resampler.describe().c_str());
+    printf("Press Ctrl+C to stop\n\n");
+    fflush(stdout);
+    
+    SampleBatch batch;
+    SampleBatch out;
+    auto start_time = std::chrono::steady_clock::now();
+    
+    while (true) {
+        if (duration > 0.0) {
+            auto elapsed = std::chrono::steady_clock::now() - start_time;
+            if (std::chrono::duration<double>(elapsed).count() >= duration) {
+                break;
+            }
+        }
+        
+        batch.clear();
+        if (device.readBatch(batch, DEFAULT_CHUNK_SAMPLES, 1.0) <= 0) {
+            continue;
         }
         
-        std::string value;
-        std::getline(file, value);
-        return value;
+        out.clear();
+        resampler.process(batch, out);
+        for (size_t i = 0; i < out.size(); ++i) {
+            printSampleLine(out.timestamp_ns[i], out.temp_mC[i], out.flags[i]);
+        }
+        fflush(stdout);
     }
+}
+
+void printMerged(const MergedBatch& out) {
+    char timestamp[48];
+    char temp[32];
     
-    std::string getStats() {
-        std::string sysfs_path = sysfs_base + "/stats";
-        std::ifstream file(sysfs_path);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open " << sysfs_path << ": " << strerror(errno) << std::endl;
-            return "";
+    for (size_t i = 0; i < out.size(); ++i) {
+        formatTimestamp(timestamp, sizeof(timestamp), out.samples.timestamp_ns[i]);
+        formatTemperature(temp, sizeof(temp), out.samples.temp_mC[i]);
+        printf("%s src=%u temp=%s alert=%d\n", timestamp, out.source[i], temp,
+               (out.samples.flags[i] & FLAG_THRESHOLD_CROSSED) ? 1 : 0);
+    }
+    fflush(stdout);
+}
+
+// Comma-separated list, empty entries skipped
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) {
+            comma = list.size();
         }
-        
-        std::string stats;
-        std::getline(file, stats);
-        return stats;
+        if (comma > start) {
+            items.push_back(list.substr(start, comma - start));
+        }
+        start = comma + 1;
     }
-};
+    return items;
+}
+
+// Entries under /dev/ are live devices, everything else a recording.
+// Returns whether any source is live; exits on open failures.
+bool openSources(SimTempDevice& device, const ReaderThreshold& fd_threshold,
+                 const std::string& source_list, std::vector<std::string>& paths,
+                 std::vector<MergeSource*>& sources, std::vector<SimTempDevice*>& devices) {
+    paths = splitList(source_list);
+    
+    bool live = false;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (paths[i].compare(0, 5, "/dev/") == 0) {
+            SimTempDevice* dev = &device;
+            if (paths[i] != device.path()) {
+                dev = new SimTempDevice(paths[i]);
+                devices.push_back(dev);
+                if (!dev->open()) {
+                    exit(1);
+                }
+            } else if (!openDevice(device, fd_threshold)) {
+                exit(1);
+            }
+            sources.push_back(new DeviceSource(dev->fd(), dev->recordFormat()));
+            live = true;
+        } else {
+            RecordingSource* rec = new RecordingSource();
+            if (!rec->open(paths[i])) {
+                fprintf(stderr, "Failed to open recording %s: %s\n", paths[i].c_str(), strerror(errno));
+                exit(1);
+            }
+            sources.push_back(rec);
+        }
+        printf("source %zu: %s\n", i, paths[i].c_str());
+    }
+    return live;
+}
 
-std::string formatTemperature(int32_t temp_mC) {
-    double temp_C = temp_mC / 1000.0;
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(3) << temp_C << "°C";
-    return oss.str();
+void closeSources(std::vector<MergeSource*>& sources, std::vector<SimTempDevice*>& devices) {
+    for (size_t i = 0; i < sources.size(); ++i) {
+        delete sources[i];
+    }
+    for (size_t i = 0; i < devices.size(); ++i) {
+        delete devices[i];
+    }
+    sources.clear();
+    devices.clear();
 }
 
-std::string formatTimestamp(uint64_t timestamp_ns) {
-    auto timestamp_s = std::chrono::nanoseconds(timestamp_ns);
-    auto time_point = std::chrono::time_point<std::chrono::system_clock>(timestamp_s);
-    auto time_t = std::chrono::system_clock::to_time_t(time_point);
+void mergeMode(SimTempDevice& device, const ReaderThreshold& fd_threshold,
+               const std::string& source_list, double reorder_ms, double duration = -1.0) {
+    std::vector<std::string> paths;
+    std::vector<MergeSource*> sources;
+    std::vector<SimTempDevice*> devices;
+    bool live = openSources(device, fd_threshold, source_list, paths, sources, devices);
+    StreamMerger merger(static_cast<uint64_t>(reorder_ms * 1e6));
+    for (size_t i = 0; i < sources.size(); ++i) {
+        merger.addSource(sources[i], static_cast<uint32_t>(i));
+    }
     
-    auto tm = *std::localtime(&time_t);
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%dT%H:%M:%S");
+    printf("Merging %zu sources by timestamp (reorder window %g ms)...\n", paths.size(), reorder_ms);
+    if (live) {
+        printf("Press Ctrl+C to stop\n");
+    }
+    printf("\n");
+    fflush(stdout);
     
-    // Add fractional seconds
-    auto fractional = timestamp_ns % 1000000000;
-    oss << "." << std::setfill('0') << std::setw(9) << fractional << "Z";
+    MergedBatch out;
+    auto start_time = std::chrono::steady_clock::now();
     
-    return oss.str();
-}
-
-void printSample(const SimTempSample& sample) {
-    std::string timestamp_str = formatTimestamp(sample.timestamp_ns);
-    std::string temp_str = formatTemperature(sample.temp_mC);
+    while (!merger.finished()) {
+        auto now = std::chrono::steady_clock::now();
+        if (duration > 0.0 && std::chrono::duration<double>(now - start_time).count() >= duration) {
+            break;
+        }
+        
+        out.clear();
+        uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            now.time_since_epoch()).count();
+        if (merger.next(out, DEFAULT_CHUNK_SAMPLES, live ? now_ns : 0) == 0) {
+            if (!live) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        
+        printMerged(out);
+    }
     
-    std::string alert_str = (sample.flags & FLAG_THRESHOLD_CROSSED) ? "alert=1" : "alert=0";
+    out.clear();
+    merger.drain(out, DEFAULT_CHUNK_SAMPLES);
+    printMerged(out);
     
-    std::cout << timestamp_str << " temp=" << temp_str << " " << alert_str << std::endl;
+    printf("\nMerged %llu samples, %llu late\n", ull(merger.samplesEmitted()), ull(merger.lateSamples()));
+    
+    closeSources(sources, devices);
+}
+
+void printCorrelation(const CorrelationSnapshot& snap) {
+    printf("%s window=%zu rows\n", Time(snap.timestamp_ns).text, snap.rows);
+    for (size_t i = 0; i < snap.streams; ++i) {
+        printf("  src %zu:", i);
+        for (size_t j = 0; j < snap.streams; ++j) {
+            printf(" %6.3f", snap.corr(i, j));
+        }
+        printf("  mean=%s neighbours=%.3f\n", Temp(static_cast<int32_t>(snap.mean_mC[i])).text,
+               snap.neighbourCorrelation(i));
+    }
+    printf("\n");
+    fflush(stdout);
 }
 
-void monitorMode(SimTempDevice& device, double duration = -1.0) {
-    std::cout << "Monitoring temperature readings..." << std::endl;
-    std::cout << "Press Ctrl+C to stop" << std::endl;
-    std::cout << std::endl;
+void correlateMode(SimTempDevice& device, const ReaderThreshold& fd_threshold,
+                   const std::string& source_list, const ResamplerConfig& grid, size_t window,
+                   size_t publish_every, double duration = -1.0) {
+    std::vector<std::string> paths;
+    std::vector<MergeSource*> sources;
+    std::vector<SimTempDevice*> devices;
+    bool live = openSources(device, fd_threshold, source_list, paths, sources, devices);
+    size_t n = sources.size();
+    
+    // Resamplers are built on each source's first span, once its rate is known
+    std::vector<Resampler*> resamplers(n, static_cast<Resampler*>(NULL));
+    std::vector<bool> done(n, false);
+    RowAligner aligner(n);
+    SlidingCorrelation corr(n, window, publish_every);
+    std::vector<int32_t> row(n);
+    SampleBatch grid_batch;
     
+    printf("Correlating %zu sources on a %g ms grid (window %zu rows, every %zu rows)...\n",
+           n, grid.period_ns / 1e6, window, publish_every);
+    if (live) {
+        printf("Press Ctrl+C to stop\n");
+    }
+    printf("\n");
+    fflush(stdout);
+    
+    size_t finished = 0;
     auto start_time = std::chrono::steady_clock::now();
     
-    while (true) {
+    while (finished < n) {
         if (duration > 0.0) {
             auto elapsed = std::chrono::steady_clock::now() - start_time;
             if (std::chrono::duration<double>(elapsed).count() >= duration) {
@@ -209,96 +700,541 @@ void monitorMode(SimTempDevice& device, double duration = -1.0) {
             }
         }
         
-        SimTempSample sample;
-        if (device.readSample(sample, 1.0)) {
-            printSample(sample);
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        bool progress = false;
+        for (size_t i = 0; i < n; ++i) {
+            MergeSpan span;
+            int ret = done[i] ? -1 : sources[i]->next(span);
+            if (ret < 0) {
+                if (!done[i]) {
+                    done[i] = true;
+                    finished++;
+                }
+                continue;
+            }
+            if (ret == 0) {
+                continue;
+            }
+            
+            if (!resamplers[i]) {
+                uint64_t period = span.count > 1 ?
+                    (span.timestamp_ns[span.count - 1] - span.timestamp_ns[0]) / (span.count - 1) :
+                    grid.period_ns;
+                resamplers[i] = new Resampler(grid, period);
+            }
+            grid_batch.clear();
+            resamplers[i]->process(span.timestamp_ns, span.temp_mC, span.flags, span.count, grid_batch);
+            aligner.add(i, grid_batch);
+            progress = true;
         }
+        
+        uint64_t ts;
+        while (aligner.nextRow(ts, row.data())) {
+            if (corr.push(ts, row.data())) {
+                printCorrelation(corr.snapshot());
+            }
+        }
+        
+        if (!progress && live) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    
+    if (corr.rows() > 0) {
+        printf("Final window:\n");
+        printCorrelation(corr.publish());
     }
+    
+    for (size_t i = 0; i < n; ++i) {
+        delete resamplers[i];
+    }
+    closeSources(sources, devices);
 }
 
-void testMode(SimTempDevice& device, int32_t threshold_mC = 30000) {
-    std::cout << "Running test mode..." << std::endl;
-    std::cout << "Setting threshold to " << threshold_mC << " mC (" 
-              << (threshold_mC / 1000.0) << "°C)" << std::endl;
-    std::cout << std::endl;
-    
-    // Configure device for test
-    device.configure("sampling_ms", "100");
-    device.configure("threshold_mC", std::to_string(threshold_mC));
-    device.configure("mode", "ramp");
+void printRanking(const char* title, const std::vector<RankedSensor>& ranked,
+                  const std::vector<std::string>& paths) {
+    printf("%s:\n", title);
+    for (size_t i = 0; i < ranked.size(); ++i) {
+        printf("  %3zu. src %u (%s) temp=%s rise=%d mC/s\n", i + 1, ranked[i].device,
+               paths[ranked[i].device].c_str(), Temp(ranked[i].temp_mC).text,
+               ranked[i].rise_mC_per_s);
+    }
+}
+
+void topMode(SimTempDevice& device, const ReaderThreshold& fd_threshold, size_t k,
+             const std::string& source_list, double duration = -1.0) {
+    std::vector<std::string> paths;
+    std::vector<MergeSource*> sources;
+    std::vector<SimTempDevice*> devices;
+    bool live = openSources(device, fd_threshold, source_list, paths, sources, devices);
+    StreamMerger merger(50000000ULL);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        merger.addSource(sources[i], static_cast<uint32_t>(i));
+    }
+    SensorRanking ranking(k);
     
-    std::cout << "Waiting for threshold crossing event..." << std::endl;
-    std::cout << "Reading samples for up to 5 seconds..." << std::endl;
-    std::cout << std::endl;
+    printf("Ranking the top %zu of %zu sources every second of sample time...\n", k, paths.size());
+    if (live) {
+        printf("Press Ctrl+C to stop\n");
+    }
+    printf("\n");
+    fflush(stdout);
     
+    MergedBatch out;
+    std::vector<RankedSensor> ranked;
+    uint64_t next_report_ns = 0;
     auto start_time = std::chrono::steady_clock::now();
-    bool threshold_crossed = false;
     
-    while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() < 5.0) {
-        SimTempSample sample;
-        if (device.readSample(sample, 0.5)) {
-            printSample(sample);
-            
-            if (sample.flags & FLAG_THRESHOLD_CROSSED) {
-                threshold_crossed = true;
-                std::cout << "*** THRESHOLD CROSSED! ***" << std::endl;
+    while (!merger.finished()) {
+        auto now = std::chrono::steady_clock::now();
+        if (duration > 0.0 && std::chrono::duration<double>(now - start_time).count() >= duration) {
+            break;
+        }
+        
+        out.clear();
+        uint64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            now.time_since_epoch()).count();
+        if (merger.next(out, DEFAULT_CHUNK_SAMPLES, live ? now_ns : 0) == 0) {
+            if (!live) {
                 break;
             }
-        } else {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        
+        for (size_t i = 0; i < out.size(); ++i) {
+            uint64_t ts = out.samples.timestamp_ns[i];
+            if (ts >= next_report_ns) {
+                if (next_report_ns != 0) {
+                    printf("%s\n", Time(ts).text);
+                    ranking.hottest(ranked, true);
+                    printRanking("Hottest", ranked, paths);
+                    ranking.fastestRising(ranked, true);
+                    printRanking("Fastest rising", ranked, paths);
+                    printf("\n");
+                    fflush(stdout);
+                }
+                next_report_ns = ts + 1000000000ULL;
+            }
+            ranking.update(out.source[i], ts, out.samples.temp_mC[i]);
         }
     }
     
-    // Test result
-    if (threshold_crossed) {
-        std::cout << std::endl << "✓ TEST PASSED: Threshold crossing detected" << std::endl;
-        exit(0);
-    } else {
-        std::cout << std::endl << "✗ TEST FAILED: No threshold crossing detected within 5 seconds" << std::endl;
-        exit(1);
+    printf("Final ranking:\n");
+    ranking.hottest(ranked, true);
+    printRanking("Hottest", ranked, paths);
+    ranking.fastestRising(ranked, true);
+    printRanking("Fastest rising", ranked, paths);
+    
+    closeSources(sources, devices);
+}
+
+void printJitterSummary(const JitterAnalyzer& jitter) {
+    printf("intervals=%llu on_time=%llu gaps=%llu (missed %llu) dup=%llu back=%llu"
+           " | dev mean=%.1f us sd=%.1f us p50=%.1f us p99=%.1f us",
+           ull(jitter.intervalCount()), ull(jitter.onTimeCount()), ull(jitter.gapCount()),
+           ull(jitter.missedPeriods()), ull(jitter.duplicateCount()), ull(jitter.backwardsCount()),
+           jitter.meanDeviation() / 1000.0, jitter.stddevDeviation() / 1000.0,
+           jitter.percentileDeviation(0.5) / 1000.0, jitter.percentileDeviation(0.99) / 1000.0);
+    if (jitter.driftCount() > 0) {
+        printf(" drift=%.1f ppm", jitter.driftPoint(jitter.driftCount() - 1).drift_ppm);
     }
+    printf("\n");
+    fflush(stdout);
 }
 
-void showUsage(const char* program_name) {
-    std::cout << "Usage: " << program_name << " [OPTIONS]" << std::endl;
-    std::cout << std::endl;
-    std::cout << "Options:" << std::endl;
-    std::cout << "  --monitor [DURATION]    Monitor mode (optional duration in seconds)" << std::endl;
-    std::cout << "  --test [THRESHOLD]      Test mode (optional threshold in mC)" << std::endl;
-    std::cout << "  --config                Show current configuration" << std::endl;
-    std::cout << "  --stats                 Show device statistics" << std::endl;
-    std::cout << "  --set-sampling MS       Set sampling period (ms)" << std::endl;
-    std::cout << "  --set-threshold MC      Set threshold (mC)" << std::endl;
-    std::cout << "  --set-mode MODE         Set mode (normal/noisy/ramp)" << std::endl;
-    std::cout << "  --reset                 Reset all configuration to defaults" << std::endl;
-    std::cout << "  --help                  Show this help message" << std::endl;
-    std::cout << std::endl;
-    std::cout << "Default behavior: show a few samples" << std::endl;
+void jitterMode(SimTempDevice& device, double duration = -1.0) {
+    // The period follows sampling_ms; a change restarts the statistics
+    ConfigCache config_cache;
+    uint64_t period_ns = 100000000ULL;
+    if (config_cache.open()) {
+        period_ns = config_cache.config().sampling_ms * 1000000ULL;
+    }
+    JitterAnalyzer jitter((JitterConfig(period_ns)));
+    
+    printf("Analyzing inter-arrival times against a %llu ms period...\n", ull(period_ns / 1000000));
+    printf("Press Ctrl+C to stop\n\n");
+    fflush(stdout);
+    
+    SampleBatch batch;
+    auto start_time = std::chrono::steady_clock::now();
+    auto last_report = start_time;
+    
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        if (duration > 0.0 && std::chrono::duration<double>(now - start_time).count() >= duration) {
+            break;
+        }
+        
+        batch.clear();
+        ssize_t got = device.readBatch(batch, DEFAULT_CHUNK_SAMPLES, 1.0);
+        if (config_cache.pollFd() >= 0 &&
+            (config_cache.noteBatch(batch) || config_cache.poll(0)) &&
+            config_cache.config().sampling_ms * 1000000ULL != jitter.period()) {
+            printJitterSummary(jitter);
+            jitter.setPeriod(config_cache.config().sampling_ms * 1000000ULL);
+            printf("Period changed to %u ms, statistics restarted\n", config_cache.config().sampling_ms);
+        }
+        if (got > 0) {
+            jitter.process(batch);
+        }
+        
+        if (now - last_report >= std::chrono::seconds(1)) {
+            last_report = now;
+            printJitterSummary(jitter);
+        }
+    }
+    
+    printf("\nDeviation histogram (%g us buckets):\n", jitter.bucketWidth() / 1000.0);
+    if (jitter.underflow()) {
+        printf("  below: %llu\n", ull(jitter.underflow()));
+    }
+    for (size_t i = 0; i < jitter.bucketCount(); ++i) {
+        if (jitter.bucket(i)) {
+            printf("  %10g us: %llu\n", jitter.bucketLow(i) / 1000.0, ull(jitter.bucket(i)));
+        }
+    }
+    if (jitter.overflow()) {
+        printf("  above: %llu\n", ull(jitter.overflow()));
+    }
+    if (jitter.worstGap()) {
+        printf("Worst gap: %g ms\n", jitter.worstGap() / 1e6);
+    }
+    printf("Drift (mean interval per window):\n");
+    for (size_t i = 0; i < jitter.driftCount(); ++i) {
+        const DriftPoint& d = jitter.driftPoint(i);
+        printf("  %s %.3f ms (%.1f ppm)\n", Time(d.end_ns).text, d.mean_interval_ns / 1e6, d.drift_ppm);
+    }
 }
 
-int main(int argc, char* argv[]) {
-    SimTempDevice device;
+void exportArrowMode(const std::string& recording_path, const std::string& out_path) {
+    // "-" writes the stream format to stdout; a .arrows name selects the
+    // stream format too, anything else the memory-mappable file format
+    bool to_stdout = (out_path == "-");
+    bool stream = to_stdout ||
+        (out_path.size() > 7 && out_path.compare(out_path.size() - 7, 7, ".arrows") == 0);
+    FILE* status = to_stdout ? stderr : stdout;
     
-    // Check if device exists
-    if (access(DEVICE_PATH.c_str(), F_OK) != 0) {
-        std::cerr << "Error: Device " << DEVICE_PATH << " not found" << std::endl;
-        std::cerr << "Make sure the kernel module is loaded and device is created" << std::endl;
+    RecordingReader reader;
+    if (!reader.open(recording_path)) {
+        fprintf(stderr, "Failed to open %s: %s\n", recording_path.c_str(), strerror(errno));
+        exit(1);
+    }
+    
+    ArrowWriter writer;
+    bool opened = to_stdout ? writer.open(STDOUT_FILENO, ARROW_STREAM)
+                            : writer.open(out_path, stream ? ARROW_STREAM : ARROW_FILE);
+    if (!opened) {
+        fprintf(stderr, "Failed to create %s: %s\n", out_path.c_str(), strerror(errno));
+        exit(1);
+    }
+    
+    // Chunk columns go from the mapping straight into record batches;
+    // chunks failing their CRC are left out
+    size_t damaged_chunks = 0;
+    uint64_t damaged_samples = 0;
+    for (size_t i = 0; i < reader.chunkCount(); ++i) {
+        const RecordingChunk& chunk = reader.chunk(i);
+        if (!reader.chunkIntact(i)) {
+            damaged_chunks++;
+            damaged_samples += chunk.count;
+            continue;
+        }
+        if (!writer.append(chunk.timestamp_ns, chunk.temp_mC, chunk.flags, NULL, chunk.count)) {
+            fprintf(stderr, "Write failed: %s\n", strerror(errno));
+            exit(1);
+        }
+    }
+    if (!writer.close()) {
+        fprintf(stderr, "Write failed: %s\n", strerror(errno));
+        exit(1);
+    }
+    
+    fprintf(status, "Exported %llu samples in %zu record batches (%llu bytes, Arrow %s)\n",
+            ull(writer.rowsWritten()), writer.batchCount(), ull(writer.bytesWritten()),
+            stream ? "stream" : "file");
+    if (reader.trailingBytes()) {
+        fprintf(status, "Skipped %zu bytes of torn final chunk\n", reader.trailingBytes());
+    }
+    if (damaged_chunks) {
+        fprintf(status, "Skipped %zu chunks (%llu samples) failing their CRC\n", damaged_chunks,
+                ull(damaged_samples));
+    }
+}
+
+int verifyMode(const std::string& path, unsigned threads) {
+    RecordingReader reader;
+    if (!reader.open(path)) {
+        fprintf(stderr, "Failed to open %s: %s\n", path.c_str(), strerror(errno));
         return 1;
     }
     
-    if (!device.open()) {
+    VerifyReport report;
+    auto start_time = std::chrono::steady_clock::now();
+    bool intact = verifyRecording(reader, report, threads);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    
+    if (!report.checksummed) {
+        printf("%s was recorded without chunk checksums; nothing to verify\n", path.c_str());
         return 1;
     }
     
+    printf("Verified %zu chunks (%llu bytes) in %.3f ms", report.chunks, ull(report.bytes_checked),
+           elapsed * 1000.0);
+    if (elapsed > 0.0) {
+        printf(" (%.2f GB/s)", report.bytes_checked / elapsed / 1e9);
+    }
+    printf("\n");
+    
+    for (size_t i = 0; i < report.damaged.size(); ++i) {
+        const DamagedRange& d = report.damaged[i];
+        printf("DAMAGED bytes %llu-%llu (", ull(d.offset), ull(d.offset + d.length));
+        if (d.chunks) {
+            printf("%zu bad chunks", d.chunks);
+        } else {
+            printf("unparseable");
+        }
+        printf("): samples lost after ");
+        if (d.after_ns) {
+            printf("%llu ns", ull(d.after_ns));
+        } else {
+            printf("start");
+        }
+        printf(" and before ");
+        if (d.before_ns) {
+            printf("%llu ns\n", ull(d.before_ns));
+        } else {
+            printf("end\n");
+        }
+    }
+    if (report.trailing_bytes) {
+        printf("Torn final chunk: %llu trailing bytes\n", ull(report.trailing_bytes));
+    }
+    printf("%s: %zu bad chunks, %zu damaged ranges\n", intact ? "OK" : "DAMAGED",
+           report.damaged_chunks, report.damaged.size());
+    return intact ? 0 : 2;
+}
+
+// Scenario results, one line each; 0 when nothing failed
+int selfTestMode(const std::vector<std::string>& devices, const std::vector<std::string>& scenarios,
+                 const SelfTestOptions& options) {
+    if (devices.empty()) {
+        fprintf(stderr, "Error: no simtemp devices found\n");
+        fprintf(stderr, "Make sure the kernel module is loaded and device is created\n");
+        return 1;
+    }
+    printf("Self-test: %zu scenarios on %zu devices\n\n",
+           scenarios.empty() ? selfTestScenarios().size() : scenarios.size(), devices.size());
+    fflush(stdout);
+    
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<SelfTestResult> results = runSelfTests(devices, scenarios, options);
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    
+    size_t passed = 0;
+    size_t failed = 0;
+    size_t skipped = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const SelfTestResult& r = results[i];
+        const char* verdict = r.skipped ? "SKIP" : r.passed ? "PASS" : "FAIL";
+        printf("%-4s %-14s %-20s %8.1f ms  %s\n", verdict, r.scenario.c_str(), r.device.c_str(),
+               r.elapsed_ms, r.detail.c_str());
+        if (r.skipped) {
+            skipped++;
+        } else if (r.passed) {
+            passed++;
+        } else {
+            failed++;
+        }
+    }
+    printf("\n%zu passed, %zu failed, %zu skipped in %.1f ms\n", passed, failed, skipped, total_ms);
+    return failed ? 1 : 0;
+}
+
+// Instance numbers, or device nodes mapped to theirs; false on a bad entry
+bool parseSelection(const std::string& list, std::vector<uint32_t>& ids) {
+    std::vector<std::string> items = splitList(list);
+    for (size_t i = 0; i < items.size(); ++i) {
+        int id = -1;
+        if (items[i].compare(0, 5, "/dev/") == 0) {
+            id = instanceNumber(items[i]);
+        } else if (!items[i].empty() && items[i].find_first_not_of("0123456789") == std::string::npos) {
+            id = atoi(items[i].c_str());
+        }
+        if (id < 0 || static_cast<uint32_t>(id) >= AGGREGATE_MAX_DEVICES) {
+            fprintf(stderr, "Invalid instance: %s\n", items[i].c_str());
+            return false;
+        }
+        ids.push_back(static_cast<uint32_t>(id));
+    }
+    return !ids.empty();
+}
+
+// Every (or every selected) instance from the one aggregate node
+int aggregateMode(const std::vector<uint32_t>& selection, double duration = -1.0) {
+    AggregateReader reader;
+    if (!reader.open()) {
+        fprintf(stderr, "Failed to open %s: %s\n", AGGREGATE_PATH.c_str(), strerror(errno));
+        fprintf(stderr, "Make sure the module is loaded with aggregate=1\n");
+        return 1;
+    }
+    if (!selection.empty() && !reader.select(selection)) {
+        fprintf(stderr, "Failed to select instances: %s\n", strerror(errno));
+        return 1;
+    }
+    
+    if (selection.empty()) {
+        printf("Reading all instances from %s...\n", AGGREGATE_PATH.c_str());
+    } else {
+        printf("Reading %zu instances from %s...\n", selection.size(), AGGREGATE_PATH.c_str());
+    }
+    printf("Press Ctrl+C to stop\n\n");
+    fflush(stdout);
+    
+    MergedBatch out;
+    std::vector<bool> seen(AGGREGATE_MAX_DEVICES, false);
+    size_t instances = 0;
+    auto start_time = std::chrono::steady_clock::now();
+    
+    while (true) {
+        if (duration > 0.0) {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+            if (elapsed >= duration) {
+                break;
+            }
+        }
+        
+        out.clear();
+        ssize_t n = reader.read(out, DEFAULT_CHUNK_SAMPLES, 100);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "Read failed: %s\n", strerror(errno));
+            return 1;
+        }
+        for (size_t i = 0; i < out.size(); ++i) {
+            if (out.source[i] < AGGREGATE_MAX_DEVICES && !seen[out.source[i]]) {
+                seen[out.source[i]] = true;
+                instances++;
+            }
+        }
+        printMerged(out);
+    }
+    
+    uint64_t reads = reader.readCalls();
+    printf("\n%llu records from %zu instances in %llu reads (%.1f records/read)\n",
+           ull(reader.recordsRead()), instances, ull(reads),
+           reads ? static_cast<double>(reader.recordsRead()) / reads : 0.0);
+    RingStats ring;
+    if (reader.ringStats(ring)) {
+        printf("Ring: high watermark %u/%u, %llu overwritten\n", ring.high_watermark, ring.capacity,
+               ull(ring.overwritten));
+    }
+    return 0;
+}
+
+int testMode(const std::string& device_path, int32_t threshold_mC = 26000) {
+    printf("Running test mode...\n");
+    printf("Ramp mode with threshold %d mC (%g°C), waiting for a threshold crossing event...\n\n",
+           threshold_mC, threshold_mC / 1000.0);
+    fflush(stdout);
+    
+    SelfTestOptions options;
+    options.threshold_mC = threshold_mC;
+    SelfTestResult result = runSelfTests(std::vector<std::string>(1, device_path),
+                                         std::vector<std::string>(1, "threshold"), options)[0];
+    
+    if (result.passed) {
+        printf("✓ TEST PASSED: Threshold crossing detected, %s (%.1f ms)\n", result.detail.c_str(),
+               result.elapsed_ms);
+        return 0;
+    }
+    printf("✗ TEST FAILED: %s (%.1f ms)\n", result.detail.c_str(), result.elapsed_ms);
+    return 1;
+}
+
+void showUsage(const char* program_name) {
+    printf("Usage: %s [OPTIONS]\n", program_name);
+    printf("\n");
+    printf("Options:\n");
+    printf("  --monitor [DURATION]    Monitor mode (optional duration in seconds)\n");
+    printf("  --filter SPEC           With --monitor: smoothing chain, e.g. median:5,ema:0.2,kalman:100:250000\n");
+    printf("  --fd-threshold MC[:HYST] Alert on a private threshold (driver-evaluated, this fd only)\n");
+    printf("  --test [THRESHOLD]      Test mode (optional threshold in mC, default 26000)\n");
+    printf("  --selftest [SCEN,...]   Run functional scenarios concurrently across devices\n");
+    printf("                          (mode-normal, mode-noisy, mode-ramp, threshold, config-change, overflow)\n");
+    printf("  --devices DEV,...       With --selftest: instances to use (default: all simtemp devices)\n");
+    printf("  --aggregate [DURATION]  Read every instance in one stream from %s\n", AGGREGATE_PATH.c_str());
+    printf("  --select ID,...         With --aggregate: instance numbers (or /dev/simtempN) to include\n");
+    printf("  --record FILE [DURATION] Record batches to a recording file\n");
+    printf("  --predict HORIZON [DURATION] Predict threshold crossings, pre-alert within HORIZON s\n");
+    printf("  --resample SPEC [DURATION] Resample onto a grid: MS[:linear|:sinc[:N]]\n");
+    printf("                          (also the common grid for --correlate)\n");
+    printf("  --correlate SRC,... [DURATION] Sliding correlation matrix across sources\n");
+    printf("  --window N              With --correlate: rows per window (default 600)\n");
+    printf("  --publish N             With --correlate: print the matrix every N rows (default 100)\n");
+    printf("  --jitter [DURATION]     Inter-arrival jitter, gaps and period drift\n");
+    printf("  --top K SRC,... [DURATION] Rank the K hottest and fastest-rising sources\n");
+    printf("  --export-arrow REC OUT  Convert a recording to Arrow IPC (OUT .arrows or - for a stream)\n");
+    printf("  --verify REC [THREADS]  Check recording chunk CRCs in parallel, report damaged ranges\n");
+    printf("  --merge SRC,... [DURATION] Merge devices (/dev/...) and recordings by timestamp\n");
+    printf("  --reorder-ms MS         With --merge: reorder window for live sources (default 50)\n");
+    printf("  --checkpoint FILE       With --record: resume from/keep a checkpoint\n");
+    printf("  --handoff SOCK          With --record --checkpoint: take over from / hand over to a collector\n");
+    printf("  --sink-policy POLICY    With --record: block, drop-oldest, spill:MB or summarize\n");
+    printf("  --queue N               With --record: sink queue bound in batches (default 8)\n");
+    printf("  --config                Show current configuration\n");
+    printf("  --stats                 Show device statistics\n");
+    printf("  --first-sample          Print one sample and exit (startup timing)\n");
+    printf("  --watch-stats INTERVAL [DURATION] Show driver counter rates every INTERVAL s\n");
+    printf("  --set-sampling MS       Set sampling period (ms)\n");
+    printf("  --set-threshold MC      Set threshold (mC)\n");
+    printf("  --set-mode MODE         Set mode (normal/noisy/ramp)\n");
+    printf("  --reset                 Reset all configuration to defaults\n");
+    printf("  --help                  Show this help message\n");
+    printf("\n");
+    printf("Default behavior: show a few samples\n");
+}
+
+int main(int argc, char* argv[]) {
+    SimTempDevice device;
+    
     // Parse command line arguments
     bool show_config = false;
     bool show_stats = false;
     bool monitor = false;
     bool test = false;
+    bool selftest = false;
+    std::vector<std::string> selftest_scenarios;
+    std::vector<std::string> selftest_devices;
+    bool aggregate = false;
+    std::vector<uint32_t> aggregate_selection;
+    std::string record_path;
+    std::string checkpoint_path;
+    std::string handoff_path;
+    SinkConfig sink_config;
+    double predict_horizon = -1.0;
+    FilterChain filters;
+    double watch_interval = -1.0;
+    ReaderThreshold fd_threshold;
+    memset(&fd_threshold, 0, sizeof(fd_threshold));
+    bool first_sample = false;
+    std::string merge_sources;
+    ResamplerConfig resample_config;
+    bool resample = false;
+    double reorder_ms = 50.0;
+    std::string correlate_sources;
+    std::string top_sources;
+    bool jitter = false;
+    std::string arrow_input;
+    std::string arrow_output;
+    std::string verify_path;
+    unsigned verify_threads = 0;
+    size_t top_k = 20;
+    size_t corr_window = 600;
+    size_t corr_publish = 100;
     double duration = -1.0;
-    int32_t threshold = 30000;
+    int32_t threshold = 26000;
     std::string set_sampling;
     std::string set_threshold;
     std::string set_mode;
@@ -314,6 +1250,8 @@ int main(int argc, char* argv[]) {
             show_config = true;
         } else if (arg == "--stats") {
             show_stats = true;
+        } else if (arg == "--first-sample") {
+            first_sample = true;
         } else if (arg == "--monitor") {
             monitor = true;
             if (i + 1 < argc && argv[i + 1][0] != '-') {
@@ -324,6 +1262,119 @@ int main(int argc, char* argv[]) {
             if (i + 1 < argc && argv[i + 1][0] != '-') {
                 threshold = std::stoi(argv[++i]);
             }
+        } else if (arg == "--selftest") {
+            selftest = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                selftest_scenarios = splitList(argv[++i]);
+                for (size_t s = 0; s < selftest_scenarios.size(); ++s) {
+                    if (!isSelfTestScenario(selftest_scenarios[s])) {
+                        fprintf(stderr, "Unknown scenario: %s\n", selftest_scenarios[s].c_str());
+                        return 1;
+                    }
+                }
+            }
+        } else if (arg == "--devices" && i + 1 < argc) {
+            selftest_devices = splitList(argv[++i]);
+        } else if (arg == "--aggregate") {
+            aggregate = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                duration = std::stod(argv[++i]);
+            }
+        } else if (arg == "--select" && i + 1 < argc) {
+            if (!parseSelection(argv[++i], aggregate_selection)) {
+                return 1;
+            }
+        } else if (arg == "--record" && i + 1 < argc) {
+            record_path = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                duration = std::stod(argv[++i]);
+            }
+        } else if (arg == "--watch-stats" && i + 1 < argc) {
+            watch_interval = std::stod(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                duration = std::stod(argv[++i]);
+            }
+        } else if (arg == "--filter" && i + 1 < argc) {
+            if (!parseFilterChain(argv[++i], filters)) {
+                fprintf(stderr, "Invalid filter chain: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (arg == "--fd-threshold" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t colon = spec.find(':');
+            int hysteresis = colon == std::string::npos ? 0 : std::stoi(spec.substr(colon + 1));
+            if (hysteresis < 0) {
+                fprintf(stderr, "Invalid hysteresis: %s\n", spec.c_str());
+                return 1;
+            }
+            fd_threshold.threshold_mC = std::stoi(spec.substr(0, colon));
+            fd_threshold.hysteresis_mC = static_cast<uint32_t>(hysteresis);
+            fd_threshold.enabled = 1;
+        } else if (arg == "--predict" && i + 1 < argc) {
+            predict_horizon = std::stod(argv[++i]);
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                duration = std::stod(argv[++i]);
+            }
+        } else if (arg == "--resample" && i + 1 < argc) {
+            if (!parseResampleSpec(argv[++i], resample_config)) {
+                fprintf(stderr, "Invalid resample spec: %s\n", argv[i]);
+                return 1;
+            }
+            resample = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                duration = std::stod(argv[++i]);
+            }
+        } else if (arg == "--correlate" && i + 1 < argc) {
+            correlate_sources = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                duration = std::stod(argv[++i]);
+            }
+        } else if (arg == "--jitter") {
+            jitter = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                duration = std::stod(argv[++i]);
+            }
+        } else if (arg == "--top" && i + 2 < argc) {
+            int k = std::stoi(argv[++i]);
+            top_k = k > 0 ? k : 1;
+            top_sources = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                duration = std::stod(argv[++i]);
+            }
+        } else if (arg == "--window" && i + 1 < argc) {
+            int rows = std::stoi(argv[++i]);
+            corr_window = rows > 1 ? rows : 2;
+        } else if (arg == "--publish" && i + 1 < argc) {
+            int rows = std::stoi(argv[++i]);
+            corr_publish = rows > 0 ? rows : 1;
+        } else if (arg == "--export-arrow" && i + 2 < argc) {
+            arrow_input = argv[++i];
+            arrow_output = argv[++i];
+        } else if (arg == "--verify" && i + 1 < argc) {
+            verify_path = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                int threads = std::stoi(argv[++i]);
+                verify_threads = threads > 0 ? threads : 0;
+            }
+        } else if (arg == "--merge" && i + 1 < argc) {
+            merge_sources = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                duration = std::stod(argv[++i]);
+            }
+        } else if (arg == "--reorder-ms" && i + 1 < argc) {
+            reorder_ms = std::stod(argv[++i]);
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            checkpoint_path = argv[++i];
+        } else if (arg == "--handoff" && i + 1 < argc) {
+            handoff_path = argv[++i];
+        } else if (arg == "--sink-policy" && i + 1 < argc) {
+            if (!parseSinkPolicy(argv[++i], sink_config)) {
+                fprintf(stderr, "Invalid sink policy: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (arg == "--queue" && i + 1 < argc) {
+            int max_batches = std::stoi(argv[++i]);
+            sink_config.max_batches = max_batches > 0 ? max_batches : 1;
         } else if (arg == "--set-sampling" && i + 1 < argc) {
             set_sampling = argv[++i];
         } else if (arg == "--set-threshold" && i + 1 < argc) {
@@ -333,51 +1384,71 @@ int main(int argc, char* argv[]) {
         } else if (arg == "--reset") {
             reset = true;
         } else {
-            std::cerr << "Unknown option: " << arg << std::endl;
+            fprintf(stderr, "Unknown option: %s\n", arg.c_str());
             showUsage(argv[0]);
             return 1;
         }
     }
     
+    // Offline conversion and verification need no device
+    if (!arrow_input.empty()) {
+        exportArrowMode(arrow_input, arrow_output);
+        return 0;
+    }
+    if (!verify_path.empty()) {
+        return verifyMode(verify_path, verify_threads);
+    }
+    
+    // Scenarios open their own instances
+    if (selftest) {
+        return selfTestMode(selftest_devices.empty() ? findDevices() : selftest_devices,
+                            selftest_scenarios, SelfTestOptions());
+    }
+    if (aggregate) {
+        return aggregateMode(aggregate_selection, duration);
+    }
+    
     try {
-        // Handle configuration commands
+        // Configuration goes through sysfs; the device node is not opened
         if (show_config) {
-            std::cout << "Current configuration:" << std::endl;
-            std::cout << "  sampling_ms: " << device.getConfig("sampling_ms") << std::endl;
-            std::cout << "  threshold_mC: " << device.getConfig("threshold_mC") << std::endl;
-            std::cout << "  mode: " << device.getConfig("mode") << std::endl;
+            printf("Current configuration:\n");
+            printf("  sampling_ms: %s\n", device.getConfig("sampling_ms").c_str());
+            printf("  threshold_mC: %s\n", device.getConfig("threshold_mC").c_str());
+            printf("  mode: %s\n", device.getConfig("mode").c_str());
             return 0;
         }
         
         if (show_stats) {
-            std::cout << "Device statistics:" << std::endl;
-            std::cout << "  " << device.getStats() << std::endl;
+            printf("Device statistics:\n");
+            printf("  %s\n", device.getStats().c_str());
+            printf("Ring buffer:\n");
+            printf("  %s\n", device.getConfig("ring").c_str());
             return 0;
         }
         
         // Handle configuration changes
         if (!set_sampling.empty()) {
             device.configure("sampling_ms", set_sampling);
-            std::cout << "Sampling period set to " << set_sampling << " ms" << std::endl;
+            printf("Sampling period set to %s ms\n", set_sampling.c_str());
         }
         if (!set_threshold.empty()) {
             device.configure("threshold_mC", set_threshold);
-            std::cout << "Threshold set to " << set_threshold << " mC" << std::endl;
+            printf("Threshold set to %s mC\n", set_threshold.c_str());
         }
         if (!set_mode.empty()) {
             device.configure("mode", set_mode);
-            std::cout << "Mode set to " << set_mode << std::endl;
+            printf("Mode set to %s\n", set_mode.c_str());
         }
         
         if (reset) {
-            std::cout << "Resetting configuration to defaults..." << std::endl;
+            printf("Resetting configuration to defaults...\n");
             device.configure("sampling_ms", "100");
             device.configure("threshold_mC", "45000");
             device.configure("mode", "normal");
-            std::cout << "Configuration reset to defaults:" << std::endl;
-            std::cout << "  sampling_ms: 100" << std::endl;
-            std::cout << "  threshold_mC: 45000" << std::endl;
-            std::cout << "  mode: normal" << std::endl;
+            printf("Configuration reset to defaults:\n");
+            printf("  sampling_ms: 100\n");
+            printf("  threshold_mC: 45000\n");
+            printf("  mode: normal\n");
             return 0;
         }
         
@@ -385,14 +1456,48 @@ int main(int argc, char* argv[]) {
             return 0;
         }
         
-        // Handle modes
+        // The test scenario opens its own file
         if (test) {
-            testMode(device, threshold);
+            return testMode(device.path(), threshold);
+        }
+        
+        // Multi-source modes open the device only if it is one of the sources
+        bool multi_source = !top_sources.empty() || !correlate_sources.empty() || !merge_sources.empty();
+        if ((watch_interval > 0.0 || jitter || !multi_source) && !openDevice(device, fd_threshold)) {
+            return 1;
+        }
+        
+        // Handle modes
+        if (watch_interval > 0.0) {
+            watchStatsMode(device, watch_interval, duration);
+        } else if (jitter) {
+            jitterMode(device, duration);
+        } else if (!top_sources.empty()) {
+            topMode(device, fd_threshold, top_k, top_sources, duration);
+        } else if (!correlate_sources.empty()) {
+            correlateMode(device, fd_threshold, correlate_sources, resample_config, corr_window,
+                          corr_publish, duration);
+        } else if (resample) {
+            resampleMode(device, resample_config, duration);
+        } else if (!merge_sources.empty()) {
+            mergeMode(device, fd_threshold, merge_sources, reorder_ms, duration);
+        } else if (predict_horizon > 0.0) {
+            predictMode(device, predict_horizon, duration);
+        } else if (!record_path.empty() && !checkpoint_path.empty()) {
+            checkpointedRecordMode(device, record_path, checkpoint_path, handoff_path, duration);
+        } else if (!record_path.empty()) {
+            recordMode(device, record_path, sink_config, duration);
         } else if (monitor) {
-            monitorMode(device, duration);
+            monitorMode(device, duration, filters.empty() ? NULL : &filters);
+        } else if (first_sample) {
+            SimTempSample sample;
+            if (!device.readSample(sample, 5.0)) {
+                return 1;
+            }
+            printSample(sample);
         } else {
             // Default: show a few samples
-            std::cout << "Reading temperature samples..." << std::endl;
+            printf("Reading temperature samples...\n");
             auto samples = device.readSamples(5, 2.0);
             for (const auto& sample : samples) {
                 printSample(sample);
@@ -400,7 +1505,7 @@ int main(int argc, char* argv[]) {
         }
         
     } catch (const std::exception& e) {
-        std::cerr << "Error: " << e.what() << std::endl;
+        fprintf(stderr, "Error: %s\n", e.what());
         return 1;
     }
     
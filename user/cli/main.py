@@ -11,6 +11,7 @@ import sys
 import time
 import struct
 import select
+import asyncio
 import argparse
 from datetime import datetime
 from typing import Optional, Tuple
@@ -27,6 +28,18 @@ SAMPLE_SIZE = struct.calcsize(SAMPLE_FORMAT)
 FLAG_NEW_SAMPLE = 0x01
 FLAG_THRESHOLD_CROSSED = 0x02
 
+# Native libsimtemp binding (optional). Built into out/user/lib by
+# user/libsimtemp/Makefile; pure-Python decoding is used when it is missing.
+try:
+    import _simtemp
+except ImportError:
+    sys.path.append(os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                 "..", "..", "out", "user", "lib"))
+    try:
+        import _simtemp
+    except ImportError:
+        _simtemp = None
+
 class SimTempError(Exception):
     """Exception raised for SimTemp related errors"""
     pass
@@ -95,6 +108,9 @@ class SimTempDevice:
         Returns:
             List of (timestamp_ns, temp_mC, flags) tuples
         """
+        if _simtemp is not None and self.device_fd is not None:
+            return self._read_samples_native(count, timeout)
+        
         samples = []
         for _ in range(count):
             try:
@@ -105,6 +121,22 @@ class SimTempDevice:
                 break
         return samples
     
+    def _read_samples_native(self, count: int, timeout: Optional[float]) -> list:
+        """Batched read through libsimtemp: one syscall per ready batch"""
+        samples = []
+        while len(samples) < count:
+            try:
+                batch = _simtemp.read_batch(self.device_fd, count - len(samples),
+                                            timeout if timeout is not None else -1.0)
+            except OSError as e:
+                print(f"Warning: Read error: {e}", file=sys.stderr)
+                break
+            if len(batch) == 0:
+                print("Warning: Read timeout", file=sys.stderr)
+                break
+            samples.extend(zip(batch.timestamps, batch.temps, batch.flags))
+        return samples
+    
     def configure(self, **kwargs) -> None:
         """
         Configure the device via sysfs
@@ -174,6 +206,133 @@ class SimTempDevice:
                 return stats
         except (OSError, IOError) as e:
             raise SimTempError(f"Failed to read stats: {e}")
+    
+    def get_ring(self) -> dict:
+        """Get ring buffer occupancy (empty if the driver has no ring telemetry)"""
+        ring_path = os.path.join(self.sysfs_base, 'ring')
+        try:
+            with open(ring_path, 'r') as f:
+                # Parse "depth=X capacity=Y high_watermark=Z high_ms=W overwritten=V"
+                return dict(part.split('=', 1) for part in f.read().split() if '=' in part)
+        except (OSError, IOError):
+            return {}
+
+class AsyncSimTempDevice:
+    """
+    Asyncio interface to the NXP Simulated Temperature Sensor device
+
+    The nonblocking device fd is registered with the event loop through
+    loop.add_reader(). Each readiness callback drains up to max_batch samples
+    into one batch and hands it to a bounded queue. When the queue is full the
+    reader is removed from the loop until the consumer catches up, so a slow
+    consumer leaves samples in the kernel ring instead of growing memory.
+    """
+
+    def __init__(self, device_path: str = DEVICE_PATH, max_batch: int = 64,
+                 queue_size: int = 16):
+        self.device_path = device_path
+        self.device_fd = None
+        self.max_batch = max_batch
+        self.queue: Optional[asyncio.Queue] = None
+        self.loop: Optional[asyncio.AbstractEventLoop] = None
+        self.queue_size = queue_size
+        self.reading = False
+        self.error: Optional[SimTempError] = None
+        self.batches = 0
+        self.samples = 0
+        self.pauses = 0
+
+    def open(self) -> None:
+        """Open the device and register it with the running event loop"""
+        try:
+            self.device_fd = os.open(self.device_path, os.O_RDONLY | os.O_NONBLOCK)
+        except OSError as e:
+            raise SimTempError(f"Failed to open device {self.device_path}: {e}")
+        self.loop = asyncio.get_running_loop()
+        self.queue = asyncio.Queue(maxsize=self.queue_size)
+        self._resume()
+
+    def close(self) -> None:
+        """Unregister from the event loop and close the device"""
+        self._pause()
+        if self.device_fd is not None:
+            os.close(self.device_fd)
+            self.device_fd = None
+
+    def _resume(self) -> None:
+        if not self.reading and self.device_fd is not None and self.error is None:
+            self.loop.add_reader(self.device_fd, self._on_readable)
+            self.reading = True
+
+    def _pause(self) -> None:
+        if self.reading:
+            self.loop.remove_reader(self.device_fd)
+            self.reading = False
+
+    def _drain(self) -> list:
+        """Read up to max_batch samples without blocking"""
+        if _simtemp is not None:
+            native = _simtemp.read_batch(self.device_fd, self.max_batch)
+            return list(zip(native.timestamps, native.temps, native.flags))
+        
+        batch = []
+        while len(batch) < self.max_batch:
+            try:
+                data = os.read(self.device_fd, SAMPLE_SIZE * (self.max_batch - len(batch)))
+            except BlockingIOError:
+                break
+            if len(data) < SAMPLE_SIZE:
+                break
+            usable = len(data) - (len(data) % SAMPLE_SIZE)
+            batch.extend(struct.iter_unpack(SAMPLE_FORMAT, data[:usable]))
+        return batch
+
+    def _on_readable(self) -> None:
+        try:
+            batch = self._drain()
+        except OSError as e:
+            self.error = SimTempError(f"Read error on {self.device_path}: {e}")
+            self._pause()
+            if not self.queue.full():
+                self.queue.put_nowait(None)  # wake a waiting consumer
+            return
+
+        if batch:
+            self.queue.put_nowait(batch)
+            self.batches += 1
+            self.samples += len(batch)
+
+        # Backpressure: stop watching the fd until a batch is consumed
+        if self.queue.full():
+            self._pause()
+            self.pauses += 1
+
+    async def read_batch(self) -> list:
+        """
+        Wait for the next batch of samples
+
+        Returns:
+            List of (timestamp_ns, temp_mC, flags) tuples (never empty)
+        """
+        if self.queue is None:
+            raise SimTempError("Device not open")
+        if self.error is not None and self.queue.empty():
+            raise self.error
+
+        batch = await self.queue.get()
+        if batch is None:
+            raise self.error
+        self._resume()
+        return batch
+
+    def __aiter__(self):
+        return self
+
+    async def __anext__(self) -> list:
+        try:
+            return await self.read_batch()
+        except SimTempError:
+            raise StopAsyncIteration
 
 def format_temperature(temp_mC: int) -> str:
     """Format temperature in milli-Celsius to a readable string"""
@@ -265,6 +424,42 @@ def test_mode(device: SimTempDevice, threshold_mC: int = 30000) -> None:
         print("\n✗ TEST FAILED: No threshold crossing detected within 5 seconds")
         sys.exit(1)
 
+async def watch_devices(paths: list, duration: Optional[float] = None) -> None:
+    """Monitor several devices concurrently on a single event loop"""
+    devices = [AsyncSimTempDevice(path) for path in paths]
+
+    async def consume(device: AsyncSimTempDevice) -> None:
+        async for batch in device:
+            for timestamp_ns, temp_mC, flags in batch:
+                print(f"{device.device_path} ", end="")
+                print_sample(timestamp_ns, temp_mC, flags)
+
+    # Close whatever was opened, also when a later device fails to open
+    opened = []
+    tasks = []
+    try:
+        for device in devices:
+            opened.append(device)
+            device.open()
+
+        print(f"Watching {len(devices)} device(s)...")
+        print("Press Ctrl+C to stop")
+        print()
+
+        tasks = [asyncio.create_task(consume(device)) for device in devices]
+        await asyncio.wait(tasks, timeout=duration)
+    finally:
+        for task in tasks:
+            task.cancel()
+        await asyncio.gather(*tasks, return_exceptions=True)
+        for device in opened:
+            if tasks:
+                if device.error is not None:
+                    print(f"Error: {device.error}", file=sys.stderr)
+                print(f"{device.device_path}: batches={device.batches} "
+                      f"samples={device.samples} pauses={device.pauses}")
+            device.close()
+
 def main():
     """Main function"""
     parser = argparse.ArgumentParser(description="NXP Simulated Temperature Sensor CLI")
@@ -272,6 +467,8 @@ def main():
     parser.add_argument("--monitor", action="store_true", help="Monitor mode")
     parser.add_argument("--test", action="store_true", help="Test mode")
     parser.add_argument("--duration", type=float, help="Duration for monitor mode (seconds)")
+    parser.add_argument("--watch", nargs="+", metavar="DEVICE",
+                        help="Monitor several devices concurrently (asyncio)")
     parser.add_argument("--threshold", type=int, default=30000, help="Threshold for test mode (mC)")
     parser.add_argument("--config", action="store_true", help="Show current configuration")
     parser.add_argument("--stats", action="store_true", help="Show device statistics")
@@ -282,6 +479,16 @@ def main():
     
     args = parser.parse_args()
     
+    if args.watch:
+        try:
+            asyncio.run(watch_devices(args.watch, args.duration))
+        except SimTempError as e:
+            print(f"Error: {e}", file=sys.stderr)
+            sys.exit(1)
+        except KeyboardInterrupt:
+            print("\nMonitoring stopped by user")
+        return
+    
     # Check if device exists
     if not os.path.exists(args.device):
         print(f"Error: Device {args.device} not found", file=sys.stderr)
@@ -306,6 +513,11 @@ def main():
             print("Device statistics:")
             for key, value in stats.items():
                 print(f"  {key}: {value}")
+            ring = device.get_ring()
+            if ring:
+                print("Ring buffer:")
+                for key, value in ring.items():
+                    print(f"  {key}: {value}")
             return
         
         # Handle reset command
@@ -0,0 +1,140 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Aggregate node reader.
+ */
+
+#include "aggregate.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+
+namespace simtemp {
+
+// Records transferred per read() call (16 KiB)
+static const size_t AGG_READ_CHUNK = 512;
+
+int instanceNumber(const std::string& device_path) {
+    const std::string prefix = "/dev/simtemp";
+    if (device_path.compare(0, prefix.size(), prefix) != 0) {
+        return -1;
+    }
+    std::string suffix = device_path.substr(prefix.size());
+    if (suffix.empty()) {
+        return 0;
+    }
+    if (suffix.find_first_not_of("0123456789") != std::string::npos || suffix.size() > 9) {
+        return -1;
+    }
+    return atoi(suffix.c_str());
+}
+
+std::string instancePath(uint32_t id) {
+    return id == 0 ? DEVICE_PATH : DEVICE_PATH + std::to_string(id);
+}
+
+AggregateReader::AggregateReader() : fd(-1), reads(0), records(0) {}
+
+AggregateReader::~AggregateReader() {
+    close();
+}
+
+bool AggregateReader::open(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    return fd >= 0;
+}
+
+void AggregateReader::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool AggregateReader::select(const std::vector<uint32_t>& ids) {
+    AggregateSelect selection;
+    memset(&selection, 0, sizeof(selection));
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (ids[i] >= AGGREGATE_MAX_DEVICES) {
+            errno = EINVAL;
+            return false;
+        }
+        selection.mask[ids[i] / 64] |= 1ULL << (ids[i] % 64);
+    }
+    return ioctl(fd, SIMTEMP_IOC_SET_SELECT, &selection) == 0;
+}
+
+bool AggregateReader::selectAll() {
+    AggregateSelect selection;
+    memset(&selection, 0, sizeof(selection));
+    selection.all = 1;
+    return ioctl(fd, SIMTEMP_IOC_SET_SELECT, &selection) == 0;
+}
+
+ssize_t AggregateReader::read(MergedBatch& out, size_t max_samples, int timeout_ms) {
+    if (max_samples == 0) {
+        return 0;
+    }
+
+    if (timeout_ms >= 0) {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int ret = poll(&pfd, 1, timeout_ms);
+        if (ret == 0) {
+            return 0;
+        } else if (ret < 0) {
+            return -1;
+        }
+    }
+
+    SimTempSampleTagged chunk[AGG_READ_CHUNK];
+    size_t total = 0;
+
+    while (total < max_samples) {
+        size_t want = max_samples - total;
+        if (want > AGG_READ_CHUNK) {
+            want = AGG_READ_CHUNK;
+        }
+
+        ssize_t bytes_read = ::read(fd, chunk, want * sizeof(SimTempSampleTagged));
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return total > 0 ? static_cast<ssize_t>(total) : -1;
+        }
+        reads++;
+
+        size_t got = static_cast<size_t>(bytes_read) / sizeof(SimTempSampleTagged);
+        if (got == 0) {
+            break;
+        }
+        for (size_t i = 0; i < got; ++i) {
+            out.samples.timestamp_ns.push_back(chunk[i].timestamp_ns);
+            out.samples.temp_mC.push_back(chunk[i].temp_mC);
+            out.samples.flags.push_back(chunk[i].flags);
+            out.samples.seq.push_back(chunk[i].seq);
+            out.source.push_back(chunk[i].device_id);
+        }
+        total += got;
+        if (got < want) {
+            break;
+        }
+    }
+
+    records += total;
+    return static_cast<ssize_t>(total);
+}
+
+} // namespace simtemp
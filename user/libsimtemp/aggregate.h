@@ -0,0 +1,74 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Reader for the driver's aggregate node (/dev/simtemp-all). The driver
+ * copies every sample of the selected instances, tagged with the instance
+ * number, into a ring of the open file, and wakes it once per timer pass
+ * whatever the number of instances due. One poll() and one read() then
+ * collect a whole board instead of one of each per instance. Records come
+ * in production order: per instance in sequence order, interleaved across
+ * instances by expiry. The per-instance seq gives gaps as with a device.
+ */
+
+#ifndef SIMTEMP_AGGREGATE_H
+#define SIMTEMP_AGGREGATE_H
+
+#include "simtemp.h"
+#include "merge.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+// Instance number of a device node: "/dev/simtemp" 0, "/dev/simtemp7" 7,
+// -1 for anything else
+int instanceNumber(const std::string& device_path);
+
+// Device node of an instance number
+std::string instancePath(uint32_t id);
+
+class AggregateReader {
+private:
+    int fd;
+    uint64_t reads;
+    uint64_t records;
+
+    AggregateReader(const AggregateReader&);
+    AggregateReader& operator=(const AggregateReader&);
+
+public:
+    AggregateReader();
+    ~AggregateReader();
+
+    // Opened nonblocking; every instance is selected
+    bool open(const std::string& path = AGGREGATE_PATH);
+    void close();
+
+    // Feed only these instance numbers (below AGGREGATE_MAX_DEVICES) from now on
+    bool select(const std::vector<uint32_t>& ids);
+    bool selectAll();
+
+    /*
+     * Append up to max_samples records to out, source = instance number.
+     * Waits up to timeout_ms for the first record (0: no wait, negative:
+     * no poll), then drains what is ready. Returns the number appended,
+     * 0 on timeout, -1 on error (errno is preserved).
+     */
+    ssize_t read(MergedBatch& out, size_t max_samples, int timeout_ms = -1);
+
+    // This file's ring, and POLLRDBAND once level records are queued
+    bool ringStats(RingStats& stats) { return getRingStats(fd, stats); }
+    bool setFillLevel(uint32_t level) { return simtemp::setFillLevel(fd, level); }
+
+    bool isOpen() const { return fd >= 0; }
+    int fileDescriptor() const { return fd; }
+    uint64_t readCalls() const { return reads; }
+    uint64_t recordsRead() const { return records; }
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_AGGREGATE_H
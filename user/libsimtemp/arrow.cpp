@@ -0,0 +1,499 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Arrow IPC writer. The flatbuffer metadata (Message, Schema, RecordBatch,
+ * Footer) is produced by a minimal front-to-back builder: a table is laid
+ * out right after its vtable, and children are appended afterwards with
+ * the parent's offset fields patched to point forward at them.
+ */
+
+#include "arrow.h"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+
+namespace simtemp {
+
+static const char ARROW_MAGIC[8] = {'A', 'R', 'R', 'O', 'W', '1', 0, 0};
+static const uint32_t CONTINUATION = 0xffffffff;
+static const size_t BODY_ALIGN = 64;
+static const uint8_t ZERO_PAD[BODY_ALIGN] = {0};
+
+// Schema.fbs / Message.fbs / File.fbs enums and field ids used below
+static const int16_t METADATA_V5 = 4;
+static const uint8_t HEADER_SCHEMA = 1;
+static const uint8_t HEADER_RECORD_BATCH = 3;
+static const uint8_t TYPE_INT = 2;
+
+struct ArrowColumn {
+    const char* name;
+    int32_t bit_width;
+    bool is_signed;
+};
+
+static const ArrowColumn COLUMNS[] = {
+    { "timestamp_ns", 64, false },
+    { "temp_mC", 32, true },
+    { "flags", 32, false },
+    { "seq", 64, false },
+};
+static const size_t COLUMN_COUNT = sizeof(COLUMNS) / sizeof(COLUMNS[0]);
+
+class FlatBuilder {
+public:
+    struct Field {
+        uint16_t id;
+        uint8_t size;           // 1, 2, 4 or 8 bytes
+        uint64_t value;         // scalar value (little-endian)
+        bool is_offset;         // uoffset to a child, patched later
+        size_t pos;             // set by table(): buffer position of the field
+    };
+
+    std::vector<uint8_t> buf;
+
+    // Room for the root offset
+    FlatBuilder() : buf(4, 0) {}
+
+    void pad(size_t align) {
+        while (buf.size() % align) {
+            buf.push_back(0);
+        }
+    }
+
+    template <typename T>
+    void put(T value) {
+        size_t at = buf.size();
+        buf.resize(at + sizeof(T));
+        memcpy(&buf[at], &value, sizeof(T));
+    }
+
+    // uoffsets are unsigned and relative to the field itself
+    void patch(size_t field_pos, size_t target) {
+        uint32_t rel = static_cast<uint32_t>(target - field_pos);
+        memcpy(&buf[field_pos], &rel, sizeof(rel));
+    }
+
+    size_t table(Field* fields, size_t n) {
+        // Widest fields first after the soffset, so each is naturally aligned
+        uint16_t slots = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (fields[i].id + 1 > slots) {
+                slots = fields[i].id + 1;
+            }
+        }
+        std::vector<uint16_t> where(slots, 0);
+        std::vector<uint16_t> local(n, 0);
+        uint16_t end = 4;
+        for (uint8_t size = 8; size >= 1; size /= 2) {
+            for (size_t i = 0; i < n; ++i) {
+                uint8_t width = fields[i].is_offset ? 4 : fields[i].size;
+                if (width != size) {
+                    continue;
+                }
+                end = (end + size - 1) & ~(size - 1);
+                local[i] = end;
+                where[fields[i].id] = end;
+                end += size;
+            }
+        }
+        end = (end + 3) & ~3;
+
+        pad(2);
+        size_t vtable = buf.size();
+        put<uint16_t>(static_cast<uint16_t>(4 + 2 * slots));
+        put<uint16_t>(end);
+        for (uint16_t s = 0; s < slots; ++s) {
+            put<uint16_t>(where[s]);
+        }
+
+        // Field offsets are aligned relative to an 8-byte aligned table start
+        pad(8);
+        size_t table_pos = buf.size();
+        put<int32_t>(static_cast<int32_t>(table_pos - vtable));
+        buf.resize(table_pos + end, 0);
+        for (size_t i = 0; i < n; ++i) {
+            fields[i].pos = table_pos + local[i];
+            if (!fields[i].is_offset) {
+                memcpy(&buf[fields[i].pos], &fields[i].value, fields[i].size);
+            }
+        }
+        return table_pos;
+    }
+
+    // Vector length followed by elements aligned to elem_align; returns the
+    // position of the length field (what offsets point at)
+    size_t vector(uint32_t count, size_t elem_align) {
+        pad(4);
+        while ((buf.size() + 4) % elem_align) {
+            put<uint32_t>(0);
+        }
+        size_t pos = buf.size();
+        put<uint32_t>(count);
+        return pos;
+    }
+
+    size_t string(const char* s) {
+        size_t len = strlen(s);
+        size_t pos = vector(static_cast<uint32_t>(len), 4);
+        buf.insert(buf.end(), s, s + len + 1);
+        return pos;
+    }
+
+    void finish(size_t root) {
+        patch(0, root);
+        pad(8);
+    }
+};
+
+static FlatBuilder::Field scalar(uint16_t id, uint8_t size, uint64_t value) {
+    FlatBuilder::Field f = { id, size, value, false, 0 };
+    return f;
+}
+
+static FlatBuilder::Field child(uint16_t id) {
+    FlatBuilder::Field f = { id, 4, 0, true, 0 };
+    return f;
+}
+
+// Schema { endianness: Little, fields: [Field] }
+static size_t buildSchema(FlatBuilder& b) {
+    FlatBuilder::Field schema[] = { scalar(0, 2, 0), child(1) };
+    size_t schema_pos = b.table(schema, 2);
+
+    size_t fields_pos = b.vector(COLUMN_COUNT, 4);
+    b.patch(schema[1].pos, fields_pos);
+    std::vector<size_t> slot(COLUMN_COUNT);
+    for (size_t i = 0; i < COLUMN_COUNT; ++i) {
+        slot[i] = b.buf.size();
+        b.put<uint32_t>(0);
+    }
+
+    for (size_t i = 0; i < COLUMN_COUNT; ++i) {
+        // Field { name, nullable: false, type_type: Int, type, children: [] }
+        FlatBuilder::Field field[] = {
+            child(0), scalar(1, 1, 0), scalar(2, 1, TYPE_INT), child(3), child(5)
+        };
+        size_t field_pos = b.table(field, 5);
+        b.patch(slot[i], field_pos);
+        b.patch(field[0].pos, b.string(COLUMNS[i].name));
+
+        FlatBuilder::Field type[] = {
+            scalar(0, 4, static_cast<uint32_t>(COLUMNS[i].bit_width)),
+            scalar(1, 1, COLUMNS[i].is_signed ? 1 : 0)
+        };
+        b.patch(field[3].pos, b.table(type, 2));
+        b.patch(field[4].pos, b.vector(0, 4));
+    }
+    return schema_pos;
+}
+
+// Message { version: V5, header_type, header, bodyLength }; returns the
+// header's offset field position for the caller to patch
+static size_t buildMessage(FlatBuilder& b, uint8_t header_type, uint64_t body_length) {
+    FlatBuilder::Field message[] = {
+        scalar(0, 2, METADATA_V5), scalar(1, 1, header_type), child(2), scalar(3, 8, body_length)
+    };
+    b.finish(b.table(message, 4));
+    return message[2].pos;
+}
+
+static bool writeFully(int fd, struct iovec* iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t n = ::writev(fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        size_t done = static_cast<size_t>(n);
+        while (iovcnt > 0 && done >= iov->iov_len) {
+            done -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + done;
+            iov->iov_len -= done;
+        }
+    }
+    return true;
+}
+
+static size_t padTo(size_t n, size_t align) {
+    return (n + align - 1) & ~(align - 1);
+}
+
+ArrowWriter::ArrowWriter(uint32_t batch_rows)
+    : fd(-1), owns_fd(false), format(ARROW_FILE),
+      batch_rows(batch_rows ? batch_rows : ARROW_DEFAULT_BATCH_ROWS), offset(0),
+      rows_written(0) {}
+
+ArrowWriter::~ArrowWriter() {
+    close();
+}
+
+bool ArrowWriter::open(const std::string& path, ArrowFormat fmt) {
+    close();
+
+    int file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file < 0) {
+        return false;
+    }
+    fd = file;
+    owns_fd = true;
+    format = fmt;
+    return start();
+}
+
+bool ArrowWriter::open(int out_fd, ArrowFormat fmt) {
+    close();
+
+    fd = out_fd;
+    owns_fd = false;
+    format = fmt;
+    return start();
+}
+
+bool ArrowWriter::start() {
+    offset = 0;
+    rows_written = 0;
+    blocks.clear();
+    pending.clear();
+    pending.reserve(batch_rows);
+
+    if (format == ARROW_FILE) {
+        struct iovec iov = { const_cast<char*>(ARROW_MAGIC), sizeof(ARROW_MAGIC) };
+        if (!writeFully(fd, &iov, 1)) {
+            return false;
+        }
+        offset += sizeof(ARROW_MAGIC);
+    }
+
+    FlatBuilder b;
+    size_t header = buildMessage(b, HEADER_SCHEMA, 0);
+    b.patch(header, buildSchema(b));
+    b.pad(8);
+    return writeMessage(b.buf, NULL, NULL, 0, 0);
+}
+
+bool ArrowWriter::writeMessage(const std::vector<uint8_t>& metadata, const void* const* buffers,
+                               const size_t* lengths, size_t count, uint64_t body_length) {
+    // Pad the metadata so the body starts on a BODY_ALIGN file offset
+    uint64_t body_start = padTo(offset + 8 + metadata.size(), count ? BODY_ALIGN : 8);
+    uint32_t prefix[2] = { CONTINUATION, static_cast<uint32_t>(body_start - offset - 8) };
+
+    std::vector<struct iovec> iov;
+    iov.reserve(3 + 2 * count);
+    struct iovec v;
+    v.iov_base = prefix;
+    v.iov_len = sizeof(prefix);
+    iov.push_back(v);
+    v.iov_base = const_cast<uint8_t*>(metadata.data());
+    v.iov_len = metadata.size();
+    iov.push_back(v);
+    v.iov_base = const_cast<uint8_t*>(ZERO_PAD);
+    v.iov_len = body_start - offset - 8 - metadata.size();
+    if (v.iov_len) {
+        iov.push_back(v);
+    }
+
+    // Buffers go out as they are; only alignment padding is added
+    for (size_t i = 0; i < count; ++i) {
+        if (lengths[i] == 0) {
+            continue;
+        }
+        v.iov_base = const_cast<void*>(buffers[i]);
+        v.iov_len = lengths[i];
+        iov.push_back(v);
+        v.iov_base = const_cast<uint8_t*>(ZERO_PAD);
+        v.iov_len = padTo(lengths[i], BODY_ALIGN) - lengths[i];
+        if (v.iov_len) {
+            iov.push_back(v);
+        }
+    }
+
+    if (!writeFully(fd, iov.data(), static_cast<int>(iov.size()))) {
+        return false;
+    }
+
+    if (count) {
+        Block block;
+        block.offset = offset;
+        block.metadata_length = static_cast<uint32_t>(body_start - offset);
+        block.body_length = body_length;
+        blocks.push_back(block);
+    }
+    offset = body_start + body_length;
+    return true;
+}
+
+bool ArrowWriter::writeBatch(const uint64_t* timestamp_ns, const int32_t* temp_mC,
+                             const uint32_t* flags, const uint64_t* seq, size_t rows) {
+    if (!seq) {
+        if (zeros.size() < rows) {
+            zeros.assign(rows, 0);
+        }
+        seq = zeros.data();
+    }
+
+    const void* values[COLUMN_COUNT] = { timestamp_ns, temp_mC, flags, seq };
+    const void* buffers[2 * COLUMN_COUNT];
+    size_t lengths[2 * COLUMN_COUNT];
+    uint64_t body_offsets[2 * COLUMN_COUNT];
+    uint64_t body_length = 0;
+    for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+        // Empty validity bitmap (no nulls), then the values
+        buffers[2 * c] = NULL;
+        lengths[2 * c] = 0;
+        body_offsets[2 * c] = body_length;
+        buffers[2 * c + 1] = values[c];
+        lengths[2 * c + 1] = rows * (COLUMNS[c].bit_width / 8);
+        body_offsets[2 * c + 1] = body_length;
+        body_length += padTo(lengths[2 * c + 1], BODY_ALIGN);
+    }
+
+    // RecordBatch { length, nodes: [FieldNode], buffers: [Buffer] }
+    FlatBuilder b;
+    size_t header = buildMessage(b, HEADER_RECORD_BATCH, body_length);
+    FlatBuilder::Field batch[] = { scalar(0, 8, rows), child(1), child(2) };
+    b.patch(header, b.table(batch, 3));
+
+    b.patch(batch[1].pos, b.vector(COLUMN_COUNT, 8));
+    for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+        b.put<int64_t>(static_cast<int64_t>(rows));
+        b.put<int64_t>(0);
+    }
+    b.patch(batch[2].pos, b.vector(2 * COLUMN_COUNT, 8));
+    for (size_t i = 0; i < 2 * COLUMN_COUNT; ++i) {
+        b.put<int64_t>(static_cast<int64_t>(body_offsets[i]));
+        b.put<int64_t>(static_cast<int64_t>(lengths[i]));
+    }
+    b.pad(8);
+
+    if (!writeMessage(b.buf, buffers, lengths, 2 * COLUMN_COUNT, body_length)) {
+        return false;
+    }
+    rows_written += rows;
+    return true;
+}
+
+bool ArrowWriter::append(const uint64_t* timestamp_ns, const int32_t* temp_mC,
+                         const uint32_t* flags, const uint64_t* seq, size_t rows) {
+    if (fd < 0) {
+        errno = EBADF;
+        return false;
+    }
+
+    size_t pos = 0;
+
+    // Fast path: whole record batches straight from the caller's columns
+    if (pending.empty()) {
+        while (rows - pos >= batch_rows) {
+            if (!writeBatch(timestamp_ns + pos, temp_mC + pos, flags + pos,
+                            seq ? seq + pos : NULL, batch_rows)) {
+                return false;
+            }
+            pos += batch_rows;
+        }
+    }
+
+    while (pos < rows) {
+        size_t take = batch_rows - pending.size();
+        if (take > rows - pos) {
+            take = rows - pos;
+        }
+        pending.timestamp_ns.insert(pending.timestamp_ns.end(), timestamp_ns + pos,
+                                    timestamp_ns + pos + take);
+        pending.temp_mC.insert(pending.temp_mC.end(), temp_mC + pos, temp_mC + pos + take);
+        pending.flags.insert(pending.flags.end(), flags + pos, flags + pos + take);
+        if (seq) {
+            pending.seq.insert(pending.seq.end(), seq + pos, seq + pos + take);
+        } else {
+            pending.seq.resize(pending.seq.size() + take, 0);
+        }
+        pos += take;
+
+        if (pending.size() == batch_rows && !flush()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ArrowWriter::append(const SampleBatch& batch) {
+    return append(batch.timestamp_ns.data(), batch.temp_mC.data(), batch.flags.data(),
+                  batch.seq.size() == batch.size() ? batch.seq.data() : NULL, batch.size());
+}
+
+bool ArrowWriter::flush() {
+    if (fd < 0) {
+        errno = EBADF;
+        return false;
+    }
+    if (pending.empty()) {
+        return true;
+    }
+    if (!writeBatch(pending.timestamp_ns.data(), pending.temp_mC.data(), pending.flags.data(),
+                    pending.seq.data(), pending.size())) {
+        return false;
+    }
+    pending.clear();
+    return true;
+}
+
+bool ArrowWriter::close() {
+    if (fd < 0) {
+        return true;
+    }
+
+    bool ok = flush();
+
+    // End-of-stream marker
+    uint32_t eos[2] = { CONTINUATION, 0 };
+    struct iovec iov[3];
+    iov[0].iov_base = eos;
+    iov[0].iov_len = sizeof(eos);
+    ok = ok && writeFully(fd, iov, 1);
+    offset += sizeof(eos);
+
+    if (ok && format == ARROW_FILE) {
+        // Footer { version, schema, dictionaries: [], recordBatches: [Block] }
+        FlatBuilder b;
+        FlatBuilder::Field footer[] = { scalar(0, 2, METADATA_V5), child(1), child(2), child(3) };
+        b.finish(b.table(footer, 4));
+        b.patch(footer[1].pos, buildSchema(b));
+        b.patch(footer[2].pos, b.vector(0, 8));
+        b.patch(footer[3].pos, b.vector(static_cast<uint32_t>(blocks.size()), 8));
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            b.put<int64_t>(static_cast<int64_t>(blocks[i].offset));
+            b.put<int32_t>(static_cast<int32_t>(blocks[i].metadata_length));
+            b.put<int32_t>(0);
+            b.put<int64_t>(static_cast<int64_t>(blocks[i].body_length));
+        }
+        b.pad(8);
+
+        int32_t footer_length = static_cast<int32_t>(b.buf.size());
+        iov[0].iov_base = b.buf.data();
+        iov[0].iov_len = b.buf.size();
+        iov[1].iov_base = &footer_length;
+        iov[1].iov_len = sizeof(footer_length);
+        iov[2].iov_base = const_cast<char*>(ARROW_MAGIC);
+        iov[2].iov_len = 6;
+        ok = writeFully(fd, iov, 3);
+        offset += b.buf.size() + sizeof(footer_length) + 6;
+    }
+
+    if (owns_fd) {
+        if (::close(fd) != 0) {
+            ok = false;
+        }
+    }
+    fd = -1;
+    return ok;
+}
+
+} // namespace simtemp
@@ -0,0 +1,90 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Apache Arrow IPC output (columnar format, metadata version V5), written
+ * without the Arrow library. A SampleBatch already holds one contiguous
+ * array per column, which is exactly an Arrow primitive buffer, so record
+ * batches are written with writev() straight from the columns:
+ *
+ *   timestamp_ns uint64 | temp_mC int32 | flags uint32 | seq uint64
+ *
+ * No column has nulls, so validity buffers are empty. Every record batch
+ * body starts on a 64-byte file offset and every buffer inside it is
+ * 64-byte aligned, so a reader that maps the file can use the columns in
+ * place. The file format (ARROW1 magic, footer with batch index) is what
+ * dataframe tools memory-map; the stream format suits pipes.
+ */
+
+#ifndef SIMTEMP_ARROW_H
+#define SIMTEMP_ARROW_H
+
+#include "simtemp.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+// 64 Ki rows: 1.5 MiB of column data per record batch
+const uint32_t ARROW_DEFAULT_BATCH_ROWS = 65536;
+
+enum ArrowFormat {
+    ARROW_FILE = 0,             // random access, memory-mappable (.arrow)
+    ARROW_STREAM = 1            // sequential (.arrows)
+};
+
+class ArrowWriter {
+private:
+    struct Block {
+        uint64_t offset;
+        uint32_t metadata_length;
+        uint64_t body_length;
+    };
+
+    int fd;
+    bool owns_fd;
+    ArrowFormat format;
+    uint32_t batch_rows;
+    uint64_t offset;
+    uint64_t rows_written;
+    SampleBatch pending;
+    std::vector<Block> blocks;
+    std::vector<uint64_t> zeros;    // seq column for sources without one
+
+    ArrowWriter(const ArrowWriter&);
+    ArrowWriter& operator=(const ArrowWriter&);
+
+    bool start();
+    bool writeMessage(const std::vector<uint8_t>& metadata, const void* const* buffers,
+                      const size_t* lengths, size_t count, uint64_t body_length);
+    bool writeBatch(const uint64_t* timestamp_ns, const int32_t* temp_mC,
+                    const uint32_t* flags, const uint64_t* seq, size_t rows);
+
+public:
+    explicit ArrowWriter(uint32_t batch_rows = ARROW_DEFAULT_BATCH_ROWS);
+    ~ArrowWriter();
+
+    // Create (or truncate) path, or write to an existing fd (not closed)
+    bool open(const std::string& path, ArrowFormat format = ARROW_FILE);
+    bool open(int fd, ArrowFormat format = ARROW_STREAM);
+    // Buffer rows; full record batches are written as soon as they fill
+    bool append(const SampleBatch& batch);
+    // Column form; seq may be NULL (written as zeros)
+    bool append(const uint64_t* timestamp_ns, const int32_t* temp_mC, const uint32_t* flags,
+                const uint64_t* seq, size_t rows);
+    // Write buffered rows as a (short) record batch
+    bool flush();
+    // Flush, write the end-of-stream marker and (file format) the footer
+    bool close();
+
+    bool isOpen() const { return fd >= 0; }
+    uint64_t rowsWritten() const { return rows_written; }
+    size_t batchCount() const { return blocks.size(); }
+    uint64_t bytesWritten() const { return offset; }
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_ARROW_H
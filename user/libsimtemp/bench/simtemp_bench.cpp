@@ -0,0 +1,282 @@
+/*
+ * NXP Simulated Temperature Sensor - libsimtemp benchmarks
+ *
+ * Throughput of the library's per-sample kernels on synthetic noisy-mode
+ * data (no device needed). Each benchmark processes the same sample stream
+ * in batches and reports millions of samples per second.
+ *
+ *   simtemp_bench [SAMPLES] [BATCH]
+ */
+
+#include "stats.h"
+#include "predict.h"
+#include "filter.h"
+#include "merge.h"
+#include "resample.h"
+#include "correlate.h"
+#include "topk.h"
+#include "jitter.h"
+#include "arrow.h"
+#include "crc32c.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace simtemp;
+
+// Same shape as the driver's noisy mode: 25 C with +-1 C noise
+static void generate(std::vector<uint64_t>& timestamp_ns, std::vector<int32_t>& temp_mC) {
+    uint32_t rng = 12345;
+    for (size_t i = 0; i < temp_mC.size(); ++i) {
+        rng = rng * 1103515245u + 12345u;
+        timestamp_ns[i] = 1000000000ULL + i * 100000000ULL;
+        temp_mC[i] = 25000 + static_cast<int32_t>((rng >> 16) % 2001) - 1000;
+    }
+}
+
+template <typename Body>
+static void run(const char* name, size_t samples, Body body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-44s %8.1f Msamples/s  (%.3f s)\n", name, samples / sec / 1e6, sec);
+}
+
+static void benchFilter(Filter* filter, const std::vector<int32_t>& in, std::vector<int32_t>& out,
+                        size_t batch) {
+    std::string label = "filter " + filter->name();
+    run(label.c_str(), in.size(), [&] {
+        for (size_t off = 0; off < in.size(); off += batch) {
+            size_t n = in.size() - off < batch ? in.size() - off : batch;
+            filter->process(&in[off], &out[off], n);
+        }
+    });
+    delete filter;
+}
+
+// In-memory source handing out fixed-size spans of one sensor's columns
+class ColumnSource : public MergeSource {
+private:
+    const std::vector<uint64_t>& timestamp_ns;
+    const std::vector<int32_t>& temp_mC;
+    std::vector<uint32_t> flags;
+    size_t span_samples;
+    size_t pos;
+
+public:
+    ColumnSource(const std::vector<uint64_t>& timestamp_ns, const std::vector<int32_t>& temp_mC,
+                 size_t span_samples)
+        : timestamp_ns(timestamp_ns), temp_mC(temp_mC), flags(temp_mC.size()),
+          span_samples(span_samples), pos(0) {}
+
+    virtual int next(MergeSpan& span) {
+        if (pos >= temp_mC.size()) {
+            return -1;
+        }
+        span.timestamp_ns = &timestamp_ns[pos];
+        span.temp_mC = &temp_mC[pos];
+        span.flags = &flags[pos];
+        span.seq = NULL;
+        span.count = temp_mC.size() - pos < span_samples ? temp_mC.size() - pos : span_samples;
+        pos += span.count;
+        return 1;
+    }
+    virtual bool live() const { return false; }
+};
+
+// k sensors sampled at the same rate with staggered phases
+static void benchMerge(size_t k, size_t samples, size_t batch) {
+    size_t per_source = samples / k;
+    std::vector<std::vector<uint64_t> > timestamps(k, std::vector<uint64_t>(per_source));
+    std::vector<std::vector<int32_t> > temps(k, std::vector<int32_t>(per_source));
+    std::vector<ColumnSource*> sources;
+    StreamMerger merger;
+    for (size_t s = 0; s < k; ++s) {
+        generate(timestamps[s], temps[s]);
+        for (size_t i = 0; i < per_source; ++i) {
+            timestamps[s][i] += s * 1000;
+        }
+        sources.push_back(new ColumnSource(timestamps[s], temps[s], batch));
+        merger.addSource(sources.back(), static_cast<uint32_t>(s));
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "merge %zu sources", k);
+    MergedBatch out;
+    run(label, per_source * k, [&] {
+        while (!merger.finished()) {
+            out.clear();
+            merger.next(out, batch);
+        }
+    });
+
+    for (size_t s = 0; s < k; ++s) {
+        delete sources[s];
+    }
+}
+
+static void benchResample(const char* spec, const std::vector<uint64_t>& timestamp_ns,
+                          const std::vector<int32_t>& temp_mC, size_t batch) {
+    ResamplerConfig config;
+    parseResampleSpec(spec, config);
+    Resampler resampler(config, timestamp_ns[1] - timestamp_ns[0]);
+    std::string label = "resample " + resampler.describe();
+    SampleBatch out;
+    run(label.c_str(), temp_mC.size(), [&] {
+        for (size_t off = 0; off < temp_mC.size(); off += batch) {
+            size_t n = temp_mC.size() - off < batch ? temp_mC.size() - off : batch;
+            out.clear();
+            resampler.process(&timestamp_ns[off], &temp_mC[off], NULL, n, out);
+        }
+    });
+}
+
+// n streams sharing one noisy signal, window of 256 rows
+static void benchCorrelation(size_t n, const std::vector<int32_t>& temp_mC) {
+    size_t rows = temp_mC.size() / n;
+    SlidingCorrelation corr(n, 256, 1024);
+    std::vector<int32_t> row(n);
+    char label[64];
+    snprintf(label, sizeof(label), "correlation %zu streams, window 256", n);
+    run(label, rows * n, [&] {
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t i = 0; i < n; ++i) {
+                row[i] = temp_mC[r * n + i] / 2 + temp_mC[r] / 2;
+            }
+            corr.push(r, row.data());
+        }
+    });
+}
+
+// 10,000 devices at 100 Hz, samples arriving round-robin
+static void benchRanking(const std::vector<int32_t>& temp_mC) {
+    const size_t devices = 10000;
+    SensorRanking ranking(20);
+    std::vector<RankedSensor> top;
+    volatile int32_t sink = 0;
+    run("top-20 hottest/rising, 10000 devices", temp_mC.size(), [&] {
+        for (size_t i = 0; i < temp_mC.size(); ++i) {
+            uint32_t device = static_cast<uint32_t>(i % devices);
+            uint64_t ts = 1000000000ULL + (i / devices) * 10000000ULL;
+            ranking.update(device, ts, temp_mC[i] + static_cast<int32_t>(device));
+            if (device == 0 && (i / devices) % 100 == 0) {
+                ranking.hottest(top);
+                sink = sink + top[0].temp_mC;
+            }
+        }
+    });
+}
+
+int main(int argc, char* argv[]) {
+    size_t samples = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+    size_t batch = argc > 2 ? strtoul(argv[2], NULL, 10) : 4096;
+    if (samples == 0 || batch == 0) {
+        fprintf(stderr, "Usage: %s [SAMPLES] [BATCH]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<uint64_t> timestamp_ns(samples);
+    std::vector<int32_t> temp_mC(samples);
+    std::vector<int32_t> out(samples);
+    generate(timestamp_ns, temp_mC);
+
+    printf("libsimtemp benchmarks: %zu samples, batch %zu\n\n", samples, batch);
+
+    volatile int64_t sink = 0;
+    run("computeStats", samples, [&] {
+        for (size_t off = 0; off < samples; off += batch) {
+            size_t n = samples - off < batch ? samples - off : batch;
+            sink = sink + computeStats(&temp_mC[off], NULL, n).max_mC;
+        }
+    });
+
+    benchFilter(new EmaFilter(0.2), temp_mC, out, batch);
+    benchFilter(new MedianFilter(5), temp_mC, out, batch);
+    benchFilter(new MedianFilter(31), temp_mC, out, batch);
+    benchFilter(new KalmanFilter(100, 250000), temp_mC, out, batch);
+
+    FilterChain chain;
+    parseFilterChain("median:5,ema:0.2,kalman:100:250000", chain);
+    std::string label = "chain " + chain.describe();
+    run(label.c_str(), samples, [&] {
+        for (size_t off = 0; off < samples; off += batch) {
+            size_t n = samples - off < batch ? samples - off : batch;
+            chain.process(&temp_mC[off], &out[off], n);
+        }
+    });
+
+    ThresholdPredictor linear(PredictorConfig(45000, 5000000000ULL, 50, false));
+    run("predictor linear:50", samples, [&] {
+        for (size_t off = 0; off < samples; off += batch) {
+            size_t n = samples - off < batch ? samples - off : batch;
+            sink = sink + linear.updateBatch(&timestamp_ns[off], &temp_mC[off], n);
+        }
+    });
+
+    ThresholdPredictor quadratic(PredictorConfig(45000, 5000000000ULL, 50, true));
+    run("predictor quadratic:50", samples, [&] {
+        for (size_t off = 0; off < samples; off += batch) {
+            size_t n = samples - off < batch ? samples - off : batch;
+            sink = sink + quadratic.updateBatch(&timestamp_ns[off], &temp_mC[off], n);
+        }
+    });
+
+    // Input is 100 ms apart: upsample to 30 ms, decimate to 1 s
+    benchResample("30:linear", timestamp_ns, temp_mC, batch);
+    benchResample("30:sinc:8", timestamp_ns, temp_mC, batch);
+    benchResample("1000:sinc:8", timestamp_ns, temp_mC, batch);
+
+    benchCorrelation(8, temp_mC);
+    benchCorrelation(64, temp_mC);
+
+    JitterAnalyzer jitter(JitterConfig(100000000ULL));
+    run("jitter analyzer", samples, [&] {
+        for (size_t off = 0; off < samples; off += batch) {
+            size_t n = samples - off < batch ? samples - off : batch;
+            jitter.process(&timestamp_ns[off], n);
+        }
+    });
+    sink = sink + jitter.onTimeCount();
+
+    // Framing and writev cost only: the bytes go to /dev/null
+    std::vector<uint32_t> flags(samples, 0);
+    int null_fd = open("/dev/null", O_WRONLY);
+    ArrowWriter arrow;
+    arrow.open(null_fd, ARROW_STREAM);
+    run("arrow stream writer", samples, [&] {
+        for (size_t off = 0; off < samples; off += batch) {
+            size_t n = samples - off < batch ? samples - off : batch;
+            arrow.append(&timestamp_ns[off], &temp_mC[off], &flags[off], NULL, n);
+        }
+        arrow.flush();
+    });
+    arrow.close();
+    close(null_fd);
+
+    // Over the timestamp column, as the recording writer and verifier do
+    run(crc32cAccelerated() ? "crc32c (sse4.2)" : "crc32c", samples, [&] {
+        for (size_t off = 0; off < samples; off += batch) {
+            size_t n = samples - off < batch ? samples - off : batch;
+            sink = sink + crc32c(&timestamp_ns[off], n * sizeof(uint64_t));
+        }
+    });
+    run("crc32c portable", samples, [&] {
+        for (size_t off = 0; off < samples; off += batch) {
+            size_t n = samples - off < batch ? samples - off : batch;
+            sink = sink + crc32cPortable(&timestamp_ns[off], n * sizeof(uint64_t));
+        }
+    });
+
+    benchRanking(temp_mC);
+
+    benchMerge(2, samples, batch);
+    benchMerge(8, samples, batch);
+    benchMerge(64, samples, batch);
+
+    return 0;
+}
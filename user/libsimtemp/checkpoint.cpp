@@ -0,0 +1,237 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Checkpoint persistence, sequence cursor and checkpointed recording sink.
+ */
+
+#include "checkpoint.h"
+
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+
+namespace simtemp {
+
+static uint64_t monotonicMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string parentDirectory(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+bool loadCheckpoint(const std::string& path, Checkpoint& ckpt) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    char buf[256];
+    ssize_t n = ::read(fd, buf, sizeof(buf) - 1);
+    int saved = errno;
+    ::close(fd);
+    if (n < 0) {
+        errno = saved;
+        return false;
+    }
+    buf[n] = '\0';
+
+    unsigned long long seq, ts, offset, samples;
+    if (sscanf(buf, "last_seq=%llu last_timestamp_ns=%llu sink_offset=%llu samples=%llu",
+               &seq, &ts, &offset, &samples) != 4) {
+        errno = EINVAL;
+        return false;
+    }
+
+    ckpt.last_seq = seq;
+    ckpt.last_timestamp_ns = ts;
+    ckpt.sink_offset = offset;
+    ckpt.samples = samples;
+    return true;
+}
+
+bool saveCheckpoint(const std::string& path, const Checkpoint& ckpt) {
+    char buf[256];
+    int len = snprintf(buf, sizeof(buf),
+                       "last_seq=%llu last_timestamp_ns=%llu sink_offset=%llu samples=%llu\n",
+                       static_cast<unsigned long long>(ckpt.last_seq),
+                       static_cast<unsigned long long>(ckpt.last_timestamp_ns),
+                       static_cast<unsigned long long>(ckpt.sink_offset),
+                       static_cast<unsigned long long>(ckpt.samples));
+
+    std::string tmp_path = path + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (::write(fd, buf, len) != len || ::fsync(fd) != 0) {
+        int saved = errno;
+        ::close(fd);
+        ::unlink(tmp_path.c_str());
+        errno = saved;
+        return false;
+    }
+    ::close(fd);
+
+    if (::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        return false;
+    }
+
+    // Persist the rename itself
+    int dir_fd = ::open(parentDirectory(path).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    return true;
+}
+
+SequenceCursor::SequenceCursor(uint64_t last_seq, uint64_t last_ns)
+    : last_seq(last_seq), last_ns(last_ns), duplicates(0), lost(0), resets(0) {}
+
+size_t SequenceCursor::advance(SampleBatch& batch, std::vector<SequenceGap>* gaps) {
+    size_t n = batch.size();
+    size_t kept = 0;
+    size_t found = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t seq = batch.seq[i];
+        uint64_t ts = batch.timestamp_ns[i];
+
+        if (seq != 0 && last_seq != 0) {
+            if (seq <= last_seq) {
+                if (ts <= last_ns) {
+                    ++duplicates;
+                    continue;
+                }
+                ++resets;
+            } else if (seq > last_seq + 1) {
+                SequenceGap gap = { last_seq + 1, seq - 1, last_ns, ts };
+                lost += gap.lost();
+                ++found;
+                if (gaps) {
+                    gaps->push_back(gap);
+                }
+            }
+        } else if (last_ns != 0 && ts <= last_ns) {
+            ++duplicates;
+            continue;
+        }
+
+        if (kept != i) {
+            batch.timestamp_ns[kept] = ts;
+            batch.temp_mC[kept] = batch.temp_mC[i];
+            batch.flags[kept] = batch.flags[i];
+            batch.seq[kept] = seq;
+        }
+        ++kept;
+        if (seq != 0) {
+            last_seq = seq;
+        }
+        last_ns = ts;
+    }
+
+    if (kept != n) {
+        batch.timestamp_ns.resize(kept);
+        batch.temp_mC.resize(kept);
+        batch.flags.resize(kept);
+        batch.seq.resize(kept);
+    }
+    return found;
+}
+
+CheckpointedRecorder::CheckpointedRecorder(unsigned sync_batches, unsigned sync_interval_ms)
+    : sync_batches(sync_batches ? sync_batches : 1), sync_interval_ms(sync_interval_ms),
+      pending_batches(0), last_sync_ms(0), syncs(0) {
+    memset(&ckpt, 0, sizeof(ckpt));
+}
+
+CheckpointedRecorder::~CheckpointedRecorder() {
+    close();
+}
+
+bool CheckpointedRecorder::open(const std::string& recording_path,
+                                const std::string& checkpoint_path, bool& resumed) {
+    this->checkpoint_path = checkpoint_path;
+    memset(&ckpt, 0, sizeof(ckpt));
+    resumed = false;
+
+    if (loadCheckpoint(checkpoint_path, ckpt)) {
+        if (!writer.openAppend(recording_path, ckpt.sink_offset)) {
+            return false;
+        }
+        resumed = true;
+    } else if (errno == ENOENT) {
+        if (!writer.open(recording_path)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    cursor = SequenceCursor(ckpt.last_seq, ckpt.last_timestamp_ns);
+    pending_batches = 0;
+    last_sync_ms = monotonicMs();
+    return commit();
+}
+
+bool CheckpointedRecorder::append(SampleBatch& batch, std::vector<SequenceGap>* gaps) {
+    cursor.advance(batch, gaps);
+    if (!batch.empty()) {
+        if (!writer.append(batch)) {
+            return false;
+        }
+        ckpt.samples += batch.size();
+    }
+
+    ++pending_batches;
+    if (pending_batches >= sync_batches || monotonicMs() - last_sync_ms >= sync_interval_ms) {
+        return commit();
+    }
+    return true;
+}
+
+bool CheckpointedRecorder::commit() {
+    if (!writer.isOpen()) {
+        errno = EBADF;
+        return false;
+    }
+    if (!writer.flush() || !writer.sync()) {
+        return false;
+    }
+
+    ckpt.last_seq = cursor.lastSeq();
+    ckpt.last_timestamp_ns = cursor.lastTimestamp();
+    ckpt.sink_offset = writer.bytesWritten();
+    if (!saveCheckpoint(checkpoint_path, ckpt)) {
+        return false;
+    }
+
+    pending_batches = 0;
+    last_sync_ms = monotonicMs();
+    ++syncs;
+    return true;
+}
+
+bool CheckpointedRecorder::close() {
+    bool ok = true;
+    if (writer.isOpen()) {
+        ok = commit();
+        writer.close();
+    }
+    return ok;
+}
+
+void CheckpointedRecorder::detach() {
+    writer.close();
+}
+
+} // namespace simtemp
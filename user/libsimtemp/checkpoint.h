@@ -0,0 +1,120 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Resumable consumers. A checkpoint records how far a consumer got (last
+ * sequence number and timestamp) together with the matching sink offset.
+ * After a restart the consumer truncates its sink back to that offset,
+ * drops samples it has already seen and reports exactly how many sequence
+ * numbers were lost in between.
+ */
+
+#ifndef SIMTEMP_CHECKPOINT_H
+#define SIMTEMP_CHECKPOINT_H
+
+#include "simtemp.h"
+#include "recording.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace simtemp {
+
+struct Checkpoint {
+    uint64_t last_seq;          // 0 when the source has no sequence numbers
+    uint64_t last_timestamp_ns;
+    uint64_t sink_offset;       // recording bytes covered by this checkpoint
+    uint64_t samples;           // samples delivered to the sink so far
+};
+
+// Missing sequence numbers [first_seq, last_seq] between two delivered samples
+struct SequenceGap {
+    uint64_t first_seq;
+    uint64_t last_seq;
+    uint64_t before_ns;         // timestamp of the sample preceding the gap
+    uint64_t after_ns;          // timestamp of the sample following the gap
+
+    uint64_t lost() const { return last_seq - first_seq + 1; }
+};
+
+/*
+ * Checkpoint files hold one "key=value ..." line and are replaced atomically
+ * (temporary file, fsync, rename, fsync of the directory), so a crash leaves
+ * either the old or the new checkpoint. loadCheckpoint() returns false with
+ * errno == ENOENT when no checkpoint exists yet.
+ */
+bool loadCheckpoint(const std::string& path, Checkpoint& ckpt);
+bool saveCheckpoint(const std::string& path, const Checkpoint& ckpt);
+
+/*
+ * Tracks the last delivered sample. advance() removes samples that are at or
+ * behind the cursor (duplicates after a resume or a replayed source) and
+ * records every hole in the sequence. A sequence that restarts with newer
+ * timestamps (driver reloaded) is accepted as a new epoch. Samples without
+ * sequence numbers are deduplicated by timestamp only.
+ */
+class SequenceCursor {
+private:
+    uint64_t last_seq;
+    uint64_t last_ns;
+    uint64_t duplicates;
+    uint64_t lost;
+    uint64_t resets;
+
+public:
+    SequenceCursor(uint64_t last_seq = 0, uint64_t last_ns = 0);
+
+    // Returns the number of gaps found; gap details are appended to gaps
+    size_t advance(SampleBatch& batch, std::vector<SequenceGap>* gaps = NULL);
+
+    uint64_t lastSeq() const { return last_seq; }
+    uint64_t lastTimestamp() const { return last_ns; }
+    uint64_t duplicatesDropped() const { return duplicates; }
+    uint64_t samplesLost() const { return lost; }
+    uint64_t sourceResets() const { return resets; }
+};
+
+/*
+ * Recording sink with a checkpointed cursor. Samples are appended as they
+ * arrive; every sync_batches batches (or sync_interval_ms, whichever comes
+ * first) the recording is flushed and fdatasync'ed and only then the
+ * checkpoint is replaced, so a checkpoint never points past durable data.
+ */
+class CheckpointedRecorder {
+private:
+    RecordingWriter writer;
+    std::string checkpoint_path;
+    Checkpoint ckpt;
+    SequenceCursor cursor;
+    unsigned sync_batches;
+    unsigned sync_interval_ms;
+    unsigned pending_batches;
+    uint64_t last_sync_ms;
+    uint64_t syncs;
+
+public:
+    CheckpointedRecorder(unsigned sync_batches = 32, unsigned sync_interval_ms = 1000);
+    ~CheckpointedRecorder();
+
+    // Open the recording, resuming from checkpoint_path when it exists.
+    // Without a checkpoint the recording is created from scratch (nothing
+    // in it was ever acknowledged). resumed reports whether one was found.
+    bool open(const std::string& recording_path, const std::string& checkpoint_path,
+              bool& resumed);
+    // Deduplicate, record gaps and append; commits when a sync is due
+    bool append(SampleBatch& batch, std::vector<SequenceGap>* gaps = NULL);
+    // Make everything appended so far durable and checkpoint it
+    bool commit();
+    bool close();
+    // Close without a final commit: after a handoff the successor owns the
+    // recording and the checkpoint (commit() first)
+    void detach();
+
+    const Checkpoint& checkpoint() const { return ckpt; }
+    const SequenceCursor& sequence() const { return cursor; }
+    uint64_t syncCount() const { return syncs; }
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_CHECKPOINT_H
@@ -0,0 +1,353 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * C++20 coroutine API on top of the reactor (header only; compile the
+ * consumer with -std=c++20 and link libsimtemp.a as usual):
+ *
+ *   Task<void> watch(AwaitableDevice& dev) {
+ *       SampleBatch batch;
+ *       while (co_await dev.nextBatch(batch, 256) > 0) {
+ *           ...
+ *       }
+ *   }
+ *
+ *   Reactor reactor;
+ *   reactor.open();
+ *   AwaitableDevice dev(reactor);
+ *   dev.open();
+ *   spawn(watch(dev));
+ *   reactor.run();
+ *
+ * Tasks are lazy and resume their awaiter by symmetric transfer, so chains
+ * of nested tasks do not grow the stack. Coroutine frames come from a
+ * per-thread size-class pool and awaiters live inside the frame, so a
+ * steady-state co_await performs no heap allocation. Everything runs on
+ * the thread calling Reactor::run().
+ */
+
+#ifndef SIMTEMP_CORO_H
+#define SIMTEMP_CORO_H
+
+#if __cplusplus < 202002L || !defined(__cpp_impl_coroutine)
+#error "coro.h requires C++20 coroutines (-std=c++20)"
+#endif
+
+#include "reactor.h"
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <new>
+#include <cerrno>
+#include <cstddef>
+
+namespace simtemp {
+
+// Coroutine frame allocator: per-thread free lists in 64-byte size classes.
+// Frames larger than the biggest class go straight to operator new.
+class FramePool {
+private:
+    static constexpr size_t GRANULE = 64;
+    static constexpr size_t CLASSES = 64;
+
+    struct Block {
+        Block* next;
+    };
+
+    struct Lists {
+        Block* head[CLASSES] = {};
+
+        ~Lists() {
+            for (size_t i = 0; i < CLASSES; ++i) {
+                while (Block* b = head[i]) {
+                    head[i] = b->next;
+                    ::operator delete(b);
+                }
+            }
+        }
+    };
+
+    static Lists& lists() {
+        thread_local Lists per_thread;
+        return per_thread;
+    }
+
+public:
+    static void* allocate(size_t size) {
+        size_t cls = (size + GRANULE - 1) / GRANULE;
+        if (cls == 0 || cls > CLASSES) {
+            return ::operator new(size);
+        }
+        Block*& head = lists().head[cls - 1];
+        if (Block* b = head) {
+            head = b->next;
+            return b;
+        }
+        return ::operator new(cls * GRANULE);
+    }
+
+    static void deallocate(void* p, size_t size) {
+        size_t cls = (size + GRANULE - 1) / GRANULE;
+        if (cls == 0 || cls > CLASSES) {
+            ::operator delete(p);
+            return;
+        }
+        Block* b = static_cast<Block*>(p);
+        b->next = lists().head[cls - 1];
+        lists().head[cls - 1] = b;
+    }
+};
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    static void* operator new(size_t size) { return FramePool::allocate(size); }
+    static void operator delete(void* p, size_t size) { FramePool::deallocate(p, size); }
+
+    // Resume whoever awaited us directly instead of returning to the reactor
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            std::coroutine_handle<> next = h.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object() noexcept;
+    void return_value(T v) { value.emplace(std::move(v)); }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+};
+
+} // namespace detail
+
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::Promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    struct Awaiter {
+        handle_type handle;
+
+        // Awaiting a moved-from Task is a programming error: there is no
+        // frame to resume or to take the result from
+        bool await_ready() noexcept {
+            if (!handle) {
+                std::terminate();
+            }
+            return handle.done();
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+            handle.promise().continuation = caller;
+            return handle;
+        }
+
+        T await_resume() {
+            promise_type& p = handle.promise();
+            if (p.exception) {
+                std::rethrow_exception(p.exception);
+            }
+            if constexpr (!std::is_void_v<T>) {
+                return std::move(*p.value);
+            }
+        }
+    };
+
+    explicit Task(handle_type h) noexcept : handle(h) {}
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    Awaiter operator co_await() const noexcept { return Awaiter{handle}; }
+    bool done() const noexcept { return !handle || handle.done(); }
+
+private:
+    handle_type handle;
+};
+
+namespace detail {
+
+template <typename T>
+inline Task<T> Promise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// Self-destroying root coroutine used by spawn()
+struct Detached {
+    struct promise_type {
+        static void* operator new(size_t size) { return FramePool::allocate(size); }
+        static void operator delete(void* p, size_t size) { FramePool::deallocate(p, size); }
+
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+inline Detached runDetached(Task<void> task) {
+    co_await task;
+}
+
+} // namespace detail
+
+// Start task now; it runs until its first suspension and frees itself when
+// it finishes. An exception escaping the task terminates the program.
+inline void spawn(Task<void> task) {
+    detail::runDetached(std::move(task));
+}
+
+// AsyncDevice with awaitable operations
+class AwaitableDevice : public AsyncDevice {
+public:
+    using AsyncDevice::AsyncDevice;
+
+    // co_await yields the number of samples placed in out (replacing its
+    // contents), or -1 with errno set
+    class BatchAwaiter : private AsyncDevice::BatchWaiter {
+    private:
+        AsyncDevice& device;
+        std::coroutine_handle<> handle;
+        bool suspended;
+
+        static void resume(Waiter* w) {
+            BatchAwaiter* self = static_cast<BatchAwaiter*>(static_cast<BatchWaiter*>(w));
+            self->handle.resume();
+        }
+
+    public:
+        BatchAwaiter(AsyncDevice& device, SampleBatch& batch, size_t max)
+            : device(device), suspended(false) {
+            wake = &resume;
+            out = &batch;
+            max_samples = max;
+            result = 0;
+            error = 0;
+        }
+
+        BatchAwaiter(const BatchAwaiter&) = delete;
+        BatchAwaiter& operator=(const BatchAwaiter&) = delete;
+
+        ~BatchAwaiter() {
+            if (suspended) {
+                device.cancel(*this);
+            }
+        }
+
+        bool await_ready() { return device.submitBatch(*this); }
+        void await_suspend(std::coroutine_handle<> h) noexcept { handle = h; suspended = true; }
+
+        ssize_t await_resume() noexcept {
+            suspended = false;
+            if (result < 0) {
+                errno = error;
+            }
+            return result;
+        }
+    };
+
+    // co_await yields true with the crossing sample in sample, or false with
+    // errno set when the device failed or was closed
+    class AlertAwaiter : private AsyncDevice::AlertWaiter {
+    private:
+        AsyncDevice& device;
+        SimTempSampleExt& target;
+        std::coroutine_handle<> handle;
+        bool suspended;
+
+        static void resume(Waiter* w) {
+            AlertAwaiter* self = static_cast<AlertAwaiter*>(static_cast<AlertWaiter*>(w));
+            self->handle.resume();
+        }
+
+    public:
+        AlertAwaiter(AsyncDevice& device, SimTempSampleExt& sample)
+            : device(device), target(sample), suspended(false) {
+            wake = &resume;
+            result = 0;
+            error = 0;
+        }
+
+        AlertAwaiter(const AlertAwaiter&) = delete;
+        AlertAwaiter& operator=(const AlertAwaiter&) = delete;
+
+        ~AlertAwaiter() {
+            if (suspended) {
+                device.cancel(*this);
+            }
+        }
+
+        bool await_ready() { return device.submitAlert(*this); }
+        void await_suspend(std::coroutine_handle<> h) noexcept { handle = h; suspended = true; }
+
+        bool await_resume() noexcept {
+            suspended = false;
+            if (result < 0) {
+                errno = error;
+                return false;
+            }
+            target = sample;
+            return true;
+        }
+    };
+
+    BatchAwaiter nextBatch(SampleBatch& batch, size_t max_samples = 4096) {
+        return BatchAwaiter(*this, batch, max_samples);
+    }
+
+    AlertAwaiter alert(SimTempSampleExt& sample) {
+        return AlertAwaiter(*this, sample);
+    }
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_CORO_H
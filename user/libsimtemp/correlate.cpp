@@ -0,0 +1,193 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Incremental sliding-window covariance/correlation and row alignment.
+ */
+
+#include "correlate.h"
+
+#include <cmath>
+#include <limits>
+
+namespace simtemp {
+
+// Rows staged before a blocked update, and the tile edge of that update
+static const size_t STAGE_ROWS = 16;
+static const size_t TILE = 64;
+
+double CorrelationSnapshot::neighbourCorrelation(size_t i) const {
+    double total = 0.0;
+    size_t pairs = 0;
+    for (size_t j = 0; j < streams; ++j) {
+        double c = corr(i, j);
+        if (j != i && !std::isnan(c)) {
+            total += c;
+            pairs++;
+        }
+    }
+    return pairs ? total / pairs : std::numeric_limits<double>::quiet_NaN();
+}
+
+SlidingCorrelation::SlidingCorrelation(size_t streams, size_t window, size_t publish_every)
+    : n(streams), window(window ? window : 1), publish_every(publish_every),
+      ring(this->window * streams), head(0), count(0), sum(streams), prod(streams * streams),
+      added(STAGE_ROWS * streams), evicted(STAGE_ROWS * streams), staged(0),
+      since_publish(0), last_ns(0) {
+    snap.streams = n;
+    snap.rows = 0;
+    snap.timestamp_ns = 0;
+}
+
+void SlidingCorrelation::applyStaged() {
+    for (size_t i0 = 0; i0 < n; i0 += TILE) {
+        size_t i_end = i0 + TILE < n ? i0 + TILE : n;
+        for (size_t j0 = i0; j0 < n; j0 += TILE) {
+            size_t j_end = j0 + TILE < n ? j0 + TILE : n;
+
+            // The whole staged block goes through this tile before moving on
+            for (size_t r = 0; r < staged; ++r) {
+                const double* x = &added[r * n];
+                const double* y = &evicted[r * n];
+                for (size_t i = i0; i < i_end; ++i) {
+                    double xi = x[i];
+                    double yi = y[i];
+                    double* p = &prod[i * n];
+                    for (size_t j = (j0 > i ? j0 : i); j < j_end; ++j) {
+                        p[j] += xi * x[j] - yi * y[j];
+                    }
+                }
+            }
+        }
+    }
+    staged = 0;
+}
+
+bool SlidingCorrelation::push(uint64_t timestamp_ns, const int32_t* row) {
+    if (reference.empty()) {
+        reference.assign(row, row + n);
+    }
+
+    double* slot = &ring[head * n];
+    double* in = &added[staged * n];
+    double* out = &evicted[staged * n];
+    bool full = (count == window);
+    for (size_t i = 0; i < n; ++i) {
+        double v = static_cast<double>(row[i] - reference[i]);
+        in[i] = v;
+        out[i] = full ? slot[i] : 0.0;
+        sum[i] += v - out[i];
+        slot[i] = v;
+    }
+
+    head = (head + 1 == window) ? 0 : head + 1;
+    if (!full) {
+        count++;
+    }
+    last_ns = timestamp_ns;
+    if (++staged == STAGE_ROWS) {
+        applyStaged();
+    }
+
+    if (publish_every && ++since_publish >= publish_every) {
+        since_publish = 0;
+        publish();
+        return true;
+    }
+    return false;
+}
+
+const CorrelationSnapshot& SlidingCorrelation::publish() {
+    applyStaged();
+
+    snap.streams = n;
+    snap.rows = count;
+    snap.timestamp_ns = last_ns;
+    snap.mean_mC.assign(n, 0.0);
+    snap.covariance.assign(n * n, 0.0);
+    snap.correlation.assign(n * n, std::numeric_limits<double>::quiet_NaN());
+    if (count == 0) {
+        return snap;
+    }
+
+    double rows = static_cast<double>(count);
+    for (size_t i = 0; i < n; ++i) {
+        snap.mean_mC[i] = reference[i] + sum[i] / rows;
+    }
+    if (count < 2) {
+        return snap;
+    }
+
+    // Sample covariance from the upper triangle, mirrored
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i; j < n; ++j) {
+            double c = (prod[i * n + j] - sum[i] * sum[j] / rows) / (rows - 1.0);
+            snap.covariance[i * n + j] = c;
+            snap.covariance[j * n + i] = c;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i; j < n; ++j) {
+            double denom = std::sqrt(snap.covariance[i * n + i] * snap.covariance[j * n + j]);
+            double r = denom > 0.0 ? snap.covariance[i * n + j] / denom
+                                   : std::numeric_limits<double>::quiet_NaN();
+            snap.correlation[i * n + j] = r;
+            snap.correlation[j * n + i] = r;
+        }
+    }
+    return snap;
+}
+
+void SlidingCorrelation::reset() {
+    reference.clear();
+    ring.assign(ring.size(), 0.0);
+    sum.assign(n, 0.0);
+    prod.assign(n * n, 0.0);
+    head = 0;
+    count = 0;
+    staged = 0;
+    since_publish = 0;
+    last_ns = 0;
+}
+
+void RowAligner::add(size_t stream, const SampleBatch& batch) {
+    times[stream].insert(times[stream].end(), batch.timestamp_ns.begin(), batch.timestamp_ns.end());
+    values[stream].insert(values[stream].end(), batch.temp_mC.begin(), batch.temp_mC.end());
+}
+
+bool RowAligner::nextRow(uint64_t& timestamp_ns, int32_t* row) {
+    size_t n = times.size();
+    while (true) {
+        uint64_t newest = 0;
+        for (size_t s = 0; s < n; ++s) {
+            if (times[s].empty()) {
+                return false;
+            }
+            if (times[s].front() > newest) {
+                newest = times[s].front();
+            }
+        }
+
+        // Drop grid points some stream does not have
+        bool aligned = true;
+        for (size_t s = 0; s < n; ++s) {
+            if (times[s].front() < newest) {
+                times[s].pop_front();
+                values[s].pop_front();
+                aligned = false;
+            }
+        }
+        if (!aligned) {
+            continue;
+        }
+
+        timestamp_ns = newest;
+        for (size_t s = 0; s < n; ++s) {
+            row[s] = values[s].front();
+            times[s].pop_front();
+            values[s].pop_front();
+        }
+        return true;
+    }
+}
+
+} // namespace simtemp
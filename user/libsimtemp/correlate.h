@@ -0,0 +1,101 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Sliding-window covariance and correlation across N aligned streams (e.g.
+ * the outputs of Resamplers sharing a grid). Sums and sums of products are
+ * updated incrementally as rows enter and leave the window. Values are
+ * stored relative to each stream's first sample, so every product and sum
+ * is an integer well inside the 2^53 range of a double and the
+ * incremental updates never drift.
+ *
+ * Row updates are staged and applied in blocks: the upper triangle of the
+ * product matrix is walked tile by tile and each tile absorbs the whole
+ * block of new and evicted rows while it is in cache. The inner loop runs
+ * over a contiguous run of pairs, so it vectorizes.
+ */
+
+#ifndef SIMTEMP_CORRELATE_H
+#define SIMTEMP_CORRELATE_H
+
+#include "simtemp.h"
+
+#include <vector>
+#include <deque>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+// Matrices are row-major n x n
+struct CorrelationSnapshot {
+    size_t streams;
+    size_t rows;                    // samples per stream in the window
+    uint64_t timestamp_ns;          // newest row
+    std::vector<double> mean_mC;
+    std::vector<double> covariance;
+    std::vector<double> correlation;    // NaN where a stream is constant
+
+    double cov(size_t i, size_t j) const { return covariance[i * streams + j]; }
+    double corr(size_t i, size_t j) const { return correlation[i * streams + j]; }
+    // Mean correlation of stream i with every other stream; a failing
+    // sensor drifts towards zero while its neighbours stay high
+    double neighbourCorrelation(size_t i) const;
+};
+
+class SlidingCorrelation {
+private:
+    size_t n;
+    size_t window;
+    size_t publish_every;
+    std::vector<int32_t> reference;     // first sample of each stream
+    std::vector<double> ring;           // window rows, relative values
+    size_t head;                        // next ring row to overwrite
+    size_t count;
+    std::vector<double> sum;
+    std::vector<double> prod;           // upper triangle of n x n is live
+    std::vector<double> added;          // staged rows entering the window
+    std::vector<double> evicted;        // staged rows leaving (zeros if none)
+    size_t staged;
+    size_t since_publish;
+    uint64_t last_ns;
+    CorrelationSnapshot snap;
+
+    void applyStaged();
+
+public:
+    // window rows per estimate; a snapshot is published every publish_every rows
+    SlidingCorrelation(size_t streams, size_t window, size_t publish_every = 0);
+
+    // Add one aligned row of n temperatures; returns true when a snapshot
+    // was published by this row
+    bool push(uint64_t timestamp_ns, const int32_t* row);
+    // Compute a snapshot of the current window now
+    const CorrelationSnapshot& publish();
+    void reset();
+
+    const CorrelationSnapshot& snapshot() const { return snap; }
+    size_t streams() const { return n; }
+    size_t rows() const { return count; }
+};
+
+/*
+ * Collects per-stream batches on a shared grid and hands out complete rows:
+ * timestamps present in every stream, in order. Grid points missing from
+ * any stream (dropouts) are skipped.
+ */
+class RowAligner {
+private:
+    std::vector<std::deque<uint64_t> > times;
+    std::vector<std::deque<int32_t> > values;
+
+public:
+    explicit RowAligner(size_t streams) : times(streams), values(streams) {}
+
+    void add(size_t stream, const SampleBatch& batch);
+    // Next row present in every stream; row must hold one value per stream
+    bool nextRow(uint64_t& timestamp_ns, int32_t* row);
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_CORRELATE_H
@@ -0,0 +1,122 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * CRC32C: SSE4.2 and slicing-by-8 implementations.
+ */
+
+#include "crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define SIMTEMP_CRC32C_SSE42 1
+#endif
+
+namespace simtemp {
+
+static const uint32_t CRC32C_POLY = 0x82f63b78;     // reflected 0x1edc6f41
+
+struct Crc32cTables {
+    uint32_t t[8][256];
+
+    Crc32cTables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c >> 1) ^ (CRC32C_POLY & (0u - (c & 1)));
+            }
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int s = 1; s < 8; ++s) {
+                t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xff];
+            }
+        }
+    }
+};
+
+uint32_t crc32cPortable(const void* data, size_t length, uint32_t crc) {
+    static const Crc32cTables tables;
+    const uint32_t (*t)[256] = tables.t;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint32_t c = ~crc;
+
+    while (length >= 8) {
+        uint32_t lo;
+        uint32_t hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + 4, 4);
+        lo ^= c;
+        c = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+            t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+        p += 8;
+        length -= 8;
+    }
+    while (length--) {
+        c = (c >> 8) ^ t[0][(c ^ *p++) & 0xff];
+    }
+    return ~c;
+}
+
+#ifdef SIMTEMP_CRC32C_SSE42
+__attribute__((target("sse4.2")))
+static uint32_t crc32cSse42(const void* data, size_t length, uint32_t crc) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint32_t c = ~crc;
+
+    while (length && (reinterpret_cast<uintptr_t>(p) & 7)) {
+        c = _mm_crc32_u8(c, *p++);
+        --length;
+    }
+#ifdef __x86_64__
+    uint64_t c64 = c;
+    while (length >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        c64 = _mm_crc32_u64(c64, v);
+        p += 8;
+        length -= 8;
+    }
+    c = static_cast<uint32_t>(c64);
+#endif
+    while (length >= 4) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        c = _mm_crc32_u32(c, v);
+        p += 4;
+        length -= 4;
+    }
+    while (length--) {
+        c = _mm_crc32_u8(c, *p++);
+    }
+    return ~c;
+}
+#endif
+
+typedef uint32_t (*Crc32cFn)(const void*, size_t, uint32_t);
+
+static Crc32cFn selectCrc32c() {
+#ifdef SIMTEMP_CRC32C_SSE42
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        return crc32cSse42;
+    }
+#endif
+    return crc32cPortable;
+}
+
+static Crc32cFn crc32cImpl() {
+    static const Crc32cFn impl = selectCrc32c();
+    return impl;
+}
+
+uint32_t crc32c(const void* data, size_t length, uint32_t crc) {
+    return crc32cImpl()(data, length, crc);
+}
+
+bool crc32cAccelerated() {
+    return crc32cImpl() != crc32cPortable;
+}
+
+} // namespace simtemp
@@ -0,0 +1,32 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * CRC32C (Castagnoli) used to protect recording chunks. On x86 CPUs with
+ * SSE4.2 the crc32 instruction processes 8 bytes per step; elsewhere a
+ * slicing-by-8 table implementation gives the same result. The variant is
+ * picked once, on first use.
+ */
+
+#ifndef SIMTEMP_CRC32C_H
+#define SIMTEMP_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+/*
+ * CRC32C of length bytes. Pass the previous result as crc to continue a
+ * checksum over several buffers (0 starts a new one).
+ */
+uint32_t crc32c(const void* data, size_t length, uint32_t crc = 0);
+
+// Portable implementation, regardless of CPU support (for tests and benchmarks)
+uint32_t crc32cPortable(const void* data, size_t length, uint32_t crc = 0);
+
+// True when crc32c() uses the SSE4.2 instruction
+bool crc32cAccelerated();
+
+} // namespace simtemp
+
+#endif // SIMTEMP_CRC32C_H
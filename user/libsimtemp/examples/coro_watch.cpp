@@ -0,0 +1,113 @@
+/*
+ * NXP Simulated Temperature Sensor - libsimtemp coroutine example
+ *
+ * Watches devices with the C++20 coroutine API (coro.h): one batch task and
+ * one alert task per device, all on a single reactor thread. Each device
+ * stops after BATCHES batches; the program exits once every device is done.
+ *
+ *   coro_watch [BATCHES] [DEVICE...]
+ */
+
+#include "coro.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace simtemp;
+
+namespace {
+
+size_t running = 0;
+
+// Nested task: one batch, its temperature range folded into lo/hi
+Task<ssize_t> readRange(AwaitableDevice& dev, SampleBatch& batch, int32_t& lo, int32_t& hi) {
+    ssize_t n = co_await dev.nextBatch(batch, 256);
+    for (ssize_t i = 0; i < n; ++i) {
+        lo = batch.temp_mC[i] < lo ? batch.temp_mC[i] : lo;
+        hi = batch.temp_mC[i] > hi ? batch.temp_mC[i] : hi;
+    }
+    co_return n;
+}
+
+Task<void> watchBatches(AwaitableDevice& dev, const std::string& path, size_t batches, Reactor& reactor) {
+    SampleBatch batch;
+    int32_t lo = INT32_MAX;
+    int32_t hi = INT32_MIN;
+    size_t samples = 0;
+    size_t done = 0;
+    for (; done < batches; ++done) {
+        ssize_t n = co_await readRange(dev, batch, lo, hi);
+        if (n <= 0) {
+            fprintf(stderr, "%s: read failed: %s\n", path.c_str(), strerror(errno));
+            break;
+        }
+        samples += static_cast<size_t>(n);
+    }
+    printf("%s: %zu batches, %zu samples, %d..%d mC\n", path.c_str(), done, samples,
+           samples ? lo : 0, samples ? hi : 0);
+    if (--running == 0) {
+        reactor.stop();
+    }
+}
+
+Task<void> watchAlerts(AwaitableDevice& dev, const std::string& path) {
+    SimTempSampleExt sample;
+    while (co_await dev.alert(sample)) {
+        printf("%s: threshold crossed at %d mC (seq %llu)\n", path.c_str(), sample.temp_mC,
+               static_cast<unsigned long long>(sample.seq));
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t batches = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10;
+    std::vector<std::string> paths;
+    for (int i = 2; i < argc; ++i) {
+        paths.push_back(argv[i]);
+    }
+    if (paths.empty()) {
+        paths.push_back(DEVICE_PATH);
+    }
+
+    Reactor reactor;
+    if (!reactor.open()) {
+        fprintf(stderr, "Failed to create the reactor: %s\n", strerror(errno));
+        return 1;
+    }
+
+    std::vector<AwaitableDevice*> devices;
+    size_t opened = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        AwaitableDevice* dev = new AwaitableDevice(reactor, paths[i]);
+        devices.push_back(dev);
+        if (!dev->open()) {
+            fprintf(stderr, "Failed to open %s: %s\n", paths[i].c_str(), strerror(errno));
+            continue;
+        }
+        opened++;
+        running++;
+        spawn(watchBatches(*dev, paths[i], batches, reactor));
+        spawn(watchAlerts(*dev, paths[i]));
+    }
+
+    int status = 0;
+    if (opened > 0 && !reactor.run()) {
+        fprintf(stderr, "Reactor failed: %s\n", strerror(errno));
+        status = 1;
+    }
+
+    // Closing fails the alert waits, which lets those tasks finish
+    for (size_t i = 0; i < devices.size(); ++i) {
+        devices[i]->close();
+    }
+    while (reactor.runOnce(0) > 0) {
+    }
+    for (size_t i = 0; i < devices.size(); ++i) {
+        delete devices[i];
+    }
+    return opened > 0 && status == 0 ? 0 : 1;
+}
@@ -0,0 +1,342 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Streaming EMA, sliding median and fixed-point Kalman filters.
+ */
+
+#include "filter.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace simtemp {
+
+static const int64_t ONE_Q16 = 1 << 16;
+
+static int32_t roundQ16(int64_t value_q16) {
+    return static_cast<int32_t>((value_q16 + ONE_Q16 / 2) >> 16);
+}
+
+/* EMA */
+
+EmaFilter::EmaFilter(double alpha) : alpha(alpha) {
+    int64_t a = static_cast<int64_t>(alpha * ONE_Q16 + 0.5);
+    alpha_q16 = a < 1 ? 1 : (a > ONE_Q16 ? ONE_Q16 : a);
+    reset();
+}
+
+void EmaFilter::reset() {
+    state_q16 = 0;
+    primed = false;
+}
+
+void EmaFilter::process(const int32_t* in, int32_t* out, size_t n) {
+    if (n == 0) {
+        return;
+    }
+    if (!primed) {
+        state_q16 = static_cast<int64_t>(in[0]) << 16;
+        primed = true;
+    }
+
+    int64_t state = state_q16;
+    for (size_t i = 0; i < n; ++i) {
+        int64_t x = static_cast<int64_t>(in[i]) << 16;
+        state += (alpha_q16 * (x - state)) >> 16;
+        out[i] = roundQ16(state);
+    }
+    state_q16 = state;
+}
+
+std::string EmaFilter::name() const {
+    std::ostringstream oss;
+    oss << "ema:" << alpha;
+    return oss.str();
+}
+
+/* Median */
+
+MedianFilter::MedianFilter(size_t window)
+    : window(window ? window : 1), value(this->window), side(this->window), pos(this->window),
+      lower(this->window), upper(this->window) {
+    reset();
+}
+
+void MedianFilter::reset() {
+    lower_size = 0;
+    upper_size = 0;
+    next = 0;
+    count = 0;
+}
+
+bool MedianFilter::before(uint8_t heap, uint32_t a, uint32_t b) const {
+    return heap == 0 ? value[a] > value[b] : value[a] < value[b];
+}
+
+void MedianFilter::place(uint8_t heap, size_t i, uint32_t slot) {
+    (heap == 0 ? lower : upper)[i] = slot;
+    pos[slot] = static_cast<uint32_t>(i);
+    side[slot] = heap;
+}
+
+void MedianFilter::siftUp(uint8_t heap, size_t i) {
+    std::vector<uint32_t>& h = heap == 0 ? lower : upper;
+    uint32_t slot = h[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!before(heap, slot, h[parent])) {
+            break;
+        }
+        place(heap, i, h[parent]);
+        i = parent;
+    }
+    place(heap, i, slot);
+}
+
+void MedianFilter::siftDown(uint8_t heap, size_t i) {
+    std::vector<uint32_t>& h = heap == 0 ? lower : upper;
+    size_t size = heap == 0 ? lower_size : upper_size;
+    uint32_t slot = h[i];
+    while (true) {
+        size_t child = 2 * i + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && before(heap, h[child + 1], h[child])) {
+            child++;
+        }
+        if (!before(heap, h[child], slot)) {
+            break;
+        }
+        place(heap, i, h[child]);
+        i = child;
+    }
+    place(heap, i, slot);
+}
+
+void MedianFilter::fix(uint8_t heap, size_t i) {
+    std::vector<uint32_t>& h = heap == 0 ? lower : upper;
+    if (i > 0 && before(heap, h[i], h[(i - 1) / 2])) {
+        siftUp(heap, i);
+    } else {
+        siftDown(heap, i);
+    }
+}
+
+// Only one value changed, so at most the two tops are out of order
+void MedianFilter::rebalanceTops() {
+    if (lower_size == 0 || upper_size == 0 || value[lower[0]] <= value[upper[0]]) {
+        return;
+    }
+    uint32_t a = lower[0];
+    uint32_t b = upper[0];
+    place(0, 0, b);
+    place(1, 0, a);
+    siftDown(0, 0);
+    siftDown(1, 0);
+}
+
+void MedianFilter::insert(uint32_t slot) {
+    if (lower_size == 0 || value[slot] <= value[lower[0]]) {
+        place(0, lower_size++, slot);
+        siftUp(0, lower_size - 1);
+    } else {
+        place(1, upper_size++, slot);
+        siftUp(1, upper_size - 1);
+    }
+
+    // Keep lower_size == upper_size or upper_size + 1
+    if (lower_size > upper_size + 1) {
+        uint32_t top = lower[0];
+        place(0, 0, lower[--lower_size]);
+        siftDown(0, 0);
+        place(1, upper_size++, top);
+        siftUp(1, upper_size - 1);
+    } else if (upper_size > lower_size) {
+        uint32_t top = upper[0];
+        place(1, 0, upper[--upper_size]);
+        if (upper_size > 0) {
+            siftDown(1, 0);
+        }
+        place(0, lower_size++, top);
+        siftUp(0, lower_size - 1);
+    }
+}
+
+int32_t MedianFilter::median() const {
+    if (lower_size > upper_size) {
+        return value[lower[0]];
+    }
+    int64_t sum = static_cast<int64_t>(value[lower[0]]) + value[upper[0]];
+    return static_cast<int32_t>(sum / 2);
+}
+
+void MedianFilter::process(const int32_t* in, int32_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t slot = static_cast<uint32_t>(next);
+        value[slot] = in[i];
+        if (count < window) {
+            insert(slot);
+            count++;
+        } else {
+            // Overwrite the oldest sample in place and restore heap order
+            fix(side[slot], pos[slot]);
+            rebalanceTops();
+        }
+        next = next + 1 == window ? 0 : next + 1;
+        out[i] = median();
+    }
+}
+
+std::string MedianFilter::name() const {
+    std::ostringstream oss;
+    oss << "median:" << window;
+    return oss.str();
+}
+
+/* Kalman */
+
+KalmanFilter::KalmanFilter(uint32_t process_noise_mC2, uint32_t measurement_noise_mC2)
+    : q_mC2(process_noise_mC2), r_mC2(measurement_noise_mC2 ? measurement_noise_mC2 : 1) {
+    reset();
+}
+
+void KalmanFilter::reset() {
+    x_q16 = 0;
+    p_mC2 = 0;
+    k_q16 = 0;
+    primed = false;
+}
+
+void KalmanFilter::process(const int32_t* in, int32_t* out, size_t n) {
+    if (n == 0) {
+        return;
+    }
+    if (!primed) {
+        x_q16 = static_cast<int64_t>(in[0]) << 16;
+        p_mC2 = r_mC2;
+        primed = true;
+    }
+
+    int64_t x = x_q16;
+    int64_t p = p_mC2;
+    int64_t k = k_q16;
+    for (size_t i = 0; i < n; ++i) {
+        int64_t p_pred = p + q_mC2;
+        k = (p_pred << 16) / (p_pred + r_mC2);
+        // Innovation scaled down by 8 bits first to leave headroom for the gain
+        int64_t innovation = (static_cast<int64_t>(in[i]) << 16) - x;
+        x += (k * (innovation >> 8)) >> 8;
+        p = ((ONE_Q16 - k) * p_pred) >> 16;
+        out[i] = roundQ16(x);
+    }
+    x_q16 = x;
+    p_mC2 = p;
+    k_q16 = k;
+}
+
+std::string KalmanFilter::name() const {
+    std::ostringstream oss;
+    oss << "kalman:" << q_mC2 << ":" << r_mC2;
+    return oss.str();
+}
+
+/* Chain */
+
+FilterChain::~FilterChain() {
+    for (size_t i = 0; i < filters.size(); ++i) {
+        delete filters[i];
+    }
+}
+
+void FilterChain::add(Filter* filter) {
+    filters.push_back(filter);
+}
+
+void FilterChain::process(const int32_t* in, int32_t* out, size_t n) {
+    if (filters.empty()) {
+        if (in != out) {
+            memmove(out, in, n * sizeof(int32_t));
+        }
+        return;
+    }
+    filters[0]->process(in, out, n);
+    for (size_t i = 1; i < filters.size(); ++i) {
+        filters[i]->process(out, out, n);
+    }
+}
+
+void FilterChain::reset() {
+    for (size_t i = 0; i < filters.size(); ++i) {
+        filters[i]->reset();
+    }
+}
+
+std::string FilterChain::describe() const {
+    std::string text;
+    for (size_t i = 0; i < filters.size(); ++i) {
+        text += (i ? "," : "") + filters[i]->name();
+    }
+    return text;
+}
+
+static bool parseNumber(const std::string& text, double& value) {
+    char* end = NULL;
+    value = strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0';
+}
+
+static Filter* parseFilter(const std::string& spec) {
+    std::vector<std::string> parts;
+    std::stringstream ss(spec);
+    std::string part;
+    while (std::getline(ss, part, ':')) {
+        parts.push_back(part);
+    }
+    if (parts.empty()) {
+        return NULL;
+    }
+
+    double a = 0.0;
+    double b = 0.0;
+    if (parts[0] == "ema" && parts.size() == 2 && parseNumber(parts[1], a) && a > 0.0 && a <= 1.0) {
+        return new EmaFilter(a);
+    }
+    if (parts[0] == "median" && parts.size() == 2 && parseNumber(parts[1], a) &&
+        a >= 1.0 && a <= 65536.0) {
+        return new MedianFilter(static_cast<size_t>(a));
+    }
+    if (parts[0] == "kalman" && parts.size() == 3 && parseNumber(parts[1], a) &&
+        parseNumber(parts[2], b) && a >= 0.0 && b >= 1.0 && a <= 4e9 && b <= 4e9) {
+        return new KalmanFilter(static_cast<uint32_t>(a), static_cast<uint32_t>(b));
+    }
+    return NULL;
+}
+
+bool parseFilterChain(const std::string& spec, FilterChain& chain) {
+    std::vector<Filter*> parsed;
+    std::stringstream ss(spec);
+    std::string item;
+
+    while (std::getline(ss, item, ',')) {
+        Filter* filter = parseFilter(item);
+        if (!filter) {
+            for (size_t i = 0; i < parsed.size(); ++i) {
+                delete parsed[i];
+            }
+            return false;
+        }
+        parsed.push_back(filter);
+    }
+    if (parsed.empty()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < parsed.size(); ++i) {
+        chain.add(parsed[i]);
+    }
+    return true;
+}
+
+} // namespace simtemp
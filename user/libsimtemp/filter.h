@@ -0,0 +1,139 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Streaming smoothing filters over temperature columns. Every filter keeps
+ * its state between calls, so a stream can be fed batch by batch (or one
+ * sample at a time) with the same result. Filters work in integer
+ * milli-degrees; the EMA and Kalman filters carry 16 fractional bits of
+ * state internally.
+ */
+
+#ifndef SIMTEMP_FILTER_H
+#define SIMTEMP_FILTER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+class Filter {
+public:
+    virtual ~Filter() {}
+
+    // Filter n samples from in to out; in and out may be the same array
+    virtual void process(const int32_t* in, int32_t* out, size_t n) = 0;
+    virtual void reset() = 0;
+    virtual std::string name() const = 0;
+};
+
+// First-order IIR: y += alpha * (x - y), alpha in (0, 1]
+class EmaFilter : public Filter {
+private:
+    double alpha;
+    int64_t alpha_q16;
+    int64_t state_q16;
+    bool primed;
+
+public:
+    explicit EmaFilter(double alpha);
+
+    void process(const int32_t* in, int32_t* out, size_t n);
+    void reset();
+    std::string name() const;
+};
+
+/*
+ * Sliding-window median of the last window samples. The window is kept in
+ * two indexed heaps (max-heap of the lower half, min-heap of the upper
+ * half) that record where each ring slot lives, so the outgoing sample is
+ * replaced in place: O(log window) per sample, no allocation after
+ * construction. Even windows output the mean of the two middle values.
+ */
+class MedianFilter : public Filter {
+private:
+    size_t window;
+    std::vector<int32_t> value;     // per ring slot
+    std::vector<uint8_t> side;      // 0: lower heap, 1: upper heap
+    std::vector<uint32_t> pos;      // index of the slot inside its heap
+    std::vector<uint32_t> lower;    // max-heap of slot ids
+    std::vector<uint32_t> upper;    // min-heap of slot ids
+    size_t lower_size;
+    size_t upper_size;
+    size_t next;
+    size_t count;
+
+    bool before(uint8_t heap, uint32_t a, uint32_t b) const;
+    void place(uint8_t heap, size_t i, uint32_t slot);
+    void siftUp(uint8_t heap, size_t i);
+    void siftDown(uint8_t heap, size_t i);
+    void fix(uint8_t heap, size_t i);
+    void rebalanceTops();
+    void insert(uint32_t slot);
+    int32_t median() const;
+
+public:
+    explicit MedianFilter(size_t window);
+
+    void process(const int32_t* in, int32_t* out, size_t n);
+    void reset();
+    std::string name() const;
+};
+
+/*
+ * Scalar Kalman filter for a random-walk temperature, in fixed point.
+ * process_noise and measurement_noise are variances in mC^2; the gain is a
+ * Q16 fraction and converges to its steady-state value after a few dozen
+ * samples.
+ */
+class KalmanFilter : public Filter {
+private:
+    int64_t q_mC2;          // process noise variance
+    int64_t r_mC2;          // measurement noise variance
+    int64_t x_q16;          // estimate, Q16 mC
+    int64_t p_mC2;          // estimate variance
+    int64_t k_q16;          // last gain
+    bool primed;
+
+public:
+    KalmanFilter(uint32_t process_noise_mC2, uint32_t measurement_noise_mC2);
+
+    void process(const int32_t* in, int32_t* out, size_t n);
+    void reset();
+    std::string name() const;
+    int64_t gainQ16() const { return k_q16; }
+};
+
+// Filters applied in order; owns its filters
+class FilterChain {
+private:
+    std::vector<Filter*> filters;
+
+    FilterChain(const FilterChain&);
+    FilterChain& operator=(const FilterChain&);
+
+public:
+    FilterChain() {}
+    ~FilterChain();
+
+    void add(Filter* filter);
+    bool empty() const { return filters.empty(); }
+    size_t size() const { return filters.size(); }
+    Filter& at(size_t i) { return *filters[i]; }
+
+    void process(const int32_t* in, int32_t* out, size_t n);
+    void reset();
+    std::string describe() const;
+};
+
+/*
+ * Build a chain from a comma separated spec, e.g.
+ * "median:5,ema:0.2,kalman:100:250000" (kalman:PROCESS_VAR:MEASUREMENT_VAR).
+ * Returns false on a malformed spec, leaving chain unchanged.
+ */
+bool parseFilterChain(const std::string& spec, FilterChain& chain);
+
+} // namespace simtemp
+
+#endif // SIMTEMP_FILTER_H
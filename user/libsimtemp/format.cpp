@@ -0,0 +1,52 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Text formatting without iostreams.
+ */
+
+#include "format.h"
+
+#include <cstdio>
+#include <ctime>
+
+namespace simtemp {
+
+int formatMilli(char* out, size_t size, int64_t value) {
+    const char* sign = value < 0 ? "-" : "";
+    uint64_t mag = value < 0 ? -static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    return snprintf(out, size, "%s%llu.%03u", sign,
+                    static_cast<unsigned long long>(mag / 1000),
+                    static_cast<unsigned>(mag % 1000));
+}
+
+int formatTemperature(char* out, size_t size, int32_t temp_mC) {
+    char value[32];
+    formatMilli(value, sizeof(value), temp_mC);
+    return snprintf(out, size, "%s°C", value);
+}
+
+int formatTimestamp(char* out, size_t size, uint64_t timestamp_ns) {
+    time_t seconds = static_cast<time_t>(timestamp_ns / 1000000000ULL);
+    struct tm tm;
+    char date[32];
+
+    // localtime_r() does not re-read TZ on every call, unlike localtime()
+    if (!localtime_r(&seconds, &tm) || strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &tm) == 0) {
+        date[0] = '\0';
+    }
+    return snprintf(out, size, "%s.%09uZ", date,
+                    static_cast<unsigned>(timestamp_ns % 1000000000ULL));
+}
+
+int formatSampleLine(char* out, size_t size, uint64_t timestamp_ns, int32_t temp_mC,
+                     uint32_t flags) {
+    char timestamp[48];
+    char temp[32];
+
+    formatTimestamp(timestamp, sizeof(timestamp), timestamp_ns);
+    formatTemperature(temp, sizeof(temp), temp_mC);
+    return snprintf(out, size, "%s temp=%s alert=%d\n", timestamp, temp,
+                    (flags & FLAG_THRESHOLD_CROSSED) ? 1 : 0);
+}
+
+} // namespace simtemp
@@ -0,0 +1,38 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Text formatting without iostreams. Everything is written into a caller
+ * buffer with snprintf and the length is returned, so formatting a sample
+ * allocates nothing. A program that prints through these helpers and stdio
+ * never includes <iostream>, which keeps the iostream static initialisation
+ * (a large part of the startup of a statically linked CLI) out of the
+ * binary altogether.
+ */
+
+#ifndef SIMTEMP_FORMAT_H
+#define SIMTEMP_FORMAT_H
+
+#include "simtemp.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+// Enough for any line produced below
+const size_t FORMAT_LINE_MAX = 128;
+
+// "-12.345": thousandths as a fixed-point decimal, no floating point
+int formatMilli(char* out, size_t size, int64_t value);
+// "25.000°C"
+int formatTemperature(char* out, size_t size, int32_t temp_mC);
+// "2025-01-01T12:00:00.123456789Z", seconds in local time as the CLIs
+// have always printed them
+int formatTimestamp(char* out, size_t size, uint64_t timestamp_ns);
+// "<timestamp> temp=25.000°C alert=0" with a trailing newline
+int formatSampleLine(char* out, size_t size, uint64_t timestamp_ns, int32_t temp_mC,
+                     uint32_t flags);
+
+} // namespace simtemp
+
+#endif // SIMTEMP_FORMAT_H
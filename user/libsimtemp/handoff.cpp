@@ -0,0 +1,435 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Collector handoff over a Unix socket (SCM_RIGHTS + sealed memfd).
+ */
+
+#include "handoff.h"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace simtemp {
+
+enum HandoffMessage {
+    HANDOFF_HELLO = 1,          // successor -> collector
+    HANDOFF_STATE = 2,          // collector -> successor, carries the fds
+    HANDOFF_DRAINING = 3,       // successor -> collector
+    HANDOFF_RELEASED = 4        // collector -> successor, it has stopped
+};
+
+struct HandoffHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t type;
+    uint32_t pid;
+    uint32_t sources;
+};
+
+struct HandoffWireSource {
+    uint32_t format;
+    uint32_t reserved;
+    uint64_t last_seq;
+    uint64_t last_timestamp_ns;
+    uint64_t pending;           // samples for this source in the memfd
+};
+
+// Bytes per pending sample in the memfd: timestamp, temp, flags, seq
+static const size_t PENDING_SAMPLE_BYTES =
+    sizeof(uint64_t) + sizeof(int32_t) + sizeof(uint32_t) + sizeof(uint64_t);
+
+static bool fillAddress(const std::string& path, struct sockaddr_un& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+static bool waitReadable(int fd, int timeout_ms) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int ret;
+    do {
+        ret = poll(&pfd, 1, timeout_ms);
+    } while (ret < 0 && errno == EINTR);
+    if (ret == 0) {
+        errno = ETIMEDOUT;
+    }
+    return ret > 0;
+}
+
+static bool sendHeader(int conn, HandoffMessage type, uint32_t sources) {
+    HandoffHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = HANDOFF_MAGIC;
+    header.version = HANDOFF_VERSION;
+    header.type = type;
+    header.pid = static_cast<uint32_t>(getpid());
+    header.sources = sources;
+    return send(conn, &header, sizeof(header), MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(header));
+}
+
+static bool receiveHeader(int conn, HandoffMessage type, int timeout_ms) {
+    HandoffHeader header;
+    if (!waitReadable(conn, timeout_ms)) {
+        return false;
+    }
+    ssize_t n = recv(conn, &header, sizeof(header), 0);
+    if (n != static_cast<ssize_t>(sizeof(header)) || header.magic != HANDOFF_MAGIC ||
+        header.version != HANDOFF_VERSION || header.type != type) {
+        errno = n < 0 ? errno : EPROTO;
+        return false;
+    }
+    return true;
+}
+
+static bool writeAll(int fd, const void* data, size_t length) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (length > 0) {
+        ssize_t n = ::write(fd, p, length);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        length -= n;
+    }
+    return true;
+}
+
+// Sealed memfd holding every source's pending samples, column by column
+static int packPending(const HandoffState& state) {
+    int fd = memfd_create("simtemp-handoff", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        return -1;
+    }
+    bool ok = true;
+    for (size_t i = 0; ok && i < state.sources.size(); ++i) {
+        const SampleBatch& b = state.sources[i].pending;
+        size_t n = b.size();
+        std::vector<uint64_t> seq(b.seq);
+        seq.resize(n, 0);
+        ok = writeAll(fd, b.timestamp_ns.data(), n * sizeof(uint64_t)) &&
+             writeAll(fd, b.temp_mC.data(), n * sizeof(int32_t)) &&
+             writeAll(fd, b.flags.data(), n * sizeof(uint32_t)) &&
+             writeAll(fd, seq.data(), n * sizeof(uint64_t));
+    }
+    if (!ok || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+static bool unpackPending(int fd, const HandoffWireSource* wire, HandoffState& state,
+                          size_t total) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) != total * PENDING_SAMPLE_BYTES) {
+        errno = EPROTO;
+        return false;
+    }
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    const uint8_t* p = static_cast<const uint8_t*>(map);
+    for (size_t i = 0; i < state.sources.size(); ++i) {
+        SampleBatch& b = state.sources[i].pending;
+        size_t n = wire[i].pending;
+        const uint64_t* ts = reinterpret_cast<const uint64_t*>(p);
+        const int32_t* temp = reinterpret_cast<const int32_t*>(ts + n);
+        const uint32_t* flags = reinterpret_cast<const uint32_t*>(temp + n);
+        const uint64_t* seq = reinterpret_cast<const uint64_t*>(flags + n);
+        b.timestamp_ns.assign(ts, ts + n);
+        b.temp_mC.assign(temp, temp + n);
+        b.flags.assign(flags, flags + n);
+        b.seq.assign(seq, seq + n);
+        p += n * PENDING_SAMPLE_BYTES;
+    }
+    munmap(map, st.st_size);
+    return true;
+}
+
+HandoffListener::HandoffListener() : listen_fd(-1), handed_off(false) {}
+
+HandoffListener::~HandoffListener() {
+    close();
+}
+
+bool HandoffListener::open(const std::string& path) {
+    close();
+
+    struct sockaddr_un addr;
+    if (!fillAddress(path, addr)) {
+        return false;
+    }
+    listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        return false;
+    }
+
+    // The predecessor never removes the path after a handoff; replace it
+    ::unlink(path.c_str());
+    if (bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd, 1) != 0) {
+        int saved = errno;
+        ::close(listen_fd);
+        listen_fd = -1;
+        errno = saved;
+        return false;
+    }
+    socket_path = path;
+    handed_off = false;
+    return true;
+}
+
+void HandoffListener::close() {
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+        listen_fd = -1;
+        if (!handed_off) {
+            ::unlink(socket_path.c_str());
+        }
+    }
+}
+
+int HandoffListener::accept() {
+    if (listen_fd < 0) {
+        errno = EBADF;
+        return -1;
+    }
+    return accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+}
+
+bool HandoffListener::handOff(int conn, const HandoffState& state, int timeout_ms) {
+    size_t n = state.sources.size();
+    if (n == 0 || n > HANDOFF_MAX_SOURCES) {
+        ::close(conn);
+        errno = EINVAL;
+        return false;
+    }
+    if (!receiveHeader(conn, HANDOFF_HELLO, timeout_ms)) {
+        int saved = errno;
+        ::close(conn);
+        errno = saved;
+        return false;
+    }
+
+    std::vector<uint8_t> message(sizeof(HandoffHeader) + n * sizeof(HandoffWireSource));
+    HandoffHeader* header = reinterpret_cast<HandoffHeader*>(message.data());
+    header->magic = HANDOFF_MAGIC;
+    header->version = HANDOFF_VERSION;
+    header->type = HANDOFF_STATE;
+    header->pid = static_cast<uint32_t>(getpid());
+    header->sources = static_cast<uint32_t>(n);
+
+    std::vector<int> fds;
+    size_t pending = 0;
+    HandoffWireSource* wire = reinterpret_cast<HandoffWireSource*>(header + 1);
+    for (size_t i = 0; i < n; ++i) {
+        const HandoffSource& src = state.sources[i];
+        wire[i].format = src.format;
+        wire[i].reserved = 0;
+        wire[i].last_seq = src.last_seq;
+        wire[i].last_timestamp_ns = src.last_timestamp_ns;
+        wire[i].pending = src.pending.size();
+        pending += src.pending.size();
+        fds.push_back(src.fd);
+    }
+
+    int memfd = -1;
+    if (pending > 0) {
+        memfd = packPending(state);
+        if (memfd < 0) {
+            int saved = errno;
+            ::close(conn);
+            errno = saved;
+            return false;
+        }
+        fds.push_back(memfd);
+    }
+
+    struct iovec iov = { message.data(), message.size() };
+    std::vector<uint8_t> control(CMSG_SPACE(fds.size() * sizeof(int)), 0);
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(fds.size() * sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds.data(), fds.size() * sizeof(int));
+
+    bool ok = sendmsg(conn, &msg, MSG_NOSIGNAL) == static_cast<ssize_t>(message.size()) &&
+              receiveHeader(conn, HANDOFF_DRAINING, timeout_ms);
+    int saved = errno;
+    if (ok) {
+        // Stopped from here on, whether or not the successor hears it
+        sendHeader(conn, HANDOFF_RELEASED, 0);
+    }
+    if (memfd >= 0) {
+        ::close(memfd);
+    }
+    ::close(conn);
+    errno = saved;
+
+    if (ok) {
+        handed_off = true;
+    }
+    return ok;
+}
+
+HandoffClient::HandoffClient() : conn(-1) {}
+
+HandoffClient::~HandoffClient() {
+    close();
+}
+
+bool HandoffClient::take(const std::string& path, HandoffState& state, int timeout_ms) {
+    close();
+    state.pid = 0;
+    state.sources.clear();
+
+    struct sockaddr_un addr;
+    if (!fillAddress(path, addr)) {
+        return false;
+    }
+    conn = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (conn < 0) {
+        return false;
+    }
+    if (connect(conn, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        !sendHeader(conn, HANDOFF_HELLO, 0) || !waitReadable(conn, timeout_ms)) {
+        int saved = errno;
+        close();
+        errno = saved;
+        return false;
+    }
+
+    std::vector<uint8_t> message(sizeof(HandoffHeader) +
+                                 HANDOFF_MAX_SOURCES * sizeof(HandoffWireSource));
+    std::vector<uint8_t> control(CMSG_SPACE((HANDOFF_MAX_SOURCES + 1) * sizeof(int)), 0);
+    struct iovec iov = { message.data(), message.size() };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+
+    ssize_t got = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC);
+    if (got < 0) {
+        int saved = errno;
+        close();
+        errno = saved;
+        return false;
+    }
+
+    // Take ownership of every received fd before validating anything
+    std::vector<int> fds;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const uint8_t* data = CMSG_DATA(cmsg);
+            for (size_t i = 0; i < count; ++i) {
+                int fd;
+                memcpy(&fd, data + i * sizeof(int), sizeof(int));
+                fds.push_back(fd);
+            }
+        }
+    }
+
+    const HandoffHeader* header = reinterpret_cast<const HandoffHeader*>(message.data());
+    const HandoffWireSource* wire = reinterpret_cast<const HandoffWireSource*>(header + 1);
+    size_t pending = 0;
+    bool ok = !(msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) &&
+              got >= static_cast<ssize_t>(sizeof(HandoffHeader)) &&
+              header->magic == HANDOFF_MAGIC && header->version == HANDOFF_VERSION &&
+              header->type == HANDOFF_STATE && header->sources > 0 &&
+              header->sources <= HANDOFF_MAX_SOURCES &&
+              got == static_cast<ssize_t>(sizeof(HandoffHeader) +
+                                          header->sources * sizeof(HandoffWireSource));
+    if (ok) {
+        for (size_t i = 0; i < header->sources; ++i) {
+            pending += wire[i].pending;
+        }
+        ok = fds.size() == header->sources + (pending > 0 ? 1 : 0);
+    }
+    if (ok) {
+        state.pid = header->pid;
+        state.sources.resize(header->sources);
+        for (size_t i = 0; i < header->sources; ++i) {
+            HandoffSource& src = state.sources[i];
+            src.fd = fds[i];
+            src.format = wire[i].format == RECORD_EXTENDED ? RECORD_EXTENDED : RECORD_BASIC;
+            src.last_seq = wire[i].last_seq;
+            src.last_timestamp_ns = wire[i].last_timestamp_ns;
+            src.pending.clear();
+        }
+        if (pending > 0) {
+            ok = unpackPending(fds.back(), wire, state, pending);
+        } else {
+            errno = 0;
+        }
+    } else {
+        errno = EPROTO;
+    }
+
+    int saved = errno;
+    if (pending > 0) {
+        ::close(fds.back());
+        fds.pop_back();
+    }
+    if (!ok) {
+        for (size_t i = 0; i < fds.size(); ++i) {
+            ::close(fds[i]);
+        }
+        state.sources.clear();
+        close();
+        errno = saved;
+        return false;
+    }
+    return true;
+}
+
+bool HandoffClient::confirm(int timeout_ms) {
+    if (conn < 0) {
+        errno = EBADF;
+        return false;
+    }
+    // A collector whose wait ran out closes the connection instead
+    bool ok = sendHeader(conn, HANDOFF_DRAINING, 0) && receiveHeader(conn, HANDOFF_RELEASED, timeout_ms);
+    int saved = errno;
+    close();
+    errno = saved;
+    return ok;
+}
+
+void HandoffClient::close() {
+    if (conn >= 0) {
+        ::close(conn);
+        conn = -1;
+    }
+}
+
+} // namespace simtemp
@@ -0,0 +1,105 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Collector handoff for upgrades without losing samples. The running
+ * collector listens on a Unix socket; its successor connects and receives,
+ * in one SOCK_SEQPACKET message:
+ *
+ *   - the open device files (SCM_RIGHTS), with their record format already
+ *     selected, so the driver keeps buffering into the same open files
+ *   - per device the read cursor (last sequence number and timestamp
+ *     delivered)
+ *   - samples already read but not yet consumed, in a sealed memfd (also
+ *     SCM_RIGHTS), laid out per device as timestamp/temp/flags/seq columns
+ *
+ * The successor confirms before it reads or writes anything, and the
+ * predecessor acknowledges that it has stopped for good. Without a
+ * confirmation within the timeout the predecessor keeps collecting, so a
+ * failed upgrade loses nothing either; the successor then gets no
+ * acknowledgement and must leave the predecessor's files alone.
+ */
+
+#ifndef SIMTEMP_HANDOFF_H
+#define SIMTEMP_HANDOFF_H
+
+#include "simtemp.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+const uint32_t HANDOFF_MAGIC = 0x48504d53;     // "SMPH"
+const uint16_t HANDOFF_VERSION = 2;
+const size_t HANDOFF_MAX_SOURCES = 64;
+
+struct HandoffSource {
+    int fd;                     // open device file (owned by the receiver)
+    RecordFormat format;
+    uint64_t last_seq;          // read cursor: last sequence number delivered
+    uint64_t last_timestamp_ns;
+    SampleBatch pending;        // read from fd but not yet consumed
+};
+
+struct HandoffState {
+    uint32_t pid;               // sender
+    std::vector<HandoffSource> sources;
+};
+
+class HandoffListener {
+private:
+    std::string socket_path;
+    int listen_fd;
+    bool handed_off;
+
+    HandoffListener(const HandoffListener&);
+    HandoffListener& operator=(const HandoffListener&);
+
+public:
+    HandoffListener();
+    ~HandoffListener();
+
+    // Listen on path (a stale socket file is replaced)
+    bool open(const std::string& path);
+    // Stop listening; the socket file is removed unless a successor took over
+    // (it listens on the same path)
+    void close();
+
+    // Nonblocking: a connected successor, or -1 (errno EAGAIN) when none waits
+    int accept();
+    // Send state over conn (from accept()) and wait up to timeout_ms for the
+    // successor to confirm it takes over. conn is closed. On success the
+    // caller must stop writing; on failure it still owns everything and
+    // should keep collecting.
+    bool handOff(int conn, const HandoffState& state, int timeout_ms = 10000);
+
+    bool isOpen() const { return listen_fd >= 0; }
+    int fd() const { return listen_fd; }
+};
+
+class HandoffClient {
+private:
+    int conn;
+
+    HandoffClient(const HandoffClient&);
+    HandoffClient& operator=(const HandoffClient&);
+
+public:
+    HandoffClient();
+    ~HandoffClient();
+
+    // Connect to the collector listening on path and receive its state.
+    // Fails with ENOENT or ECONNREFUSED when nobody is listening.
+    bool take(const std::string& path, HandoffState& state, int timeout_ms = 10000);
+    // Tell the predecessor to stop and wait up to timeout_ms for it to
+    // acknowledge. Only after true may the successor write to the files the
+    // predecessor was writing. The connection is closed either way.
+    bool confirm(int timeout_ms = 10000);
+    void close();
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_HANDOFF_H
@@ -0,0 +1,177 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Inter-arrival jitter, gap and drift analysis.
+ */
+
+#include "jitter.h"
+
+#include <cmath>
+
+namespace simtemp {
+
+JitterAnalyzer::JitterAnalyzer(const JitterConfig& cfg)
+    : config(cfg), auto_width(cfg.bucket_ns == 0) {
+    if (config.period_ns == 0) {
+        config.period_ns = 1;
+    }
+    if (config.buckets == 0) {
+        config.buckets = 1;
+    }
+    config.buckets |= 1;
+    if (config.drift_window == 0) {
+        config.drift_window = 1;
+    }
+    if (config.drift_points == 0) {
+        config.drift_points = 1;
+    }
+    setPeriod(config.period_ns);
+}
+
+void JitterAnalyzer::setPeriod(uint64_t period_ns) {
+    config.period_ns = period_ns ? period_ns : 1;
+    if (auto_width) {
+        config.bucket_ns = config.period_ns / 50 ? config.period_ns / 50 : 1;
+    }
+    reset();
+}
+
+void JitterAnalyzer::reset() {
+    histogram.assign(config.buckets + 2, 0);
+    drift.assign(config.drift_points, DriftPoint());
+    drift_next = 0;
+    drift_count = 0;
+    last_ns = 0;
+    primed = false;
+    intervals = 0;
+    on_time = 0;
+    gaps = 0;
+    missed = 0;
+    duplicates = 0;
+    backwards = 0;
+    worst_gap_ns = 0;
+    dev_mean = 0.0;
+    dev_m2 = 0.0;
+    dev_min = 0;
+    dev_max = 0;
+    window_start_ns = 0;
+    window_intervals = 0;
+}
+
+void JitterAnalyzer::account(uint64_t ts) {
+    if (!primed) {
+        primed = true;
+        last_ns = ts;
+        window_start_ns = ts;
+        return;
+    }
+
+    intervals++;
+    if (ts == last_ns) {
+        duplicates++;
+        return;
+    }
+    if (ts < last_ns) {
+        // Keep measuring from the newest timestamp seen
+        backwards++;
+        return;
+    }
+
+    uint64_t dt = ts - last_ns;
+    last_ns = ts;
+
+    // Anything rounding to two or more periods is a gap (divide only then)
+    if (dt >= config.period_ns + (config.period_ns + 1) / 2) {
+        gaps++;
+        missed += (dt + config.period_ns / 2) / config.period_ns - 1;
+        if (dt > worst_gap_ns) {
+            worst_gap_ns = dt;
+        }
+        // A gap says nothing about the period; restart the drift window
+        window_start_ns = ts;
+        window_intervals = 0;
+        return;
+    }
+
+    on_time++;
+    int64_t dev = static_cast<int64_t>(dt) - static_cast<int64_t>(config.period_ns);
+    double delta = dev - dev_mean;
+    dev_mean += delta / on_time;
+    dev_m2 += delta * (dev - dev_mean);
+    if (on_time == 1 || dev < dev_min) {
+        dev_min = dev;
+    }
+    if (on_time == 1 || dev > dev_max) {
+        dev_max = dev;
+    }
+
+    int64_t width = static_cast<int64_t>(config.bucket_ns);
+    int64_t shifted = dev + width / 2;
+    int64_t index = (shifted >= 0 ? shifted / width : -((-shifted + width - 1) / width)) +
+                    static_cast<int64_t>(config.buckets / 2);
+    if (index < 0) {
+        histogram.front()++;
+    } else if (index >= static_cast<int64_t>(config.buckets)) {
+        histogram.back()++;
+    } else {
+        histogram[index + 1]++;
+    }
+
+    if (++window_intervals == config.drift_window) {
+        DriftPoint& point = drift[drift_next];
+        point.end_ns = ts;
+        point.mean_interval_ns = static_cast<double>(ts - window_start_ns) / window_intervals;
+        point.drift_ppm = (point.mean_interval_ns - config.period_ns) * 1e6 / config.period_ns;
+        drift_next = (drift_next + 1) % drift.size();
+        if (drift_count < drift.size()) {
+            drift_count++;
+        }
+        window_start_ns = ts;
+        window_intervals = 0;
+    }
+}
+
+void JitterAnalyzer::process(const uint64_t* timestamp_ns, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        account(timestamp_ns[i]);
+    }
+}
+
+double JitterAnalyzer::stddevDeviation() const {
+    return on_time > 1 ? std::sqrt(dev_m2 / (on_time - 1)) : 0.0;
+}
+
+int64_t JitterAnalyzer::bucketLow(size_t i) const {
+    int64_t width = static_cast<int64_t>(config.bucket_ns);
+    return (static_cast<int64_t>(i) - static_cast<int64_t>(config.buckets / 2)) * width - width / 2;
+}
+
+int64_t JitterAnalyzer::percentileDeviation(double p) const {
+    if (on_time == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(p * on_time));
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = histogram.front();
+    if (seen >= rank) {
+        return dev_min;
+    }
+    for (size_t i = 0; i < config.buckets; ++i) {
+        seen += histogram[i + 1];
+        if (seen >= rank) {
+            // Bucket centre
+            return bucketLow(i) + static_cast<int64_t>(config.bucket_ns / 2);
+        }
+    }
+    return dev_max;
+}
+
+const DriftPoint& JitterAnalyzer::driftPoint(size_t i) const {
+    size_t oldest = drift_count < drift.size() ? 0 : drift_next;
+    return drift[(oldest + i) % drift.size()];
+}
+
+} // namespace simtemp
@@ -0,0 +1,115 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Inter-arrival analysis of delivered samples against the configured
+ * period. Each interval between consecutive timestamps is classified as
+ * on time (its deviation from the period goes into a fixed histogram),
+ * a gap (missed periods counted), a duplicate or a backwards step. The
+ * mean interval is also tracked over consecutive windows to show period
+ * drift. Everything is O(1) per sample with fixed storage, so an
+ * analyzer can stay attached to a production stream.
+ */
+
+#ifndef SIMTEMP_JITTER_H
+#define SIMTEMP_JITTER_H
+
+#include "simtemp.h"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+struct JitterConfig {
+    uint64_t period_ns;         // configured sampling period
+    uint64_t bucket_ns;         // histogram resolution (0: period / 50)
+    unsigned buckets;           // odd; centred on zero deviation
+    unsigned drift_window;      // intervals per drift point
+    unsigned drift_points;      // drift history kept
+
+    JitterConfig(uint64_t period_ns = 100000000ULL)
+        : period_ns(period_ns), bucket_ns(0), buckets(101), drift_window(100),
+          drift_points(64) {}
+};
+
+// Mean interval over one drift window
+struct DriftPoint {
+    uint64_t end_ns;            // timestamp closing the window
+    double mean_interval_ns;
+    double drift_ppm;           // (mean - period) / period
+};
+
+class JitterAnalyzer {
+private:
+    JitterConfig config;
+    bool auto_width;                    // bucket_ns follows the period
+    std::vector<uint64_t> histogram;    // buckets + underflow + overflow
+    std::vector<DriftPoint> drift;      // ring of drift_points
+    size_t drift_next;
+    size_t drift_count;
+
+    uint64_t last_ns;
+    bool primed;
+    uint64_t intervals;
+    uint64_t on_time;
+    uint64_t gaps;
+    uint64_t missed;
+    uint64_t duplicates;
+    uint64_t backwards;
+    uint64_t worst_gap_ns;
+
+    // Welford over on-time deviations
+    double dev_mean;
+    double dev_m2;
+    int64_t dev_min;
+    int64_t dev_max;
+
+    uint64_t window_start_ns;
+    unsigned window_intervals;
+
+    void account(uint64_t ts);
+
+public:
+    explicit JitterAnalyzer(const JitterConfig& config);
+
+    void process(const uint64_t* timestamp_ns, size_t n);
+    void process(const SampleBatch& batch) { process(batch.timestamp_ns.data(), batch.size()); }
+    // New configured period (e.g. sampling_ms changed); statistics restart
+    void setPeriod(uint64_t period_ns);
+    void reset();
+
+    uint64_t period() const { return config.period_ns; }
+    uint64_t intervalCount() const { return intervals; }
+    uint64_t onTimeCount() const { return on_time; }
+    uint64_t gapCount() const { return gaps; }
+    uint64_t missedPeriods() const { return missed; }
+    uint64_t duplicateCount() const { return duplicates; }
+    uint64_t backwardsCount() const { return backwards; }
+    uint64_t worstGap() const { return worst_gap_ns; }
+
+    // Deviation of on-time intervals from the period, in ns
+    double meanDeviation() const { return dev_mean; }
+    double stddevDeviation() const;
+    int64_t minDeviation() const { return on_time ? dev_min : 0; }
+    int64_t maxDeviation() const { return on_time ? dev_max : 0; }
+    // Histogram percentile (p in [0, 1]) at bucket resolution
+    int64_t percentileDeviation(double p) const;
+
+    // Histogram: bucketCount() centred buckets of bucketWidth() ns,
+    // plus underflow/overflow counts
+    size_t bucketCount() const { return config.buckets; }
+    uint64_t bucketWidth() const { return config.bucket_ns; }
+    int64_t bucketLow(size_t i) const;
+    uint64_t bucket(size_t i) const { return histogram[i + 1]; }
+    uint64_t underflow() const { return histogram.front(); }
+    uint64_t overflow() const { return histogram.back(); }
+
+    // Drift points, oldest first
+    size_t driftCount() const { return drift_count; }
+    const DriftPoint& driftPoint(size_t i) const;
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_JITTER_H
@@ -0,0 +1,278 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Loser-tree merge of time-ordered sample sources.
+ */
+
+#include "merge.h"
+
+#include <cstdio>
+
+namespace simtemp {
+
+static const uint64_t NO_SAMPLE = UINT64_MAX;
+
+bool RecordingSource::open(const std::string& path) {
+    file_path = path;
+    chunk = 0;
+    damaged_chunks = 0;
+    damaged_samples = 0;
+    return reader.open(path);
+}
+
+int RecordingSource::next(MergeSpan& span) {
+    // The CRC is checked as each chunk is handed out, while it is read anyway
+    while (chunk < reader.chunkCount() && !reader.chunkIntact(chunk)) {
+        const RecordingChunk& bad = reader.chunk(chunk++);
+        damaged_chunks++;
+        damaged_samples += bad.count;
+        fprintf(stderr, "%s: chunk at offset %llu fails its CRC, %zu samples skipped\n",
+                file_path.c_str(), static_cast<unsigned long long>(bad.offset), bad.count);
+    }
+    if (chunk >= reader.chunkCount()) {
+        return -1;
+    }
+
+    const RecordingChunk& c = reader.chunk(chunk++);
+    span.timestamp_ns = c.timestamp_ns;
+    span.temp_mC = c.temp_mC;
+    span.flags = c.flags;
+    span.seq = NULL;
+    span.count = c.count;
+    return 1;
+}
+
+DeviceSource::DeviceSource(int fd, RecordFormat format, size_t max_batch)
+    : fd(fd), format(format), max_batch(max_batch ? max_batch : DEFAULT_CHUNK_SAMPLES) {
+    batch.reserve(this->max_batch);
+}
+
+int DeviceSource::next(MergeSpan& span) {
+    batch.clear();
+    ssize_t got = readBatch(fd, batch, max_batch, -1, format);
+    if (got < 0) {
+        return -1;
+    }
+    if (got == 0) {
+        return 0;
+    }
+
+    span.timestamp_ns = batch.timestamp_ns.data();
+    span.temp_mC = batch.temp_mC.data();
+    span.flags = batch.flags.data();
+    span.seq = batch.seq.data();
+    span.count = batch.size();
+    return 1;
+}
+
+StreamMerger::StreamMerger(uint64_t window_ns)
+    : window_ns(window_ns), newest_ns(0), last_out_ns(0), emitted(0), late(0),
+      starved(0), done(0), built(false) {}
+
+void StreamMerger::addSource(MergeSource* source, uint32_t id) {
+    Input in;
+    in.source = source;
+    in.id = id;
+    in.span = MergeSpan();
+    in.pos = 0;
+    in.state = INPUT_STARVED;
+    inputs.push_back(in);
+    head_ns.push_back(NO_SAMPLE);
+    starved++;
+
+    // The new input is fetched by the next call like any starved one
+    if (built) {
+        buildTree();
+    }
+}
+
+void StreamMerger::refill(uint32_t i) {
+    Input& in = inputs[i];
+    if (in.state == INPUT_DONE) {
+        return;
+    }
+
+    int ret;
+    do {
+        ret = in.source->next(in.span);
+    } while (ret > 0 && in.span.count == 0);
+
+    InputState state = ret > 0 ? INPUT_ACTIVE : (ret == 0 ? INPUT_STARVED : INPUT_DONE);
+    if (in.state == INPUT_STARVED) {
+        starved--;
+    }
+    if (state == INPUT_STARVED) {
+        starved++;
+    } else if (state == INPUT_DONE) {
+        done++;
+    }
+    in.state = state;
+
+    if (state == INPUT_ACTIVE) {
+        in.pos = 0;
+        head_ns[i] = in.span.timestamp_ns[0];
+        uint64_t tail_ns = in.span.timestamp_ns[in.span.count - 1];
+        if (tail_ns > newest_ns) {
+            newest_ns = tail_ns;
+        }
+    } else {
+        head_ns[i] = NO_SAMPLE;
+    }
+}
+
+void StreamMerger::buildTree() {
+    size_t k = inputs.size();
+    tree.assign(k ? k : 1, 0);
+    if (k <= 1) {
+        return;
+    }
+
+    // Leaves are nodes k..2k-1; play every match once bottom-up
+    std::vector<uint32_t> winner(2 * k);
+    for (size_t i = 0; i < k; ++i) {
+        winner[k + i] = static_cast<uint32_t>(i);
+    }
+    for (size_t n = k - 1; n >= 1; --n) {
+        uint32_t a = winner[2 * n];
+        uint32_t b = winner[2 * n + 1];
+        if (less(b, a)) {
+            tree[n] = a;
+            winner[n] = b;
+        } else {
+            tree[n] = b;
+            winner[n] = a;
+        }
+    }
+    tree[0] = winner[1];
+}
+
+void StreamMerger::replay(uint32_t i) {
+    // Only valid for the current winner: its path holds every other contender
+    // Branch-free select: with interleaved sources the outcome is random
+    uint32_t w = i;
+    uint64_t w_ns = head_ns[i];
+    for (size_t n = (i + inputs.size()) >> 1; n > 0; n >>= 1) {
+        uint32_t c = tree[n];
+        uint64_t c_ns = head_ns[c];
+        bool swap = c_ns < w_ns || (c_ns == w_ns && c < w);
+        tree[n] = swap ? w : c;
+        w = swap ? c : w;
+        w_ns = swap ? c_ns : w_ns;
+    }
+    tree[0] = w;
+}
+
+bool StreamMerger::reviveStarved() {
+    if (starved == 0) {
+        return false;
+    }
+
+    bool revived = false;
+    for (uint32_t i = 0; i < inputs.size(); ++i) {
+        if (inputs[i].state == INPUT_STARVED) {
+            refill(i);
+            revived |= (inputs[i].state == INPUT_ACTIVE);
+        }
+    }
+    return revived;
+}
+
+size_t StreamMerger::merge(MergedBatch& out, size_t max_samples, uint64_t watermark, bool gate) {
+    // Grow the output a chunk at a time, so a large max_samples does not
+    // allocate more than is actually merged
+    size_t total = 0;
+    while (total < max_samples) {
+        size_t step = max_samples - total;
+        if (step > DEFAULT_CHUNK_SAMPLES) {
+            step = DEFAULT_CHUNK_SAMPLES;
+        }
+        size_t n = mergeRun(out, step, watermark, gate);
+        total += n;
+        if (n < step) {
+            break;
+        }
+    }
+    return total;
+}
+
+size_t StreamMerger::mergeRun(MergedBatch& out, size_t max_samples, uint64_t watermark, bool gate) {
+    if (inputs.empty() || max_samples == 0) {
+        return 0;
+    }
+
+    // Write through raw column pointers and trim afterwards
+    size_t base = out.size();
+    out.samples.timestamp_ns.resize(base + max_samples);
+    out.samples.temp_mC.resize(base + max_samples);
+    out.samples.flags.resize(base + max_samples);
+    out.samples.seq.resize(base + max_samples);
+    out.source.resize(base + max_samples);
+    uint64_t* o_ts = &out.samples.timestamp_ns[base];
+    int32_t* o_temp = &out.samples.temp_mC[base];
+    uint32_t* o_flags = &out.samples.flags[base];
+    uint64_t* o_seq = &out.samples.seq[base];
+    uint32_t* o_src = &out.source[base];
+
+    size_t n = 0;
+    while (n < max_samples) {
+        uint32_t w = tree[0];
+        uint64_t ts = head_ns[w];
+        if (ts == NO_SAMPLE || (gate && starved > 0 && ts > watermark)) {
+            break;
+        }
+
+        Input& in = inputs[w];
+        size_t p = in.pos;
+        o_ts[n] = ts;
+        o_temp[n] = in.span.temp_mC[p];
+        o_flags[n] = in.span.flags[p];
+        o_seq[n] = in.span.seq ? in.span.seq[p] : 0;
+        o_src[n] = in.id;
+        n++;
+
+        if (ts < last_out_ns) {
+            late++;
+        } else {
+            last_out_ns = ts;
+        }
+
+        if (++p < in.span.count) {
+            in.pos = p;
+            head_ns[w] = in.span.timestamp_ns[p];
+        } else {
+            refill(w);
+        }
+        replay(w);
+    }
+
+    out.samples.timestamp_ns.resize(base + n);
+    out.samples.temp_mC.resize(base + n);
+    out.samples.flags.resize(base + n);
+    out.samples.seq.resize(base + n);
+    out.source.resize(base + n);
+    emitted += n;
+    return n;
+}
+
+size_t StreamMerger::next(MergedBatch& out, size_t max_samples, uint64_t now_ns) {
+    bool revived = reviveStarved();
+    if (!built || revived) {
+        built = true;
+        buildTree();
+    }
+
+    uint64_t horizon = now_ns > newest_ns ? now_ns : newest_ns;
+    uint64_t watermark = horizon > window_ns ? horizon - window_ns : 0;
+    return merge(out, max_samples, watermark, true);
+}
+
+size_t StreamMerger::drain(MergedBatch& out, size_t max_samples) {
+    bool revived = reviveStarved();
+    if (!built || revived) {
+        built = true;
+        buildTree();
+    }
+    return merge(out, max_samples, 0, false);
+}
+
+} // namespace simtemp
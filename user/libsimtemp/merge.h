@@ -0,0 +1,163 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Time-ordered k-way merge. Each source hands out spans of samples that are
+ * ordered by timestamp within the source; StreamMerger interleaves them into
+ * one stream sorted by timestamp_ns and tags every sample with its source
+ * id. The current head of each source sits in a loser tree, so choosing the
+ * next sample costs one comparison per tree level and never allocates.
+ *
+ * Live sources may be momentarily empty. The merger cannot know what an
+ * empty source will deliver next, so it only emits samples older than a
+ * watermark (newest timestamp seen, or the caller's clock, minus the
+ * reorder window) while any live source is starved. A sample that still
+ * arrives behind the output is emitted as is and counted as late.
+ */
+
+#ifndef SIMTEMP_MERGE_H
+#define SIMTEMP_MERGE_H
+
+#include "simtemp.h"
+#include "recording.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+// Contiguous run of samples from one source; seq may be NULL
+struct MergeSpan {
+    const uint64_t* timestamp_ns;
+    const int32_t* temp_mC;
+    const uint32_t* flags;
+    const uint64_t* seq;
+    size_t count;
+};
+
+class MergeSource {
+public:
+    virtual ~MergeSource() {}
+
+    // Next span of samples, valid until the following call. Returns 1 when
+    // span was filled, 0 when nothing is available right now (live sources
+    // only) and -1 when the source is finished.
+    virtual int next(MergeSpan& span) = 0;
+    // Live sources can be starved; finite ones only end
+    virtual bool live() const = 0;
+};
+
+// Chunks of a memory-mapped recording, handed out without copying. Chunks
+// failing their CRC are skipped, reported on stderr and counted.
+class RecordingSource : public MergeSource {
+private:
+    RecordingReader reader;
+    std::string file_path;
+    size_t chunk;
+    size_t damaged_chunks;
+    uint64_t damaged_samples;
+
+public:
+    RecordingSource() : chunk(0), damaged_chunks(0), damaged_samples(0) {}
+
+    bool open(const std::string& path);
+    const RecordingReader& recording() const { return reader; }
+    size_t damagedChunks() const { return damaged_chunks; }
+    uint64_t damagedSamples() const { return damaged_samples; }
+
+    virtual int next(MergeSpan& span);
+    virtual bool live() const { return false; }
+};
+
+// Whatever is ready on a nonblocking device fd (not owned)
+class DeviceSource : public MergeSource {
+private:
+    int fd;
+    RecordFormat format;
+    size_t max_batch;
+    SampleBatch batch;
+
+public:
+    DeviceSource(int fd, RecordFormat format, size_t max_batch = DEFAULT_CHUNK_SAMPLES);
+
+    virtual int next(MergeSpan& span);
+    virtual bool live() const { return true; }
+};
+
+// Merged samples with the id of the source each one came from
+struct MergedBatch {
+    SampleBatch samples;
+    std::vector<uint32_t> source;
+
+    size_t size() const { return source.size(); }
+    bool empty() const { return source.empty(); }
+
+    void clear() {
+        samples.clear();
+        source.clear();
+    }
+};
+
+class StreamMerger {
+private:
+    enum InputState {
+        INPUT_ACTIVE,
+        INPUT_STARVED,
+        INPUT_DONE
+    };
+
+    struct Input {
+        MergeSource* source;
+        uint32_t id;
+        MergeSpan span;
+        size_t pos;
+        InputState state;
+    };
+
+    std::vector<Input> inputs;
+    std::vector<uint64_t> head_ns;      // head timestamp per input, UINT64_MAX if none
+    std::vector<uint32_t> tree;         // tree[0] winner, tree[1..k-1] losers
+    uint64_t window_ns;
+    uint64_t newest_ns;
+    uint64_t last_out_ns;
+    uint64_t emitted;
+    uint64_t late;
+    size_t starved;
+    size_t done;
+    bool built;
+
+    bool less(uint32_t a, uint32_t b) const {
+        return head_ns[a] < head_ns[b] || (head_ns[a] == head_ns[b] && a < b);
+    }
+    void refill(uint32_t i);
+    void buildTree();
+    void replay(uint32_t i);
+    bool reviveStarved();
+    size_t mergeRun(MergedBatch& out, size_t max_samples, uint64_t watermark, bool gate);
+    size_t merge(MergedBatch& out, size_t max_samples, uint64_t watermark, bool gate);
+
+public:
+    explicit StreamMerger(uint64_t window_ns = 0);
+
+    // Sources are not owned. Sources added after the first next() call
+    // trigger a rebuild of the tree.
+    void addSource(MergeSource* source, uint32_t id);
+
+    // Append up to max_samples merged samples to out. now_ns (same clock as
+    // the samples, 0 to ignore) lets the watermark advance while every live
+    // source is idle. Returns the number of samples appended.
+    size_t next(MergedBatch& out, size_t max_samples, uint64_t now_ns = 0);
+    // Emit everything buffered regardless of the watermark (end of stream)
+    size_t drain(MergedBatch& out, size_t max_samples);
+
+    bool finished() const { return built && done == inputs.size(); }
+    size_t sourceCount() const { return inputs.size(); }
+    uint64_t samplesEmitted() const { return emitted; }
+    uint64_t lateSamples() const { return late; }
+    uint64_t reorderWindow() const { return window_ns; }
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_MERGE_H
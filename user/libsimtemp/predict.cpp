@@ -0,0 +1,246 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Sliding-window least-squares time-to-threshold predictor.
+ */
+
+#include "predict.h"
+
+#include <cmath>
+
+namespace simtemp {
+
+// Predictions further out than this are treated as "no crossing"
+static const double MAX_ETA_S = 1e6;
+
+static double det3(double a, double b, double c,
+                   double d, double e, double f,
+                   double g, double h, double i) {
+    return a * (e * i - f * h) - b * (d * i - f * g) + c * (d * h - e * g);
+}
+
+ThresholdPredictor::ThresholdPredictor(const PredictorConfig& config)
+    : config(config), xs(config.window), ys(config.window) {
+    reset();
+}
+
+void ThresholdPredictor::reset() {
+    head = 0;
+    count = 0;
+    since_rebase = 0;
+    origin_ns = 0;
+    sx = sxx = sxxx = sxxxx = 0.0;
+    sy = sxy = sxxy = syy = 0.0;
+    armed = true;
+    latest = Prediction();
+}
+
+void ThresholdPredictor::setThreshold(int32_t threshold_mC) {
+    config.threshold_mC = threshold_mC;
+    armed = true;
+}
+
+void ThresholdPredictor::push(double x, double y) {
+    if (count == config.window) {
+        double ox = xs[head];
+        double oy = ys[head];
+        double ox2 = ox * ox;
+        sx -= ox;
+        sxx -= ox2;
+        sxxx -= ox2 * ox;
+        sxxxx -= ox2 * ox2;
+        sy -= oy;
+        sxy -= ox * oy;
+        sxxy -= ox2 * oy;
+        syy -= oy * oy;
+    } else {
+        count++;
+    }
+
+    double x2 = x * x;
+    sx += x;
+    sxx += x2;
+    sxxx += x2 * x;
+    sxxxx += x2 * x2;
+    sy += y;
+    sxy += x * y;
+    sxxy += x2 * y;
+    syy += y * y;
+
+    xs[head] = x;
+    ys[head] = y;
+    head = (head + 1) % config.window;
+    since_rebase++;
+}
+
+void ThresholdPredictor::rebase(uint64_t new_origin_ns) {
+    double delta = static_cast<double>(static_cast<int64_t>(new_origin_ns - origin_ns)) * 1e-9;
+    origin_ns = new_origin_ns;
+
+    sx = sxx = sxxx = sxxxx = 0.0;
+    sy = sxy = sxxy = syy = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        double x = xs[i] - delta;
+        double y = ys[i];
+        double x2 = x * x;
+        xs[i] = x;
+        sx += x;
+        sxx += x2;
+        sxxx += x2 * x;
+        sxxxx += x2 * x2;
+        sy += y;
+        sxy += x * y;
+        sxxy += x2 * y;
+        syy += y * y;
+    }
+    since_rebase = 0;
+}
+
+void ThresholdPredictor::predict(double x_now, uint64_t now_ns) {
+    Prediction p = Prediction();
+    double n = static_cast<double>(count);
+
+    if (count >= config.min_samples) {
+        double a = 0.0;
+        double b = 0.0;
+        double c = 0.0;
+        bool fitted = false;
+
+        if (config.quadratic) {
+            double det = det3(n, sx, sxx, sx, sxx, sxxx, sxx, sxxx, sxxxx);
+            if (std::fabs(det) > 1e-12) {
+                a = det3(sy, sx, sxx, sxy, sxx, sxxx, sxxy, sxxx, sxxxx) / det;
+                b = det3(n, sy, sxx, sx, sxy, sxxx, sxx, sxxy, sxxxx) / det;
+                c = det3(n, sx, sy, sx, sxx, sxy, sxx, sxxx, sxxy) / det;
+                fitted = true;
+            }
+        }
+        if (!fitted) {
+            double den = n * sxx - sx * sx;
+            if (den > 1e-12) {
+                b = (n * sxy - sx * sy) / den;
+                a = (sy - b * sx) / n;
+                c = 0.0;
+                fitted = true;
+            }
+        }
+
+        if (fitted) {
+            double sst = syy - sy * sy / n;
+            double sse = syy - a * sy - b * sxy - c * sxxy;
+            double r2 = sst > 0.0 ? 1.0 - sse / sst : 0.0;
+            r2 = r2 < 0.0 ? 0.0 : (r2 > 1.0 ? 1.0 : r2);
+
+            p.valid = true;
+            p.fitted_mC = a + (b + c * x_now) * x_now;
+            p.slope_mC_per_s = b + 2.0 * c * x_now;
+            p.accel_mC_per_s2 = 2.0 * c;
+
+            // Solve fitted + slope*u + c*u^2 = threshold for the first u > 0
+            double diff = config.threshold_mC - p.fitted_mC;
+            double s = p.slope_mC_per_s;
+            double u = -1.0;
+            if (c != 0.0 && std::fabs(c) > 1e-9 * (std::fabs(s) + 1.0)) {
+                double disc = s * s + 4.0 * c * diff;
+                if (disc >= 0.0) {
+                    double q = -0.5 * (s + std::copysign(std::sqrt(disc), s));
+                    double r1 = q / c;
+                    double r2_root = q != 0.0 ? -diff / q : -1.0;
+                    if (r1 > 0.0 && (r2_root <= 0.0 || r1 < r2_root)) {
+                        u = r1;
+                    } else if (r2_root > 0.0) {
+                        u = r2_root;
+                    }
+                }
+            } else if (s != 0.0) {
+                u = diff / s;
+            }
+
+            if (u > 0.0 && u < MAX_ETA_S) {
+                size_t oldest = count == config.window ? head : 0;
+                size_t newest = (head + config.window - 1) % config.window;
+                double span = xs[newest] - xs[oldest];
+                double reach = span >= u ? 1.0 : span / u;
+
+                p.crossing = true;
+                p.eta_ns = static_cast<uint64_t>(u * 1e9);
+                p.crossing_ns = now_ns + p.eta_ns;
+                p.confidence = r2 * (n / config.window) * reach;
+            }
+        }
+    }
+
+    bool in_horizon = p.crossing && p.eta_ns <= config.horizon_ns &&
+                      p.confidence >= config.min_confidence;
+    if (in_horizon && armed) {
+        p.pre_alert = true;
+        armed = false;
+    } else if (!in_horizon) {
+        armed = true;
+    }
+    latest = p;
+}
+
+const Prediction& ThresholdPredictor::update(uint64_t timestamp_ns, int32_t temp_mC) {
+    if (count == 0) {
+        origin_ns = timestamp_ns;
+    }
+
+    double x = static_cast<double>(static_cast<int64_t>(timestamp_ns - origin_ns)) * 1e-9;
+    push(x, temp_mC);
+    if (since_rebase >= config.window) {
+        uint64_t old_origin = origin_ns;
+        rebase(timestamp_ns);
+        x -= static_cast<double>(static_cast<int64_t>(timestamp_ns - old_origin)) * 1e-9;
+    }
+    predict(x, timestamp_ns);
+    return latest;
+}
+
+size_t ThresholdPredictor::updateBatch(const uint64_t* timestamp_ns, const int32_t* temp_mC,
+                                       size_t n, uint32_t* indices) {
+    if (n == 0) {
+        return 0;
+    }
+    if (count == 0) {
+        origin_ns = timestamp_ns[0];
+    }
+    if (scratch_x.size() < n) {
+        scratch_x.resize(n);
+        scratch_y.resize(n);
+    }
+    double* bx = scratch_x.data();
+    double* by = scratch_y.data();
+
+    // Column conversions: independent per element, so they vectorize
+    uint64_t origin = origin_ns;
+    for (size_t i = 0; i < n; ++i) {
+        bx[i] = static_cast<double>(static_cast<int64_t>(timestamp_ns[i] - origin)) * 1e-9;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        by[i] = temp_mC[i];
+    }
+
+    size_t found = 0;
+    for (size_t i = 0; i < n; ++i) {
+        push(bx[i], by[i]);
+        if (since_rebase >= config.window) {
+            uint64_t old_origin = origin_ns;
+            rebase(timestamp_ns[i]);
+            double delta = static_cast<double>(static_cast<int64_t>(origin_ns - old_origin)) * 1e-9;
+            for (size_t j = i; j < n; ++j) {
+                bx[j] -= delta;
+            }
+        }
+        predict(bx[i], timestamp_ns[i]);
+        if (latest.pre_alert) {
+            if (indices) {
+                indices[found] = static_cast<uint32_t>(i);
+            }
+            found++;
+        }
+    }
+    return found;
+}
+
+} // namespace simtemp
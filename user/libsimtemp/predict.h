@@ -0,0 +1,102 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Time-to-threshold prediction. A least-squares fit over a sliding window of
+ * recent samples (linear, optionally with a second-order term) is
+ * extrapolated to the time the temperature reaches the threshold. The fit
+ * is maintained from running sums, so each sample costs O(1) regardless of
+ * the window length; the sums are rebuilt from the window once per window
+ * length to bound rounding drift.
+ */
+
+#ifndef SIMTEMP_PREDICT_H
+#define SIMTEMP_PREDICT_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+struct PredictorConfig {
+    size_t window;              // samples in the regression window
+    int32_t threshold_mC;
+    uint64_t horizon_ns;        // pre-alert when the predicted crossing is this close
+    bool quadratic;             // fit a second-order term as well
+    size_t min_samples;         // no prediction before this many samples
+    double min_confidence;      // no pre-alert below this confidence
+
+    PredictorConfig(int32_t threshold_mC = 45000, uint64_t horizon_ns = 5000000000ULL,
+                    size_t window = 50, bool quadratic = false)
+        : window(window < 3 ? 3 : window), threshold_mC(threshold_mC),
+          horizon_ns(horizon_ns), quadratic(quadratic), min_samples(window < 3 ? 3 : window / 2),
+          min_confidence(0.5) {}
+};
+
+struct Prediction {
+    bool valid;                 // enough samples for a fit
+    double slope_mC_per_s;      // trend at the newest sample
+    double accel_mC_per_s2;     // second-order term (0 for a linear fit)
+    double fitted_mC;           // fitted temperature at the newest sample
+    bool crossing;              // the fit reaches the threshold in the future
+    uint64_t eta_ns;            // time until the crossing
+    uint64_t crossing_ns;       // predicted timestamp of the crossing
+    double confidence;          // 0..1, see ThresholdPredictor
+    bool pre_alert;             // ETA fell below the horizon at this sample
+};
+
+/*
+ * Confidence is the R^2 of the fit, discounted by the window fill and by
+ * how far the prediction extrapolates beyond the time span the window
+ * covers. A pre-alert fires once when a confident ETA drops below the
+ * horizon and re-arms when the prediction moves out of the horizon again.
+ */
+class ThresholdPredictor {
+private:
+    PredictorConfig config;
+
+    // Window ring; x is seconds relative to origin_ns
+    std::vector<double> xs;
+    std::vector<double> ys;
+    size_t head;
+    size_t count;
+    size_t since_rebase;
+    uint64_t origin_ns;
+
+    // Running sums over the window
+    double sx, sxx, sxxx, sxxxx;
+    double sy, sxy, sxxy, syy;
+
+    std::vector<double> scratch_x;
+    std::vector<double> scratch_y;
+
+    bool armed;
+    Prediction latest;
+
+    void push(double x, double y);
+    void rebase(uint64_t new_origin_ns);
+    void predict(double x_now, uint64_t now_ns);
+
+public:
+    explicit ThresholdPredictor(const PredictorConfig& config = PredictorConfig());
+
+    const Prediction& update(uint64_t timestamp_ns, int32_t temp_mC);
+
+    /*
+     * Feed n samples. Timestamp and temperature conversion run as separate
+     * loops over the columns; the per-sample work is the O(1) window update.
+     * Indices of samples that raised a pre-alert are written to indices
+     * (which must hold n entries, or be NULL); their number is returned.
+     */
+    size_t updateBatch(const uint64_t* timestamp_ns, const int32_t* temp_mC, size_t n,
+                       uint32_t* indices = NULL);
+
+    const Prediction& last() const { return latest; }
+    const PredictorConfig& configuration() const { return config; }
+    void setThreshold(int32_t threshold_mC);
+    void reset();
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_PREDICT_H
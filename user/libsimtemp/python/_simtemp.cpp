@@ -0,0 +1,649 @@
+/*
+ * NXP Simulated Temperature Sensor - Python Binding
+ *
+ * CPython extension (C API only) over libsimtemp. Sample batches and recording
+ * chunks are exported through the buffer protocol, so their timestamp,
+ * temperature and flag columns appear in Python as memoryviews over the
+ * library's own memory without any per-sample decoding.
+ *
+ *   batch = _simtemp.read_batch(fd, 256, 1.0)
+ *   temps = batch.temps                 # memoryview, format 'i'
+ *   _simtemp.stats(temps, batch.flags)  # C++ stats kernel
+ *
+ *   rec = _simtemp.Recording("capture.rec")
+ *   ts, temps, flags = rec.chunk(0)     # memoryviews into the mapping
+ *                                       # (ValueError if it fails its CRC)
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "simtemp.h"
+#include "stats.h"
+#include "recording.h"
+
+#include <new>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+
+using simtemp::SampleBatch;
+
+/* =============================================================================
+ * Column: read-only 1-D buffer exporter over memory owned by another object
+ * ============================================================================= */
+
+typedef struct {
+    PyObject_HEAD
+    PyObject* owner;        // keeps the underlying memory alive
+    void* buf;
+    Py_ssize_t count;
+    Py_ssize_t itemsize;
+    const char* format;
+} ColumnObject;
+
+static PyTypeObject ColumnType = { PyVarObject_HEAD_INIT(NULL, 0) };
+
+static void Column_dealloc(ColumnObject* self) {
+    Py_XDECREF(self->owner);
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+static int Column_getbuffer(PyObject* obj, Py_buffer* view, int flags) {
+    ColumnObject* self = reinterpret_cast<ColumnObject*>(obj);
+
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "column is read-only");
+        view->obj = NULL;
+        return -1;
+    }
+
+    view->obj = obj;
+    Py_INCREF(obj);
+    view->buf = self->buf;
+    view->len = self->count * self->itemsize;
+    view->readonly = 1;
+    view->itemsize = self->itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(self->format) : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &self->count : NULL;
+    view->strides = (flags & PyBUF_STRIDES) ? &self->itemsize : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+static PyBufferProcs Column_as_buffer = {
+    Column_getbuffer,
+    NULL,
+};
+
+// Return a memoryview over count items at buf, owned by owner
+static PyObject* makeColumnView(PyObject* owner, const void* buf, size_t count,
+                                Py_ssize_t itemsize, const char* format) {
+    ColumnObject* col = PyObject_New(ColumnObject, &ColumnType);
+    if (!col) {
+        return NULL;
+    }
+    Py_INCREF(owner);
+    col->owner = owner;
+    col->buf = const_cast<void*>(buf);
+    col->count = static_cast<Py_ssize_t>(count);
+    col->itemsize = itemsize;
+    col->format = format;
+
+    PyObject* view = PyMemoryView_FromObject(reinterpret_cast<PyObject*>(col));
+    Py_DECREF(col);
+    return view;
+}
+
+/* =============================================================================
+ * Buffer argument helpers
+ * ============================================================================= */
+
+// True if a struct-module format is one of codes, in host byte order
+static bool nativeFormat(const char* format, const char* codes) {
+    if (!format) {
+        return false;   // no format means unsigned bytes
+    }
+    if (*format == '@' || *format == '=' || (PY_LITTLE_ENDIAN && *format == '<') ||
+        (!PY_LITTLE_ENDIAN && (*format == '>' || *format == '!'))) {
+        format++;
+    }
+    return format[0] != '\0' && format[1] == '\0' && strchr(codes, format[0]) != NULL;
+}
+
+// Acquire a contiguous buffer of 32-bit integers; codes lists the accepted
+// item formats ("il" signed, "IL" unsigned)
+static bool getInt32Buffer(PyObject* obj, Py_buffer* view, const char* name,
+                           const char* codes = "il") {
+    if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+        return false;
+    }
+    if (view->itemsize != 4 || (view->len % 4) != 0 || !nativeFormat(view->format, codes)) {
+        PyErr_Format(PyExc_TypeError, "%s must be a buffer of %s 32-bit integers ('%c', got '%s')",
+                     name, codes[0] == 'i' ? "signed" : "unsigned", codes[0],
+                     view->format ? view->format : "B");
+        PyBuffer_Release(view);
+        return false;
+    }
+    return true;
+}
+
+static PyObject* statsToDict(const simtemp::BatchStats& s) {
+    return Py_BuildValue("{s:n,s:i,s:i,s:d,s:d,s:n}",
+                         "count", static_cast<Py_ssize_t>(s.count),
+                         "min_mC", s.min_mC,
+                         "max_mC", s.max_mC,
+                         "mean_mC", s.mean_mC,
+                         "stddev_mC", s.stddev_mC,
+                         "alerts", static_cast<Py_ssize_t>(s.alerts));
+}
+
+/* =============================================================================
+ * Batch
+ * ============================================================================= */
+
+typedef struct {
+    PyObject_HEAD
+    SampleBatch* batch;
+} BatchObject;
+
+static PyTypeObject BatchType = { PyVarObject_HEAD_INIT(NULL, 0) };
+
+static PyObject* Batch_new(PyTypeObject* type, PyObject*, PyObject*) {
+    BatchObject* self = reinterpret_cast<BatchObject*>(type->tp_alloc(type, 0));
+    if (!self) {
+        return NULL;
+    }
+    self->batch = new (std::nothrow) SampleBatch();
+    if (!self->batch) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    return reinterpret_cast<PyObject*>(self);
+}
+
+static void Batch_dealloc(BatchObject* self) {
+    delete self->batch;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+static Py_ssize_t Batch_len(PyObject* obj) {
+    return static_cast<Py_ssize_t>(reinterpret_cast<BatchObject*>(obj)->batch->size());
+}
+
+static PyObject* Batch_timestamps(PyObject* obj, void*) {
+    SampleBatch* b = reinterpret_cast<BatchObject*>(obj)->batch;
+    return makeColumnView(obj, b->timestamp_ns.data(), b->size(), 8, "Q");
+}
+
+static PyObject* Batch_temps(PyObject* obj, void*) {
+    SampleBatch* b = reinterpret_cast<BatchObject*>(obj)->batch;
+    return makeColumnView(obj, b->temp_mC.data(), b->size(), 4, "i");
+}
+
+static PyObject* Batch_flags(PyObject* obj, void*) {
+    SampleBatch* b = reinterpret_cast<BatchObject*>(obj)->batch;
+    return makeColumnView(obj, b->flags.data(), b->size(), 4, "I");
+}
+
+static PyObject* Batch_stats(PyObject* obj, PyObject*) {
+    SampleBatch* b = reinterpret_cast<BatchObject*>(obj)->batch;
+    return statsToDict(simtemp::computeStats(b->temp_mC.data(), b->flags.data(), b->size()));
+}
+
+static PyGetSetDef Batch_getset[] = {
+    {const_cast<char*>("timestamps"), Batch_timestamps, NULL,
+     const_cast<char*>("timestamp_ns column (memoryview, 'Q')"), NULL},
+    {const_cast<char*>("temps"), Batch_temps, NULL,
+     const_cast<char*>("temp_mC column (memoryview, 'i')"), NULL},
+    {const_cast<char*>("flags"), Batch_flags, NULL,
+     const_cast<char*>("flags column (memoryview, 'I')"), NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyMethodDef Batch_methods[] = {
+    {"stats", Batch_stats, METH_NOARGS, "Return min/max/mean/stddev/alerts of the batch"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PySequenceMethods Batch_as_sequence;
+
+/* =============================================================================
+ * Recording (memory-mapped reader)
+ * ============================================================================= */
+
+typedef struct {
+    PyObject_HEAD
+    simtemp::RecordingReader* reader;
+} RecordingObject;
+
+static PyTypeObject RecordingType = { PyVarObject_HEAD_INIT(NULL, 0) };
+
+static int Recording_init(PyObject* obj, PyObject* args, PyObject* kwds) {
+    RecordingObject* self = reinterpret_cast<RecordingObject*>(obj);
+    static const char* kwlist[] = {"path", NULL};
+    PyObject* path_obj;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&", const_cast<char**>(kwlist),
+                                     PyUnicode_FSConverter, &path_obj)) {
+        return -1;
+    }
+
+    if (self->reader) {
+        Py_DECREF(path_obj);
+        PyErr_SetString(PyExc_RuntimeError, "recording is already open");
+        return -1;
+    }
+    self->reader = new (std::nothrow) simtemp::RecordingReader();
+    if (!self->reader) {
+        Py_DECREF(path_obj);
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    bool ok;
+    Py_BEGIN_ALLOW_THREADS
+    ok = self->reader->open(PyBytes_AS_STRING(path_obj));
+    Py_END_ALLOW_THREADS
+    if (!ok) {
+        PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path_obj);
+        Py_DECREF(path_obj);
+        return -1;
+    }
+    Py_DECREF(path_obj);
+    return 0;
+}
+
+static void Recording_dealloc(RecordingObject* self) {
+    delete self->reader;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+static bool Recording_check(RecordingObject* self) {
+    if (!self->reader) {
+        PyErr_SetString(PyExc_ValueError, "recording is not open");
+        return false;
+    }
+    return true;
+}
+
+static Py_ssize_t Recording_len(PyObject* obj) {
+    RecordingObject* self = reinterpret_cast<RecordingObject*>(obj);
+    if (!Recording_check(self)) {
+        return -1;
+    }
+    return static_cast<Py_ssize_t>(self->reader->chunkCount());
+}
+
+// Chunk index argument, negative from the end; false with IndexError set
+static bool Recording_index(RecordingObject* self, PyObject* args, Py_ssize_t& index) {
+    if (!PyArg_ParseTuple(args, "n", &index) || !Recording_check(self)) {
+        return false;
+    }
+    if (index < 0) {
+        index += static_cast<Py_ssize_t>(self->reader->chunkCount());
+    }
+    if (index < 0 || static_cast<size_t>(index) >= self->reader->chunkCount()) {
+        PyErr_SetString(PyExc_IndexError, "chunk index out of range");
+        return false;
+    }
+    return true;
+}
+
+static PyObject* Recording_intact(PyObject* obj, PyObject* args) {
+    RecordingObject* self = reinterpret_cast<RecordingObject*>(obj);
+    Py_ssize_t index;
+
+    if (!Recording_index(self, args, index)) {
+        return NULL;
+    }
+    return PyBool_FromLong(self->reader->chunkIntact(index));
+}
+
+static PyObject* Recording_chunk(PyObject* obj, PyObject* args) {
+    RecordingObject* self = reinterpret_cast<RecordingObject*>(obj);
+    Py_ssize_t index;
+
+    if (!Recording_index(self, args, index)) {
+        return NULL;
+    }
+    // Damaged samples are never handed out as data
+    if (!self->reader->chunkIntact(index)) {
+        PyErr_Format(PyExc_ValueError, "chunk %zd fails its CRC32C check", index);
+        return NULL;
+    }
+
+    const simtemp::RecordingChunk& c = self->reader->chunk(index);
+    PyObject* ts = makeColumnView(obj, c.timestamp_ns, c.count, 8, "Q");
+    PyObject* temps = makeColumnView(obj, c.temp_mC, c.count, 4, "i");
+    PyObject* flags = makeColumnView(obj, c.flags, c.count, 4, "I");
+    if (!ts || !temps || !flags) {
+        Py_XDECREF(ts);
+        Py_XDECREF(temps);
+        Py_XDECREF(flags);
+        return NULL;
+    }
+    return Py_BuildValue("(NNN)", ts, temps, flags);
+}
+
+static PyObject* Recording_sample_count(PyObject* obj, void*) {
+    RecordingObject* self = reinterpret_cast<RecordingObject*>(obj);
+    if (!Recording_check(self)) {
+        return NULL;
+    }
+    return PyLong_FromSize_t(self->reader->sampleCount());
+}
+
+static PyObject* Recording_trailing_bytes(PyObject* obj, void*) {
+    RecordingObject* self = reinterpret_cast<RecordingObject*>(obj);
+    if (!Recording_check(self)) {
+        return NULL;
+    }
+    return PyLong_FromSize_t(self->reader->trailingBytes());
+}
+
+static PyGetSetDef Recording_getset[] = {
+    {const_cast<char*>("sample_count"), Recording_sample_count, NULL,
+     const_cast<char*>("Total samples in complete chunks"), NULL},
+    {const_cast<char*>("trailing_bytes"), Recording_trailing_bytes, NULL,
+     const_cast<char*>("Bytes after the last complete chunk"), NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyMethodDef Recording_methods[] = {
+    {"chunk", Recording_chunk, METH_VARARGS,
+     "chunk(i) -> (timestamps, temps, flags) memoryviews into the mapped file;"
+     " ValueError if the chunk fails its CRC"},
+    {"intact", Recording_intact, METH_VARARGS,
+     "intact(i) -> whether chunk i passes its CRC (always True without checksums)"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PySequenceMethods Recording_as_sequence;
+
+/* =============================================================================
+ * RecordingWriter
+ * ============================================================================= */
+
+typedef struct {
+    PyObject_HEAD
+    simtemp::RecordingWriter* writer;
+} RecordingWriterObject;
+
+static PyTypeObject RecordingWriterType = { PyVarObject_HEAD_INIT(NULL, 0) };
+
+static int RecordingWriter_init(PyObject* obj, PyObject* args, PyObject* kwds) {
+    RecordingWriterObject* self = reinterpret_cast<RecordingWriterObject*>(obj);
+    static const char* kwlist[] = {"path", "chunk_samples", NULL};
+    PyObject* path_obj;
+    unsigned int chunk_samples = simtemp::DEFAULT_CHUNK_SAMPLES;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|I", const_cast<char**>(kwlist),
+                                     PyUnicode_FSConverter, &path_obj, &chunk_samples)) {
+        return -1;
+    }
+
+    if (self->writer) {
+        Py_DECREF(path_obj);
+        PyErr_SetString(PyExc_RuntimeError, "writer is already open");
+        return -1;
+    }
+    self->writer = new (std::nothrow) simtemp::RecordingWriter(chunk_samples);
+    if (!self->writer) {
+        Py_DECREF(path_obj);
+        PyErr_NoMemory();
+        return -1;
+    }
+    if (!self->writer->open(PyBytes_AS_STRING(path_obj))) {
+        PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path_obj);
+        Py_DECREF(path_obj);
+        return -1;
+    }
+    Py_DECREF(path_obj);
+    return 0;
+}
+
+static void RecordingWriter_dealloc(RecordingWriterObject* self) {
+    delete self->writer;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+static PyObject* RecordingWriter_append(PyObject* obj, PyObject* args) {
+    RecordingWriterObject* self = reinterpret_cast<RecordingWriterObject*>(obj);
+    PyObject* batch_obj;
+
+    if (!PyArg_ParseTuple(args, "O!", &BatchType, &batch_obj)) {
+        return NULL;
+    }
+    if (!self->writer || !self->writer->isOpen()) {
+        PyErr_SetString(PyExc_ValueError, "writer is closed");
+        return NULL;
+    }
+
+    bool ok;
+    SampleBatch* b = reinterpret_cast<BatchObject*>(batch_obj)->batch;
+    Py_BEGIN_ALLOW_THREADS
+    ok = self->writer->append(*b);
+    Py_END_ALLOW_THREADS
+    if (!ok) {
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject* RecordingWriter_close(PyObject* obj, PyObject*) {
+    RecordingWriterObject* self = reinterpret_cast<RecordingWriterObject*>(obj);
+    if (self->writer) {
+        self->writer->close();
+    }
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef RecordingWriter_methods[] = {
+    {"append", RecordingWriter_append, METH_VARARGS, "Append a Batch to the recording"},
+    {"close", RecordingWriter_close, METH_NOARGS, "Flush buffered samples and close the file"},
+    {NULL, NULL, 0, NULL}
+};
+
+/* =============================================================================
+ * Module functions
+ * ============================================================================= */
+
+static PyObject* mod_read_batch(PyObject*, PyObject* args, PyObject* kwds) {
+    static const char* kwlist[] = {"fd", "max_samples", "timeout", NULL};
+    int fd;
+    Py_ssize_t max_samples = 64;
+    double timeout = -1.0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "i|nd", const_cast<char**>(kwlist),
+                                     &fd, &max_samples, &timeout)) {
+        return NULL;
+    }
+    if (max_samples < 0) {
+        PyErr_SetString(PyExc_ValueError, "max_samples must be non-negative");
+        return NULL;
+    }
+
+    PyObject* obj = Batch_new(&BatchType, NULL, NULL);
+    if (!obj) {
+        return NULL;
+    }
+
+    SampleBatch* b = reinterpret_cast<BatchObject*>(obj)->batch;
+    int timeout_ms = timeout > 0.0 ? static_cast<int>(timeout * 1000) : -1;
+    ssize_t ret;
+    Py_BEGIN_ALLOW_THREADS
+    ret = simtemp::readBatch(fd, *b, static_cast<size_t>(max_samples), timeout_ms);
+    Py_END_ALLOW_THREADS
+    if (ret < 0) {
+        Py_DECREF(obj);
+        return PyErr_SetFromErrno(PyExc_OSError);
+    }
+    return obj;
+}
+
+static PyObject* mod_stats(PyObject*, PyObject* args) {
+    PyObject* temps_obj;
+    PyObject* flags_obj = Py_None;
+    Py_buffer temps, flags;
+
+    if (!PyArg_ParseTuple(args, "O|O", &temps_obj, &flags_obj)) {
+        return NULL;
+    }
+    if (!getInt32Buffer(temps_obj, &temps, "temps")) {
+        return NULL;
+    }
+
+    const uint32_t* flags_ptr = NULL;
+    if (flags_obj != Py_None) {
+        if (!getInt32Buffer(flags_obj, &flags, "flags", "IL")) {
+            PyBuffer_Release(&temps);
+            return NULL;
+        }
+        if (flags.len != temps.len) {
+            PyErr_SetString(PyExc_ValueError, "temps and flags differ in length");
+            PyBuffer_Release(&flags);
+            PyBuffer_Release(&temps);
+            return NULL;
+        }
+        flags_ptr = static_cast<const uint32_t*>(flags.buf);
+    }
+
+    simtemp::BatchStats s;
+    Py_BEGIN_ALLOW_THREADS
+    s = simtemp::computeStats(static_cast<const int32_t*>(temps.buf), flags_ptr, temps.len / 4);
+    Py_END_ALLOW_THREADS
+
+    if (flags_ptr) {
+        PyBuffer_Release(&flags);
+    }
+    PyBuffer_Release(&temps);
+    return statsToDict(s);
+}
+
+static PyObject* mod_crossings(PyObject*, PyObject* args) {
+    PyObject* temps_obj;
+    int threshold_mC;
+    int last_mC;
+    Py_buffer temps;
+
+    if (!PyArg_ParseTuple(args, "Oii", &temps_obj, &threshold_mC, &last_mC)) {
+        return NULL;
+    }
+    if (!getInt32Buffer(temps_obj, &temps, "temps")) {
+        return NULL;
+    }
+
+    size_t n = temps.len / 4;
+    std::vector<uint32_t> indices(n ? n : 1);
+    int32_t last = last_mC;
+    size_t found;
+    Py_BEGIN_ALLOW_THREADS
+    found = simtemp::detectCrossings(static_cast<const int32_t*>(temps.buf), n,
+                                     threshold_mC, &last, indices.data());
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&temps);
+
+    PyObject* list = PyList_New(static_cast<Py_ssize_t>(found));
+    if (!list) {
+        return NULL;
+    }
+    for (size_t i = 0; i < found; ++i) {
+        PyObject* index = PyLong_FromUnsignedLong(indices[i]);
+        if (!index) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, index);
+    }
+    return Py_BuildValue("(Ni)", list, last);
+}
+
+static PyMethodDef module_methods[] = {
+    {"read_batch", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(mod_read_batch)),
+     METH_VARARGS | METH_KEYWORDS,
+     "read_batch(fd, max_samples=64, timeout=-1.0) -> Batch\n\n"
+     "Wait up to timeout seconds for the first sample (no wait if <= 0), then\n"
+     "drain up to max_samples ready samples from a nonblocking device fd."},
+    {"stats", mod_stats, METH_VARARGS,
+     "stats(temps[, flags]) -> dict of count/min_mC/max_mC/mean_mC/stddev_mC/alerts\n\n"
+     "temps holds int32 ('i') and flags uint32 ('I') items, like the Batch columns."},
+    {"crossings", mod_crossings, METH_VARARGS,
+     "crossings(temps, threshold_mC, last_mC) -> (indices, last_mC)"},
+    {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef simtemp_module = {
+    PyModuleDef_HEAD_INIT,
+    "_simtemp",
+    "Native libsimtemp binding with zero-copy column access",
+    -1,
+    module_methods,
+    NULL, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit__simtemp(void) {
+    ColumnType.tp_name = "_simtemp.Column";
+    ColumnType.tp_basicsize = sizeof(ColumnObject);
+    ColumnType.tp_dealloc = reinterpret_cast<destructor>(Column_dealloc);
+    ColumnType.tp_as_buffer = &Column_as_buffer;
+    ColumnType.tp_flags = Py_TPFLAGS_DEFAULT;
+    ColumnType.tp_doc = "Read-only column buffer";
+
+    Batch_as_sequence.sq_length = Batch_len;
+    BatchType.tp_name = "_simtemp.Batch";
+    BatchType.tp_basicsize = sizeof(BatchObject);
+    BatchType.tp_dealloc = reinterpret_cast<destructor>(Batch_dealloc);
+    BatchType.tp_as_sequence = &Batch_as_sequence;
+    BatchType.tp_flags = Py_TPFLAGS_DEFAULT;
+    BatchType.tp_doc = "Column-oriented batch of samples";
+    BatchType.tp_getset = Batch_getset;
+    BatchType.tp_methods = Batch_methods;
+    BatchType.tp_new = Batch_new;
+
+    Recording_as_sequence.sq_length = Recording_len;
+    RecordingType.tp_name = "_simtemp.Recording";
+    RecordingType.tp_basicsize = sizeof(RecordingObject);
+    RecordingType.tp_dealloc = reinterpret_cast<destructor>(Recording_dealloc);
+    RecordingType.tp_as_sequence = &Recording_as_sequence;
+    RecordingType.tp_flags = Py_TPFLAGS_DEFAULT;
+    RecordingType.tp_doc = "Recording(path): memory-mapped recording file";
+    RecordingType.tp_getset = Recording_getset;
+    RecordingType.tp_methods = Recording_methods;
+    RecordingType.tp_init = Recording_init;
+    RecordingType.tp_new = PyType_GenericNew;
+
+    RecordingWriterType.tp_name = "_simtemp.RecordingWriter";
+    RecordingWriterType.tp_basicsize = sizeof(RecordingWriterObject);
+    RecordingWriterType.tp_dealloc = reinterpret_cast<destructor>(RecordingWriter_dealloc);
+    RecordingWriterType.tp_flags = Py_TPFLAGS_DEFAULT;
+    RecordingWriterType.tp_doc = "RecordingWriter(path, chunk_samples=4096)";
+    RecordingWriterType.tp_methods = RecordingWriter_methods;
+    RecordingWriterType.tp_init = RecordingWriter_init;
+    RecordingWriterType.tp_new = PyType_GenericNew;
+
+    if (PyType_Ready(&ColumnType) < 0 || PyType_Ready(&BatchType) < 0 ||
+        PyType_Ready(&RecordingType) < 0 || PyType_Ready(&RecordingWriterType) < 0) {
+        return NULL;
+    }
+
+    PyObject* m = PyModule_Create(&simtemp_module);
+    if (!m) {
+        return NULL;
+    }
+
+    Py_INCREF(&BatchType);
+    Py_INCREF(&RecordingType);
+    Py_INCREF(&RecordingWriterType);
+    if (PyModule_AddObject(m, "Batch", reinterpret_cast<PyObject*>(&BatchType)) < 0 ||
+        PyModule_AddObject(m, "Recording", reinterpret_cast<PyObject*>(&RecordingType)) < 0 ||
+        PyModule_AddObject(m, "RecordingWriter", reinterpret_cast<PyObject*>(&RecordingWriterType)) < 0 ||
+        PyModule_AddIntConstant(m, "FLAG_NEW_SAMPLE", simtemp::FLAG_NEW_SAMPLE) < 0 ||
+        PyModule_AddIntConstant(m, "FLAG_THRESHOLD_CROSSED", simtemp::FLAG_THRESHOLD_CROSSED) < 0) {
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -0,0 +1,334 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * epoll reactor and asynchronous device.
+ */
+
+#include "reactor.h"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+
+namespace simtemp {
+
+// Samples requested per readBatch() call while draining an fd
+static const size_t DRAIN_SAMPLES = 1024;
+
+// epoll_wait() batch size
+static const int MAX_EVENTS = 64;
+
+void WaiterQueue::push(Waiter* w) {
+    w->next = NULL;
+    if (tail) {
+        tail->next = w;
+    } else {
+        head = w;
+    }
+    tail = w;
+}
+
+Waiter* WaiterQueue::pop() {
+    Waiter* w = head;
+    if (w) {
+        head = w->next;
+        if (!head) {
+            tail = NULL;
+        }
+        w->next = NULL;
+    }
+    return w;
+}
+
+bool WaiterQueue::remove(Waiter* w) {
+    Waiter* prev = NULL;
+    for (Waiter* cur = head; cur; prev = cur, cur = cur->next) {
+        if (cur != w) {
+            continue;
+        }
+        if (prev) {
+            prev->next = cur->next;
+        } else {
+            head = cur->next;
+        }
+        if (tail == cur) {
+            tail = prev;
+        }
+        cur->next = NULL;
+        return true;
+    }
+    return false;
+}
+
+Reactor::Reactor() : epoll_fd(-1), registered(0), stopping(false) {}
+
+Reactor::~Reactor() {
+    close();
+}
+
+bool Reactor::open() {
+    if (epoll_fd >= 0) {
+        return true;
+    }
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    return epoll_fd >= 0;
+}
+
+void Reactor::close() {
+    if (epoll_fd >= 0) {
+        ::close(epoll_fd);
+        epoll_fd = -1;
+    }
+    registered = 0;
+}
+
+bool Reactor::add(int fd, uint32_t events, Handler* handler) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events | EPOLLET;
+    ev.data.ptr = handler;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        return false;
+    }
+    registered++;
+    return true;
+}
+
+bool Reactor::remove(int fd) {
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL) != 0) {
+        return false;
+    }
+    registered--;
+    return true;
+}
+
+void Reactor::post(Waiter* w) {
+    ready.push(w);
+}
+
+int Reactor::runOnce(int timeout_ms) {
+    int woken = 0;
+    Waiter* w;
+
+    while ((w = ready.pop()) != NULL) {
+        w->wake(w);
+        woken++;
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    int n = epoll_wait(epoll_fd, events, MAX_EVENTS, ready.empty() ? timeout_ms : 0);
+    if (n < 0) {
+        return errno == EINTR ? woken : -1;
+    }
+
+    // Handlers only queue completions; nothing is resumed while dispatching,
+    // so a woken consumer may freely close or re-register its fd
+    for (int i = 0; i < n; ++i) {
+        static_cast<Handler*>(events[i].data.ptr)->onEvents(events[i].events);
+    }
+
+    while ((w = ready.pop()) != NULL) {
+        w->wake(w);
+        woken++;
+    }
+    return woken;
+}
+
+bool Reactor::run() {
+    while (!stopping && (registered > 0 || !ready.empty())) {
+        if (runOnce(-1) < 0) {
+            return false;
+        }
+    }
+    stopping = false;
+    return true;
+}
+
+AsyncDevice::AsyncDevice(Reactor& reactor, const std::string& path, size_t max_pending)
+    : reactor(reactor), device_path(path), device_fd(-1), owns_fd(false),
+      format(RECORD_BASIC), max_pending(max_pending ? max_pending : 1), error(0),
+      samples_dropped(0), alerts_seen(0) {}
+
+AsyncDevice::~AsyncDevice() {
+    close();
+}
+
+bool AsyncDevice::open() {
+    int fd = ::open(device_path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    RecordFormat fmt = setRecordFormat(fd, RECORD_EXTENDED) ? RECORD_EXTENDED : RECORD_BASIC;
+    if (!attach(fd, fmt)) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        return false;
+    }
+    owns_fd = true;
+    return true;
+}
+
+bool AsyncDevice::attach(int fd, RecordFormat fmt) {
+    close();
+    device_fd = fd;
+    format = fmt;
+    owns_fd = false;
+    error = 0;
+    if (!reactor.add(fd, EPOLLIN | EPOLLPRI, this)) {
+        device_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void AsyncDevice::close() {
+    if (device_fd < 0) {
+        return;
+    }
+    reactor.remove(device_fd);
+    if (owns_fd) {
+        ::close(device_fd);
+    }
+    device_fd = -1;
+    owns_fd = false;
+
+    error = EBADF;
+    failAll();
+    pending.clear();
+}
+
+void AsyncDevice::drain() {
+    if (device_fd < 0) {
+        return;
+    }
+
+    // Edge-triggered: read until the driver reports EAGAIN
+    size_t first_new = pending.size();
+    while (true) {
+        ssize_t n = readBatch(device_fd, pending, DRAIN_SAMPLES, -1, format);
+        if (n < 0) {
+            error = errno;
+            break;
+        }
+        if (static_cast<size_t>(n) < DRAIN_SAMPLES) {
+            break;
+        }
+    }
+
+    for (size_t i = first_new; i < pending.size(); ++i) {
+        if (!(pending.flags[i] & FLAG_THRESHOLD_CROSSED)) {
+            continue;
+        }
+        alerts_seen++;
+        while (!alert_waiters.empty()) {
+            AlertWaiter* w = static_cast<AlertWaiter*>(alert_waiters.pop());
+            w->sample.timestamp_ns = pending.timestamp_ns[i];
+            w->sample.temp_mC = pending.temp_mC[i];
+            w->sample.flags = pending.flags[i];
+            w->sample.seq = pending.seq[i];
+            w->result = 0;
+            w->error = 0;
+            reactor.post(w);
+        }
+    }
+
+    if (pending.size() > max_pending) {
+        size_t drop = pending.size() - max_pending;
+        pending.erasePrefix(drop);
+        samples_dropped += drop;
+    }
+}
+
+void AsyncDevice::deliver(BatchWaiter* w) {
+    size_t n = pending.size() < w->max_samples ? pending.size() : w->max_samples;
+    SampleBatch& out = *w->out;
+
+    out.clear();
+    if (n == pending.size()) {
+        // Hand over the whole pending batch; pending keeps out's storage
+        out.swap(pending);
+    } else {
+        out.timestamp_ns.assign(pending.timestamp_ns.begin(), pending.timestamp_ns.begin() + n);
+        out.temp_mC.assign(pending.temp_mC.begin(), pending.temp_mC.begin() + n);
+        out.flags.assign(pending.flags.begin(), pending.flags.begin() + n);
+        out.seq.assign(pending.seq.begin(), pending.seq.begin() + n);
+        pending.erasePrefix(n);
+    }
+    w->result = static_cast<ssize_t>(n);
+    w->error = 0;
+}
+
+void AsyncDevice::failAll() {
+    Waiter* w;
+    while ((w = batch_waiters.pop()) != NULL) {
+        BatchWaiter* bw = static_cast<BatchWaiter*>(w);
+        bw->result = -1;
+        bw->error = error;
+        reactor.post(bw);
+    }
+    while ((w = alert_waiters.pop()) != NULL) {
+        AlertWaiter* aw = static_cast<AlertWaiter*>(w);
+        aw->result = -1;
+        aw->error = error;
+        reactor.post(aw);
+    }
+}
+
+bool AsyncDevice::submitBatch(BatchWaiter& w) {
+    if (w.max_samples == 0) {
+        w.result = 0;
+        w.error = 0;
+        return true;
+    }
+    if (pending.empty() && error == 0) {
+        drain();
+    }
+    if (!pending.empty()) {
+        deliver(&w);
+        return true;
+    }
+    if (error != 0 || device_fd < 0) {
+        w.result = -1;
+        w.error = error ? error : EBADF;
+        return true;
+    }
+    batch_waiters.push(&w);
+    return false;
+}
+
+bool AsyncDevice::submitAlert(AlertWaiter& w) {
+    if (error != 0 || device_fd < 0) {
+        w.result = -1;
+        w.error = error ? error : EBADF;
+        return true;
+    }
+    alert_waiters.push(&w);
+    return false;
+}
+
+void AsyncDevice::cancel(Waiter& w) {
+    if (!batch_waiters.remove(&w) && !alert_waiters.remove(&w)) {
+        reactor.cancel(&w);
+    }
+}
+
+void AsyncDevice::onEvents(uint32_t events) {
+    drain();
+    if (error == 0 && (events & (EPOLLHUP | EPOLLERR))) {
+        error = (events & EPOLLERR) ? EIO : EPIPE;
+    }
+
+    while (!batch_waiters.empty() && !pending.empty()) {
+        BatchWaiter* w = static_cast<BatchWaiter*>(batch_waiters.pop());
+        deliver(w);
+        reactor.post(w);
+    }
+    if (error != 0) {
+        failAll();
+    }
+}
+
+} // namespace simtemp
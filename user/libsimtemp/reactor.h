@@ -0,0 +1,166 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Single-threaded epoll reactor and an asynchronous device on top of it.
+ * Waits are intrusive: the caller owns the wait node (typically on its
+ * stack or inside a coroutine frame), so waiting never allocates. Completed
+ * waits are queued and woken from Reactor::runOnce(), never from inside
+ * the operation that completed them. coro.h builds C++20 awaitables on
+ * these primitives.
+ */
+
+#ifndef SIMTEMP_REACTOR_H
+#define SIMTEMP_REACTOR_H
+
+#include "simtemp.h"
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+// Intrusive wait node; wake is called once from the reactor's run loop
+struct Waiter {
+    void (*wake)(Waiter* self);
+    Waiter* next;
+
+    Waiter() : wake(NULL), next(NULL) {}
+};
+
+// FIFO of wait nodes linked through Waiter::next
+class WaiterQueue {
+private:
+    Waiter* head;
+    Waiter* tail;
+
+public:
+    WaiterQueue() : head(NULL), tail(NULL) {}
+
+    bool empty() const { return head == NULL; }
+    Waiter* front() const { return head; }
+    void push(Waiter* w);
+    Waiter* pop();
+    bool remove(Waiter* w);
+};
+
+class Reactor {
+public:
+    // Receives the epoll events of one registered fd
+    class Handler {
+    public:
+        virtual ~Handler() {}
+        virtual void onEvents(uint32_t events) = 0;
+    };
+
+private:
+    int epoll_fd;
+    WaiterQueue ready;
+    size_t registered;
+    bool stopping;
+
+    Reactor(const Reactor&);
+    Reactor& operator=(const Reactor&);
+
+public:
+    Reactor();
+    ~Reactor();
+
+    bool open();
+    void close();
+
+    // Register fd edge-triggered for events (EPOLLIN, EPOLLPRI, ...)
+    bool add(int fd, uint32_t events, Handler* handler);
+    bool remove(int fd);
+
+    // Queue w to be woken on the next turn of the run loop
+    void post(Waiter* w);
+    // Withdraw a posted waiter that has not been woken yet
+    void cancel(Waiter* w) { ready.remove(w); }
+
+    // Wake everything already posted, wait up to timeout_ms for events (not
+    // at all if work is pending), dispatch them and wake what they posted.
+    // Returns the number of waiters woken, -1 on error.
+    int runOnce(int timeout_ms = -1);
+    // Run until stop() is called or nothing is registered or posted
+    bool run();
+    void stop() { stopping = true; }
+
+    size_t registeredCount() const { return registered; }
+};
+
+/*
+ * Nonblocking device driven by a Reactor. Samples are drained into a pending
+ * batch whenever the fd becomes readable and handed to batch waiters in
+ * arrival order; samples nobody asked for yet stay pending up to
+ * max_pending, beyond which the oldest are dropped and counted. Every
+ * sample carrying FLAG_THRESHOLD_CROSSED completes all current alert
+ * waiters (alerts are derived from the sample stream, so one device can
+ * serve both kinds of waiter).
+ */
+class AsyncDevice : public Reactor::Handler {
+public:
+    struct BatchWaiter : Waiter {
+        SampleBatch* out;           // replaced with up to max_samples samples
+        size_t max_samples;
+        ssize_t result;             // samples delivered, or -1 with error set
+        int error;
+    };
+
+    struct AlertWaiter : Waiter {
+        SimTempSampleExt sample;    // the sample that crossed the threshold
+        int result;                 // 0, or -1 with error set
+        int error;
+    };
+
+private:
+    Reactor& reactor;
+    std::string device_path;
+    int device_fd;
+    bool owns_fd;
+    RecordFormat format;
+    SampleBatch pending;
+    size_t max_pending;
+    WaiterQueue batch_waiters;
+    WaiterQueue alert_waiters;
+    int error;
+    uint64_t samples_dropped;
+    uint64_t alerts_seen;
+
+    AsyncDevice(const AsyncDevice&);
+    AsyncDevice& operator=(const AsyncDevice&);
+
+    void drain();
+    void deliver(BatchWaiter* w);
+    void failAll();
+
+public:
+    AsyncDevice(Reactor& reactor, const std::string& path = DEVICE_PATH,
+                size_t max_pending = 4096);
+    ~AsyncDevice();
+
+    bool open();
+    // Use an already open nonblocking fd (not closed by close())
+    bool attach(int fd, RecordFormat format);
+    void close();
+
+    // Complete w immediately when samples are available (returns true),
+    // otherwise queue it and return false
+    bool submitBatch(BatchWaiter& w);
+    bool submitAlert(AlertWaiter& w);
+    // Withdraw a queued or completed-but-not-woken wait (e.g. when the
+    // waiting coroutine is destroyed)
+    void cancel(Waiter& w);
+
+    void onEvents(uint32_t events);
+
+    int fd() const { return device_fd; }
+    RecordFormat recordFormat() const { return format; }
+    size_t pendingCount() const { return pending.size(); }
+    uint64_t samplesDropped() const { return samples_dropped; }
+    uint64_t alertsSeen() const { return alerts_seen; }
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_REACTOR_H
@@ -0,0 +1,488 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Recording file writer, memory-mapped reader and parallel verifier.
+ */
+
+#include "recording.h"
+#include "crc32c.h"
+
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+namespace simtemp {
+
+static bool writeFully(int fd, struct iovec* iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t n = ::writev(fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        size_t done = static_cast<size_t>(n);
+        while (iovcnt > 0 && done >= iov->iov_len) {
+            done -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + done;
+            iov->iov_len -= done;
+        }
+    }
+    return true;
+}
+
+static size_t chunkBytes(size_t count) {
+    return sizeof(ChunkHeader) + count * (sizeof(uint64_t) + sizeof(int32_t) + sizeof(uint32_t));
+}
+
+uint32_t chunkCrc(const ChunkHeader& header, const uint64_t* timestamp_ns,
+                  const int32_t* temp_mC, const uint32_t* flags) {
+    uint32_t crc = crc32c(&header, CHUNK_CRC_HEADER_BYTES);
+    crc = crc32c(timestamp_ns, header.count * sizeof(uint64_t), crc);
+    crc = crc32c(temp_mC, header.count * sizeof(int32_t), crc);
+    return crc32c(flags, header.count * sizeof(uint32_t), crc);
+}
+
+RecordingWriter::RecordingWriter(uint32_t chunk_samples)
+    : fd(-1), chunk_samples(chunk_samples ? chunk_samples : DEFAULT_CHUNK_SAMPLES),
+      offset(0), samples_written(0), checksums(true) {}
+
+RecordingWriter::~RecordingWriter() {
+    close();
+}
+
+bool RecordingWriter::open(const std::string& path) {
+    close();
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    file_path = path;
+
+    RecordingHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+    header.version = RECORDING_VERSION;
+    header.chunk_samples = chunk_samples;
+    header.features = RECORDING_FEATURE_CRC32C;
+
+    struct iovec iov = { &header, sizeof(header) };
+    if (!writeFully(fd, &iov, 1)) {
+        int saved = errno;
+        ::close(fd);
+        fd = -1;
+        errno = saved;
+        return false;
+    }
+
+    offset = sizeof(header);
+    samples_written = 0;
+    checksums = true;
+    pending.clear();
+    pending.reserve(chunk_samples);
+    return true;
+}
+
+bool RecordingWriter::openAppend(const std::string& path, uint64_t resume_offset) {
+    close();
+
+    if (resume_offset == 0) {
+        return open(path);
+    }
+
+    fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return errno == ENOENT ? open(path) : false;
+    }
+
+    RecordingHeader header;
+    struct stat st;
+    if (::pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+        memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != RECORDING_VERSION || fstat(fd, &st) != 0 ||
+        resume_offset < sizeof(header) || resume_offset > static_cast<uint64_t>(st.st_size)) {
+        ::close(fd);
+        fd = -1;
+        errno = EINVAL;
+        return false;
+    }
+
+    if (::ftruncate(fd, resume_offset) != 0 ||
+        ::lseek(fd, resume_offset, SEEK_SET) < 0) {
+        int saved = errno;
+        ::close(fd);
+        fd = -1;
+        errno = saved;
+        return false;
+    }
+
+    file_path = path;
+    chunk_samples = header.chunk_samples ? header.chunk_samples : chunk_samples;
+    offset = resume_offset;
+    samples_written = 0;
+    checksums = (header.features & RECORDING_FEATURE_CRC32C) != 0;
+    pending.clear();
+    pending.reserve(chunk_samples);
+    return true;
+}
+
+bool RecordingWriter::writeChunk(const uint64_t* timestamp_ns, const int32_t* temp_mC,
+                                 const uint32_t* flags, size_t count) {
+    ChunkHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CHUNK_MAGIC;
+    header.count = static_cast<uint32_t>(count);
+    header.first_ns = timestamp_ns[0];
+    header.last_ns = timestamp_ns[count - 1];
+    if (checksums) {
+        header.crc = chunkCrc(header, timestamp_ns, temp_mC, flags);
+    }
+
+    struct iovec iov[4];
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = const_cast<uint64_t*>(timestamp_ns);
+    iov[1].iov_len = count * sizeof(uint64_t);
+    iov[2].iov_base = const_cast<int32_t*>(temp_mC);
+    iov[2].iov_len = count * sizeof(int32_t);
+    iov[3].iov_base = const_cast<uint32_t*>(flags);
+    iov[3].iov_len = count * sizeof(uint32_t);
+
+    if (!writeFully(fd, iov, 4)) {
+        return false;
+    }
+
+    offset += chunkBytes(count);
+    samples_written += count;
+    return true;
+}
+
+bool RecordingWriter::append(const SampleBatch& batch) {
+    if (fd < 0) {
+        errno = EBADF;
+        return false;
+    }
+
+    size_t pos = 0;
+    size_t n = batch.size();
+
+    // Fast path: whole chunks straight from the batch columns
+    if (pending.empty()) {
+        while (n - pos >= chunk_samples) {
+            if (!writeChunk(&batch.timestamp_ns[pos], &batch.temp_mC[pos],
+                            &batch.flags[pos], chunk_samples)) {
+                return false;
+            }
+            pos += chunk_samples;
+        }
+    }
+
+    while (pos < n) {
+        size_t take = chunk_samples - pending.size();
+        if (take > n - pos) {
+            take = n - pos;
+        }
+        pending.timestamp_ns.insert(pending.timestamp_ns.end(),
+                                    batch.timestamp_ns.begin() + pos,
+                                    batch.timestamp_ns.begin() + pos + take);
+        pending.temp_mC.insert(pending.temp_mC.end(),
+                               batch.temp_mC.begin() + pos,
+                               batch.temp_mC.begin() + pos + take);
+        pending.flags.insert(pending.flags.end(),
+                             batch.flags.begin() + pos,
+                             batch.flags.begin() + pos + take);
+        pos += take;
+
+        if (pending.size() == chunk_samples && !flush()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool RecordingWriter::flush() {
+    if (fd < 0) {
+        errno = EBADF;
+        return false;
+    }
+    if (pending.empty()) {
+        return true;
+    }
+    if (!writeChunk(pending.timestamp_ns.data(), pending.temp_mC.data(),
+                    pending.flags.data(), pending.size())) {
+        return false;
+    }
+    pending.clear();
+    return true;
+}
+
+bool RecordingWriter::sync() {
+    return fd >= 0 && ::fdatasync(fd) == 0;
+}
+
+void RecordingWriter::close() {
+    if (fd >= 0) {
+        flush();
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+RecordingReader::RecordingReader()
+    : base(NULL), length(0), sample_count(0), trailing_bytes(0), checksummed(false) {}
+
+RecordingReader::~RecordingReader() {
+    close();
+}
+
+bool RecordingReader::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        return false;
+    }
+
+    if (static_cast<size_t>(st.st_size) < sizeof(RecordingHeader)) {
+        ::close(fd);
+        errno = EINVAL;
+        return false;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    int saved = errno;
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        errno = saved;
+        return false;
+    }
+
+    base = static_cast<const uint8_t*>(map);
+    length = st.st_size;
+
+    const RecordingHeader* header = reinterpret_cast<const RecordingHeader*>(base);
+    if (memcmp(header->magic, RECORDING_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != RECORDING_VERSION) {
+        close();
+        errno = EINVAL;
+        return false;
+    }
+    checksummed = (header->features & RECORDING_FEATURE_CRC32C) != 0;
+    madvise(const_cast<uint8_t*>(base), length, MADV_SEQUENTIAL);
+
+    size_t pos = sizeof(RecordingHeader);
+    while (length - pos >= sizeof(ChunkHeader)) {
+        RecordingChunk chunk;
+        if (parseChunk(pos, chunk) && (!checksummed || chunkLinked(chunk))) {
+            chunk_index.push_back(chunk);
+            sample_count += chunk.count;
+            pos += chunkBytes(chunk.count);
+            continue;
+        }
+
+        // A torn tail has no intact chunk after it; anything else is damage
+        size_t next = checksummed ? resync(pos) : 0;
+        if (next == 0) {
+            break;
+        }
+        RecordingGap gap = { pos, next - pos };
+        gaps.push_back(gap);
+        pos = next;
+    }
+    trailing_bytes = length - pos;
+
+    return true;
+}
+
+void RecordingReader::close() {
+    if (base) {
+        munmap(const_cast<uint8_t*>(base), length);
+        base = NULL;
+    }
+    length = 0;
+    chunk_index.clear();
+    gaps.clear();
+    sample_count = 0;
+    trailing_bytes = 0;
+    checksummed = false;
+}
+
+bool RecordingReader::chunkIntact(size_t i) const {
+    if (!checksummed) {
+        return true;
+    }
+    const RecordingChunk& chunk = chunk_index[i];
+    const ChunkHeader* ch = reinterpret_cast<const ChunkHeader*>(base + chunk.offset);
+    return chunkCrc(*ch, chunk.timestamp_ns, chunk.temp_mC, chunk.flags) == chunk.crc;
+}
+
+bool RecordingReader::parseChunk(size_t pos, RecordingChunk& chunk) const {
+    const ChunkHeader* ch = reinterpret_cast<const ChunkHeader*>(base + pos);
+    size_t room = (length - pos - sizeof(ChunkHeader)) /
+                  (sizeof(uint64_t) + sizeof(int32_t) + sizeof(uint32_t));
+    if (ch->magic != CHUNK_MAGIC || ch->count == 0 || ch->count > room) {
+        return false;
+    }
+
+    const uint8_t* cols = base + pos + sizeof(ChunkHeader);
+    chunk.offset = pos;
+    chunk.count = ch->count;
+    chunk.first_ns = ch->first_ns;
+    chunk.last_ns = ch->last_ns;
+    chunk.timestamp_ns = reinterpret_cast<const uint64_t*>(cols);
+    chunk.temp_mC = reinterpret_cast<const int32_t*>(cols + ch->count * sizeof(uint64_t));
+    chunk.flags = reinterpret_cast<const uint32_t*>(cols + ch->count *
+                                                    (sizeof(uint64_t) + sizeof(int32_t)));
+    chunk.crc = ch->crc;
+    return true;
+}
+
+bool RecordingReader::chunkLinked(const RecordingChunk& chunk) const {
+    // A count damaged into another in-bounds value would swallow the chunks
+    // behind it; when no chunk header follows, trust the length only if the
+    // CRC matches
+    size_t next = chunk.offset + chunkBytes(chunk.count);
+    if (length - next < sizeof(ChunkHeader) ||
+        reinterpret_cast<const ChunkHeader*>(base + next)->magic == CHUNK_MAGIC) {
+        return true;
+    }
+    const ChunkHeader* ch = reinterpret_cast<const ChunkHeader*>(base + chunk.offset);
+    return chunkCrc(*ch, chunk.timestamp_ns, chunk.temp_mC, chunk.flags) == chunk.crc;
+}
+
+size_t RecordingReader::resync(size_t pos) const {
+    // Chunks are 32 + 16 * n bytes after a 32-byte file header, so every
+    // chunk starts on a 16-byte offset; only a matching CRC is trusted
+    for (pos += 16; length - pos >= sizeof(ChunkHeader); pos += 16) {
+        RecordingChunk chunk;
+        if (parseChunk(pos, chunk)) {
+            const ChunkHeader* ch = reinterpret_cast<const ChunkHeader*>(base + pos);
+            if (chunkCrc(*ch, chunk.timestamp_ns, chunk.temp_mC, chunk.flags) == chunk.crc) {
+                return pos;
+            }
+        }
+    }
+    return 0;
+}
+
+bool verifyRecording(const RecordingReader& reader, VerifyReport& report, unsigned threads) {
+    size_t n = reader.chunkCount();
+    report.checksummed = reader.hasChecksums();
+    report.chunks = n;
+    report.damaged_chunks = 0;
+    report.bytes_checked = 0;
+    report.trailing_bytes = reader.trailingBytes();
+    report.damaged.clear();
+
+    std::vector<uint8_t> intact(n, 1);
+    if (report.checksummed && n > 0) {
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        if (threads == 0) {
+            threads = 1;
+        }
+        if (threads > n) {
+            threads = static_cast<unsigned>(n);
+        }
+
+        // Contiguous runs of roughly equal bytes, so each worker streams
+        // through its own part of the mapping
+        uint64_t total = 0;
+        for (size_t i = 0; i < n; ++i) {
+            total += chunkBytes(reader.chunk(i).count);
+        }
+        std::vector<size_t> bounds(1, 0);
+        uint64_t acc = 0;
+        for (size_t i = 0; i + 1 < n && bounds.size() < threads; ++i) {
+            acc += chunkBytes(reader.chunk(i).count);
+            if (acc * threads >= total * bounds.size()) {
+                bounds.push_back(i + 1);
+            }
+        }
+        bounds.push_back(n);
+
+        std::vector<std::thread> workers;
+        for (size_t w = 0; w + 1 < bounds.size(); ++w) {
+            size_t lo = bounds[w];
+            size_t hi = bounds[w + 1];
+            workers.push_back(std::thread([&reader, &intact, lo, hi] {
+                for (size_t i = lo; i < hi; ++i) {
+                    intact[i] = reader.chunkIntact(i) ? 1 : 0;
+                }
+            }));
+        }
+        for (size_t w = 0; w < workers.size(); ++w) {
+            workers[w].join();
+        }
+        report.bytes_checked = total;
+    }
+
+    // Walk chunks and skipped regions in file order, merging adjacent
+    // damage and bounding each run by the nearest intact timestamps
+    const std::vector<RecordingGap>& gaps = reader.skippedRegions();
+    size_t g = 0;
+    uint64_t last_good_ns = 0;
+    bool open_run = false;
+    for (size_t i = 0; i <= n; ++i) {
+        uint64_t chunk_offset = i < n ? reader.chunk(i).offset : UINT64_MAX;
+        for (; g < gaps.size() && gaps[g].offset < chunk_offset; ++g) {
+            DamagedRange* run = open_run ? &report.damaged.back() : NULL;
+            if (run && run->offset + run->length == gaps[g].offset) {
+                run->length += gaps[g].length;
+            } else {
+                DamagedRange range = { gaps[g].offset, gaps[g].length, 0, last_good_ns, 0 };
+                report.damaged.push_back(range);
+                open_run = true;
+            }
+        }
+        if (i == n) {
+            break;
+        }
+
+        const RecordingChunk& chunk = reader.chunk(i);
+        if (intact[i]) {
+            if (open_run) {
+                report.damaged.back().before_ns = chunk.first_ns;
+                open_run = false;
+            }
+            last_good_ns = chunk.last_ns;
+            continue;
+        }
+
+        ++report.damaged_chunks;
+        DamagedRange* run = open_run ? &report.damaged.back() : NULL;
+        if (run && run->offset + run->length == chunk.offset) {
+            run->length += chunkBytes(chunk.count);
+            ++run->chunks;
+        } else {
+            DamagedRange range = { chunk.offset, chunkBytes(chunk.count), 1, last_good_ns, 0 };
+            report.damaged.push_back(range);
+            open_run = true;
+        }
+    }
+
+    return report.checksummed && report.damaged.empty();
+}
+
+} // namespace simtemp
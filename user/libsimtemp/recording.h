@@ -0,0 +1,191 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Recording files. A recording is a file header followed by self-describing
+ * chunks; each chunk stores its samples column by column (timestamps, then
+ * temperatures, then flags), so a SampleBatch is written without per-record
+ * transformation and a memory-mapped reader hands out column pointers
+ * directly.
+ *
+ *   RecordingHeader (32 bytes)
+ *   ChunkHeader (32 bytes) | uint64 timestamp_ns[n] | int32 temp_mC[n] | uint32 flags[n]
+ *   ChunkHeader ...
+ *
+ * All fields are little-endian. Chunk size is 32 + 16 * n bytes, so every
+ * column stays naturally aligned in the mapping.
+ *
+ * With RECORDING_FEATURE_CRC32C set in the file header, each chunk header
+ * carries a CRC32C of its first 24 bytes and the three columns. Damage is
+ * then confined to the chunks it hits: the reader resynchronizes on the
+ * next intact chunk header, and verifyRecording() checks every chunk in
+ * parallel and reports the damaged byte and time ranges.
+ */
+
+#ifndef SIMTEMP_RECORDING_H
+#define SIMTEMP_RECORDING_H
+
+#include "simtemp.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+const char RECORDING_MAGIC[8] = {'S', 'I', 'M', 'T', 'R', 'E', 'C', '1'};
+const uint32_t RECORDING_VERSION = 1;
+const uint32_t CHUNK_MAGIC = 0x4b4e4843;  // "CHNK"
+const uint32_t DEFAULT_CHUNK_SAMPLES = 4096;
+const uint64_t RECORDING_FEATURE_CRC32C = 0x1;  // chunk headers carry a CRC32C
+
+struct RecordingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t chunk_samples;     // writer's nominal chunk size
+    uint64_t features;          // RECORDING_FEATURE_* bits
+    uint64_t reserved;
+};
+
+struct ChunkHeader {
+    uint32_t magic;
+    uint32_t count;
+    uint64_t first_ns;
+    uint64_t last_ns;
+    uint32_t crc;               // CRC32C of the fields above and the columns
+    uint32_t reserved;
+};
+
+// Bytes of ChunkHeader covered by the CRC
+const size_t CHUNK_CRC_HEADER_BYTES = 24;
+
+// View of one chunk inside a mapped recording
+struct RecordingChunk {
+    uint64_t offset;            // file offset of the chunk header
+    size_t count;
+    uint64_t first_ns;
+    uint64_t last_ns;
+    const uint64_t* timestamp_ns;
+    const int32_t* temp_mC;
+    const uint32_t* flags;
+    uint32_t crc;               // stored CRC (0 without RECORDING_FEATURE_CRC32C)
+};
+
+// CRC32C of a chunk as stored: header fields, then the columns
+uint32_t chunkCrc(const ChunkHeader& header, const uint64_t* timestamp_ns,
+                  const int32_t* temp_mC, const uint32_t* flags);
+
+class RecordingWriter {
+private:
+    std::string file_path;
+    int fd;
+    uint32_t chunk_samples;
+    SampleBatch pending;
+    uint64_t offset;
+    uint64_t samples_written;
+    bool checksums;
+
+    bool writeChunk(const uint64_t* timestamp_ns, const int32_t* temp_mC,
+                    const uint32_t* flags, size_t count);
+
+public:
+    RecordingWriter(uint32_t chunk_samples = DEFAULT_CHUNK_SAMPLES);
+    ~RecordingWriter();
+
+    // Create (or truncate) path and write the file header
+    bool open(const std::string& path);
+    // Reopen an existing recording for appending, discarding everything past
+    // offset (e.g. data written after the last checkpoint). An offset of 0 or
+    // a missing file behaves like open(). Chunks get a CRC only if the
+    // existing file was written with them.
+    bool openAppend(const std::string& path, uint64_t offset);
+    // Buffer samples; full chunks are written as soon as they fill
+    bool append(const SampleBatch& batch);
+    // Write any buffered samples as a (short) chunk
+    bool flush();
+    bool sync();
+    void close();
+
+    bool isOpen() const { return fd >= 0; }
+    uint64_t bytesWritten() const { return offset; }
+    uint64_t samplesWritten() const { return samples_written; }
+};
+
+// File bytes between intact chunks that could not be parsed as chunks
+struct RecordingGap {
+    uint64_t offset;
+    uint64_t length;
+};
+
+class RecordingReader {
+private:
+    const uint8_t* base;
+    size_t length;
+    std::vector<RecordingChunk> chunk_index;
+    std::vector<RecordingGap> gaps;
+    size_t sample_count;
+    size_t trailing_bytes;
+    bool checksummed;
+
+    bool parseChunk(size_t pos, RecordingChunk& chunk) const;
+    bool chunkLinked(const RecordingChunk& chunk) const;
+    size_t resync(size_t pos) const;
+
+    RecordingReader(const RecordingReader&);
+    RecordingReader& operator=(const RecordingReader&);
+
+public:
+    RecordingReader();
+    ~RecordingReader();
+
+    // Map path read-only and index its chunks. A torn final chunk (e.g. from
+    // a crash mid-write) is left out of the index and counted in trailingBytes().
+    // In checksummed files a damaged chunk header does not end the index:
+    // parsing resumes at the next chunk whose CRC matches, and the bytes in
+    // between are listed in skippedRegions().
+    bool open(const std::string& path);
+    void close();
+
+    size_t chunkCount() const { return chunk_index.size(); }
+    const RecordingChunk& chunk(size_t i) const { return chunk_index[i]; }
+    size_t sampleCount() const { return sample_count; }
+    size_t trailingBytes() const { return trailing_bytes; }
+    bool hasChecksums() const { return checksummed; }
+    const std::vector<RecordingGap>& skippedRegions() const { return gaps; }
+    // CRC check of one chunk (always true without checksums). The index
+    // keeps damaged chunks, so verifyRecording() can report them; every
+    // consumer of chunk data checks this first and skips or reports the
+    // chunk (RecordingSource, --export-arrow, the Python binding)
+    bool chunkIntact(size_t i) const;
+    const uint8_t* data() const { return base; }
+    size_t size() const { return length; }
+};
+
+// A run of damaged file bytes and the time span whose samples it lost
+struct DamagedRange {
+    uint64_t offset;            // file bytes [offset, offset + length)
+    uint64_t length;
+    size_t chunks;              // indexed chunks failing their CRC
+    uint64_t after_ns;          // last intact timestamp before the range (0: none)
+    uint64_t before_ns;         // first intact timestamp after the range (0: none)
+};
+
+struct VerifyReport {
+    bool checksummed;
+    size_t chunks;              // chunks indexed
+    size_t damaged_chunks;
+    uint64_t bytes_checked;
+    uint64_t trailing_bytes;    // torn tail, as left by a crash mid-write
+    std::vector<DamagedRange> damaged;  // in file order, adjacent runs merged
+};
+
+/*
+ * Check the CRC of every chunk of an open recording, splitting the chunks
+ * into contiguous runs over threads workers (0: one per CPU). Returns true
+ * when the recording is checksummed and nothing is damaged.
+ */
+bool verifyRecording(const RecordingReader& reader, VerifyReport& report, unsigned threads = 0);
+
+} // namespace simtemp
+
+#endif // SIMTEMP_RECORDING_H
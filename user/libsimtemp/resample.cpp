@@ -0,0 +1,268 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Polyphase resampler with tabulated tent and windowed-sinc kernels.
+ */
+
+#include "resample.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace simtemp {
+
+// History kept past what the kernel still needs before compacting
+static const size_t TRIM_SLACK = 4096;
+
+Resampler::Resampler(const ResamplerConfig& cfg, uint64_t input_period_ns)
+    : config(cfg), input_period_ns(input_period_ns ? input_period_ns : cfg.period_ns),
+      half(1), cursor(0), flag_pos(0), next_ns(0), started(false) {
+    if (config.period_ns == 0) {
+        config.period_ns = this->input_period_ns;
+    }
+    if (config.phases == 0) {
+        config.phases = 1;
+    }
+    if (config.zero_crossings == 0) {
+        config.zero_crossings = 1;
+    }
+    buildTable();
+}
+
+void Resampler::buildTable() {
+    // Fraction of the input band that survives on the output grid
+    double cutoff = static_cast<double>(input_period_ns) / config.period_ns;
+    if (cutoff > 1.0) {
+        cutoff = 1.0;
+    }
+
+    double radius = config.method == RESAMPLE_SINC ? config.zero_crossings / cutoff : 1.0 / cutoff;
+    half = static_cast<unsigned>(std::ceil(radius - 1e-9));
+    if (half == 0) {
+        half = 1;
+    }
+
+    size_t taps = 2 * half;
+    table.assign((config.phases + 1) * taps, 0.0f);
+    for (unsigned p = 0; p <= config.phases; ++p) {
+        double frac = static_cast<double>(p) / config.phases;
+        double sum = 0.0;
+        std::vector<double> row(taps);
+
+        // Tap k weights input i - half + 1 + k for an output at i + frac
+        for (size_t k = 0; k < taps; ++k) {
+            double d = static_cast<double>(k) - (half - 1) - frac;
+            double w;
+            if (config.method == RESAMPLE_SINC) {
+                double u = d / radius;
+                if (std::fabs(u) >= 1.0) {
+                    w = 0.0;
+                } else {
+                    double x = M_PI * cutoff * d;
+                    double sinc = std::fabs(x) < 1e-12 ? 1.0 : std::sin(x) / x;
+                    double blackman = 0.42 + 0.5 * std::cos(M_PI * u) + 0.08 * std::cos(2.0 * M_PI * u);
+                    w = sinc * blackman;
+                }
+            } else {
+                w = 1.0 - std::fabs(d) * cutoff;
+                if (w < 0.0) {
+                    w = 0.0;
+                }
+            }
+            row[k] = w;
+            sum += w;
+        }
+
+        // Unity DC gain for every phase
+        for (size_t k = 0; k < taps; ++k) {
+            table[p * taps + k] = static_cast<float>(sum != 0.0 ? row[k] / sum : 0.0);
+        }
+    }
+}
+
+uint64_t Resampler::gridAtOrAfter(uint64_t t) const {
+    if (t <= config.origin_ns) {
+        return config.origin_ns;
+    }
+    uint64_t steps = (t - config.origin_ns + config.period_ns - 1) / config.period_ns;
+    return config.origin_ns + steps * config.period_ns;
+}
+
+int32_t Resampler::interpolate(size_t i, unsigned phase) const {
+    size_t taps = 2 * half;
+    const float* h = &table[phase * taps];
+    float acc = 0.0f;
+
+    if (i + 1 >= half && i + half < hist_mC.size()) {
+        // Interior: one contiguous dot product. taps is even; two partial
+        // sums keep the loop free of a serial dependency
+        const float* x = &hist_mC[i + 1 - half];
+        float acc2 = 0.0f;
+        for (size_t k = 0; k < taps; k += 2) {
+            acc += h[k] * x[k];
+            acc2 += h[k + 1] * x[k + 1];
+        }
+        acc += acc2;
+    } else {
+        // Stream edges: repeat the first/last sample
+        long last = static_cast<long>(hist_mC.size()) - 1;
+        for (size_t k = 0; k < taps; ++k) {
+            long j = static_cast<long>(i) + 1 - static_cast<long>(half) + static_cast<long>(k);
+            j = j < 0 ? 0 : (j > last ? last : j);
+            acc += h[k] * hist_mC[j];
+        }
+    }
+    return static_cast<int32_t>(std::lround(acc));
+}
+
+size_t Resampler::produce(SampleBatch& out, bool final) {
+    size_t produced = 0;
+    size_t size = hist_ns.size();
+    uint64_t max_gap = config.max_gap_ns ? config.max_gap_ns : 4 * input_period_ns;
+
+    while (started) {
+        while (cursor + 1 < size && hist_ns[cursor + 1] <= next_ns) {
+            cursor++;
+        }
+        if (next_ns < hist_ns[cursor] || (!final && cursor + half >= size)) {
+            break;
+        }
+
+        unsigned phase = 0;
+        if (cursor + 1 < size) {
+            uint64_t gap = hist_ns[cursor + 1] - hist_ns[cursor];
+            if (gap > max_gap) {
+                // Nothing trustworthy to interpolate across a dropout
+                next_ns = gridAtOrAfter(hist_ns[cursor + 1]);
+                continue;
+            }
+            double frac = static_cast<double>(next_ns - hist_ns[cursor]) / gap;
+            phase = static_cast<unsigned>(frac * config.phases + 0.5);
+        } else if (next_ns > hist_ns[cursor]) {
+            break;
+        }
+
+        // Flags of every input since the previous grid point
+        uint32_t flags = 0;
+        while (flag_pos < size && hist_ns[flag_pos] <= next_ns) {
+            flags |= hist_flags[flag_pos++];
+        }
+
+        SimTempSample sample;
+        sample.timestamp_ns = next_ns;
+        sample.temp_mC = interpolate(cursor, phase);
+        sample.flags = flags;
+        out.push_back(sample);
+        produced++;
+        next_ns += config.period_ns;
+    }
+
+    trim();
+    return produced;
+}
+
+void Resampler::trim() {
+    size_t keep_from = cursor + 1 >= half ? cursor + 1 - half : 0;
+    if (flag_pos < keep_from) {
+        keep_from = flag_pos;
+    }
+    if (keep_from < TRIM_SLACK) {
+        return;
+    }
+
+    hist_ns.erase(hist_ns.begin(), hist_ns.begin() + keep_from);
+    hist_mC.erase(hist_mC.begin(), hist_mC.begin() + keep_from);
+    hist_flags.erase(hist_flags.begin(), hist_flags.begin() + keep_from);
+    cursor -= keep_from;
+    flag_pos -= keep_from;
+}
+
+size_t Resampler::process(const uint64_t* timestamp_ns, const int32_t* temp_mC,
+                          const uint32_t* flags, size_t n, SampleBatch& out) {
+    for (size_t i = 0; i < n; ++i) {
+        // The kernel needs strictly increasing input times
+        if (!hist_ns.empty() && timestamp_ns[i] <= hist_ns.back()) {
+            continue;
+        }
+        hist_ns.push_back(timestamp_ns[i]);
+        hist_mC.push_back(static_cast<float>(temp_mC[i]));
+        hist_flags.push_back(flags ? flags[i] : 0);
+    }
+
+    if (!started && !hist_ns.empty()) {
+        next_ns = gridAtOrAfter(hist_ns[0]);
+        started = true;
+    }
+    return produce(out, false);
+}
+
+size_t Resampler::finish(SampleBatch& out) {
+    return produce(out, true);
+}
+
+void Resampler::setInputPeriod(uint64_t period_ns) {
+    if (period_ns && period_ns != input_period_ns) {
+        input_period_ns = period_ns;
+        buildTable();
+    }
+}
+
+void Resampler::reset() {
+    hist_ns.clear();
+    hist_mC.clear();
+    hist_flags.clear();
+    cursor = 0;
+    flag_pos = 0;
+    next_ns = 0;
+    started = false;
+}
+
+std::string Resampler::describe() const {
+    std::ostringstream ss;
+    ss << (config.period_ns / 1e6) << "ms:";
+    if (config.method == RESAMPLE_SINC) {
+        ss << "sinc:" << config.zero_crossings;
+    } else {
+        ss << "linear";
+    }
+    ss << " (" << 2 * half << " taps, " << config.phases << " phases)";
+    return ss.str();
+}
+
+bool parseResampleSpec(const std::string& spec, ResamplerConfig& config) {
+    const char* p = spec.c_str();
+    char* end;
+    double period_ms = strtod(p, &end);
+    if (end == p || period_ms <= 0.0) {
+        return false;
+    }
+    config.period_ns = static_cast<uint64_t>(period_ms * 1e6 + 0.5);
+    config.method = RESAMPLE_LINEAR;
+    if (*end == '\0') {
+        return true;
+    }
+
+    std::string rest(end);
+    if (rest == ":linear") {
+        return true;
+    }
+    if (rest.compare(0, 5, ":sinc") != 0) {
+        return false;
+    }
+    config.method = RESAMPLE_SINC;
+    if (rest.size() == 5) {
+        return true;
+    }
+    if (rest[5] != ':') {
+        return false;
+    }
+    long zc = strtol(rest.c_str() + 6, &end, 10);
+    if (*end != '\0' || zc < 1 || zc > 64) {
+        return false;
+    }
+    config.zero_crossings = static_cast<unsigned>(zc);
+    return true;
+}
+
+} // namespace simtemp
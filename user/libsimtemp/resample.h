@@ -0,0 +1,90 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Polyphase resampling onto a shared time grid. Every stream is mapped onto
+ * the grid origin_ns + k * period_ns, so resampled streams from sensors with
+ * different sampling_ms line up sample by sample. The interpolation kernel
+ * (a tent for linear, a Blackman-windowed sinc otherwise) is tabulated for
+ * a fixed number of fractional phases when the resampler is built; each
+ * output is then one dot product of a table row with the input history.
+ * When the grid is coarser than the input the kernel is stretched to the
+ * output Nyquist rate, so decimation is anti-aliased.
+ */
+
+#ifndef SIMTEMP_RESAMPLE_H
+#define SIMTEMP_RESAMPLE_H
+
+#include "simtemp.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+enum ResampleMethod {
+    RESAMPLE_LINEAR = 0,
+    RESAMPLE_SINC = 1
+};
+
+struct ResamplerConfig {
+    uint64_t period_ns;         // output grid period
+    uint64_t origin_ns;         // grid phase; 0 aligns to multiples of period_ns
+    ResampleMethod method;
+    unsigned zero_crossings;    // sinc half-width in (output-rate) zero crossings
+    unsigned phases;            // fractional positions tabulated per input interval
+    uint64_t max_gap_ns;        // no output across wider input gaps (0: 4 input periods)
+
+    ResamplerConfig(uint64_t period_ns = 100000000ULL, ResampleMethod method = RESAMPLE_LINEAR)
+        : period_ns(period_ns), origin_ns(0), method(method), zero_crossings(8),
+          phases(64), max_gap_ns(0) {}
+};
+
+class Resampler {
+private:
+    ResamplerConfig config;
+    uint64_t input_period_ns;
+    unsigned half;                  // kernel half-width in input samples
+    std::vector<float> table;       // phases + 1 rows of 2 * half taps
+    std::vector<uint64_t> hist_ns;
+    std::vector<float> hist_mC;
+    std::vector<uint32_t> hist_flags;
+    size_t cursor;                  // history index at or before next_ns
+    size_t flag_pos;                // first input whose flags are not yet emitted
+    uint64_t next_ns;               // next grid point to produce
+    bool started;
+
+    void buildTable();
+    uint64_t gridAtOrAfter(uint64_t t) const;
+    int32_t interpolate(size_t i, unsigned phase) const;
+    size_t produce(SampleBatch& out, bool final);
+    void trim();
+
+public:
+    // input_period_ns is the nominal input interval (sampling_ms * 1e6)
+    Resampler(const ResamplerConfig& config, uint64_t input_period_ns);
+
+    // Feed n input samples (timestamps increasing) and append every grid
+    // point that now has enough input on both sides to out
+    size_t process(const uint64_t* timestamp_ns, const int32_t* temp_mC, const uint32_t* flags,
+                   size_t n, SampleBatch& out);
+    size_t process(const SampleBatch& in, SampleBatch& out) {
+        return process(in.timestamp_ns.data(), in.temp_mC.data(), in.flags.data(), in.size(), out);
+    }
+    // Emit the remaining grid points up to the last input (edge samples repeated)
+    size_t finish(SampleBatch& out);
+    // Input rate changed (e.g. sampling_ms written): rebuild the table
+    void setInputPeriod(uint64_t input_period_ns);
+    void reset();
+
+    unsigned halfWidth() const { return half; }
+    std::string describe() const;
+};
+
+// "100", "100:linear" or "100:sinc[:ZERO_CROSSINGS]" (period in ms)
+bool parseResampleSpec(const std::string& spec, ResamplerConfig& config);
+
+} // namespace simtemp
+
+#endif // SIMTEMP_RESAMPLE_H
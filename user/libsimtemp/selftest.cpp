@@ -0,0 +1,515 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Concurrent functional self-test.
+ */
+
+#include "selftest.h"
+#include "checkpoint.h"
+#include "format.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+namespace simtemp {
+
+static const size_t READ_MAX = 256;
+
+typedef std::chrono::steady_clock Clock;
+
+namespace {
+
+/*
+ * One scenario's hold on an instance: its own open file (extended records
+ * when available), the configuration to put back, and waits bounded by
+ * the scenario deadline.
+ */
+class Instance {
+private:
+    SimTempDevice device;
+    std::string saved_sampling;
+    std::string saved_threshold;
+    std::string saved_mode;
+    Clock::time_point deadline;
+
+public:
+    const SelfTestOptions& options;
+    uint64_t last_seq;
+
+    Instance(const std::string& path, const SelfTestOptions& options)
+        : device(path), options(options), last_seq(0) {}
+
+    ~Instance() {
+        // Restore in the reverse order of the usual changes
+        if (!saved_mode.empty()) {
+            device.configure("mode", saved_mode);
+        }
+        if (!saved_threshold.empty()) {
+            device.configure("threshold_mC", saved_threshold);
+        }
+        if (!saved_sampling.empty()) {
+            device.configure("sampling_ms", saved_sampling);
+        }
+    }
+
+    bool open(std::string& detail) {
+        saved_sampling = device.getConfig("sampling_ms");
+        saved_threshold = device.getConfig("threshold_mC");
+        saved_mode = device.getConfig("mode");
+        if (saved_sampling.empty() || saved_threshold.empty() || saved_mode.empty()) {
+            detail = "cannot read configuration from " + sysfsBaseFor(device.path());
+            return false;
+        }
+        if (!device.open()) {
+            detail = std::string("cannot open device: ") + strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    bool extended() const { return device.recordFormat() == RECORD_EXTENDED; }
+
+    bool set(const char* attr, const std::string& value, std::string& detail) {
+        if (!device.configure(attr, value)) {
+            detail = std::string("cannot write ") + attr + ": " + strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    bool set(const char* attr, long value, std::string& detail) {
+        return set(attr, std::to_string(value), detail);
+    }
+
+    // Start the wait budget for the next step
+    void arm() { deadline = Clock::now() + std::chrono::milliseconds(options.timeout_ms); }
+
+    // Discard everything buffered; samples read after this were produced
+    // after every configuration write that came before it
+    void drain() {
+        SampleBatch batch;
+        while (readBatch(device.fd(), batch, READ_MAX, 0, device.recordFormat()) > 0) {
+            if (!batch.seq.empty()) {
+                last_seq = batch.seq.back();
+            }
+            batch.clear();
+        }
+    }
+
+    // Append what arrives until the deadline; blocks in poll() meanwhile.
+    // Returns the number appended, 0 once the deadline has passed.
+    ssize_t next(SampleBatch& batch, size_t max_samples) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+        if (left.count() <= 0) {
+            return 0;
+        }
+        ssize_t got = readBatch(device.fd(), batch, max_samples, static_cast<int>(left.count()) + 1,
+                                device.recordFormat());
+        return got < 0 ? 0 : got;
+    }
+
+    // Block until the ring holds level samples (POLLRDBAND). Returns 1 once
+    // reached, 0 on timeout, -1 if the driver has no fill levels.
+    int waitFill(uint32_t level) {
+        if (!device.setFillLevel(level)) {
+            return errno == ENOTTY ? -1 : 0;
+        }
+        arm();
+        int result = 0;
+        while (result == 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+            if (left.count() <= 0) {
+                break;
+            }
+            struct pollfd pfd;
+            pfd.fd = device.fd();
+            pfd.events = POLLRDBAND;
+            pfd.revents = 0;
+            int ret = poll(&pfd, 1, static_cast<int>(left.count()) + 1);
+            if (ret > 0 && (pfd.revents & POLLRDBAND)) {
+                result = 1;
+            } else if (ret < 0 && errno != EINTR) {
+                break;
+            }
+        }
+        device.setFillLevel(0);
+        return result;
+    }
+
+    // Block until the driver has overwritten a sample. A full ring keeps
+    // the fd readable, so poll() would return at once; an edge-triggered
+    // epoll entry instead fires on every driver wake-up, once per expiry,
+    // and the count is checked after each.
+    bool waitOverwrite(RingStats& stats) {
+        int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0) {
+            return false;
+        }
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLET;
+        bool overwritten = false;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, device.fd(), &event) == 0) {
+            arm();
+            // Registered first, so a wake-up after this check is not missed
+            while (device.ringStats(stats)) {
+                if (stats.overwritten > 0) {
+                    overwritten = true;
+                    break;
+                }
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+                if (left.count() <= 0) {
+                    break;
+                }
+                struct epoll_event ready;
+                if (epoll_wait(epoll_fd, &ready, 1, static_cast<int>(left.count()) + 1) < 0 &&
+                    errno != EINTR) {
+                    break;
+                }
+            }
+        }
+        close(epoll_fd);
+        return overwritten;
+    }
+
+    bool ringStats(RingStats& stats) { return device.ringStats(stats); }
+    bool resetRing() { return resetRingStats(device.fd()); }
+
+    // Collect n samples
+    bool collect(size_t n, SampleBatch& batch) {
+        arm();
+        while (batch.size() < n) {
+            if (next(batch, n - batch.size()) == 0 && Clock::now() >= deadline) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Read until a sample carries flag; returns its index in batch or -1
+    long waitFlag(uint32_t flag, SampleBatch& batch) {
+        arm();
+        size_t scanned = 0;
+        while (true) {
+            for (; scanned < batch.size(); ++scanned) {
+                if (batch.flags[scanned] & flag) {
+                    return static_cast<long>(scanned);
+                }
+            }
+            if (next(batch, READ_MAX) == 0 && Clock::now() >= deadline) {
+                return -1;
+            }
+        }
+    }
+};
+
+// Median interval in ns; 0 with fewer than two samples
+uint64_t medianInterval(const SampleBatch& batch, size_t from) {
+    std::vector<uint64_t> intervals;
+    for (size_t i = from + 1; i < batch.size(); ++i) {
+        intervals.push_back(batch.timestamp_ns[i] - batch.timestamp_ns[i - 1]);
+    }
+    if (intervals.empty()) {
+        return 0;
+    }
+    std::nth_element(intervals.begin(), intervals.begin() + intervals.size() / 2, intervals.end());
+    return intervals[intervals.size() / 2];
+}
+
+// Timestamps strictly increasing and spaced by period_ms (10% or one
+// 250 us delivery tick, whichever is larger)
+bool checkTiming(const SampleBatch& batch, size_t from, uint32_t period_ms, std::string& detail) {
+    for (size_t i = from + 1; i < batch.size(); ++i) {
+        if (batch.timestamp_ns[i] <= batch.timestamp_ns[i - 1]) {
+            detail = "timestamps not increasing at sample " + std::to_string(i);
+            return false;
+        }
+    }
+    uint64_t period_ns = period_ms * 1000000ULL;
+    uint64_t median = medianInterval(batch, from);
+    uint64_t tolerance = std::max<uint64_t>(period_ns / 10, 250000);
+    if (median + tolerance < period_ns || median > period_ns + tolerance) {
+        char text[96];
+        snprintf(text, sizeof(text), "median interval %.3f ms, expected %u ms", median / 1e6, period_ms);
+        detail = text;
+        return false;
+    }
+    return true;
+}
+
+std::string describeRange(const char* what, int32_t lo, int32_t hi, size_t n) {
+    char lo_text[32];
+    char hi_text[32];
+    char text[160];
+    formatTemperature(lo_text, sizeof(lo_text), lo);
+    formatTemperature(hi_text, sizeof(hi_text), hi);
+    snprintf(text, sizeof(text), "%zu samples, %s %s..%s", n, what, lo_text, hi_text);
+    return text;
+}
+
+// Configure a mode at the scenario period and collect n fresh samples
+bool modeSamples(Instance& in, const char* mode, size_t n, SampleBatch& batch, std::string& detail) {
+    if (!in.set("mode", mode, detail) || !in.set("sampling_ms", in.options.sampling_ms, detail)) {
+        return false;
+    }
+    in.drain();
+    if (!in.collect(n, batch)) {
+        detail = "only " + std::to_string(batch.size()) + " of " + std::to_string(n) +
+                 " samples before the timeout";
+        return false;
+    }
+    return checkTiming(batch, 0, in.options.sampling_ms, detail);
+}
+
+bool scenarioNormal(Instance& in, std::string& detail, bool&) {
+    SampleBatch batch;
+    if (!modeSamples(in, "normal", 30, batch, detail)) {
+        return false;
+    }
+    auto range = std::minmax_element(batch.temp_mC.begin(), batch.temp_mC.end());
+    detail = describeRange("constant", *range.first, *range.second, batch.size());
+    return *range.first == *range.second;
+}
+
+bool scenarioNoisy(Instance& in, std::string& detail, bool&) {
+    SampleBatch batch;
+    if (!modeSamples(in, "noisy", 50, batch, detail)) {
+        return false;
+    }
+    auto range = std::minmax_element(batch.temp_mC.begin(), batch.temp_mC.end());
+    int32_t spread = *range.second - *range.first;
+    detail = describeRange("noise", *range.first, *range.second, batch.size());
+    return spread > 0 && spread < 2000;
+}
+
+bool scenarioRamp(Instance& in, std::string& detail, bool&) {
+    SampleBatch batch;
+    if (!modeSamples(in, "ramp", 30, batch, detail)) {
+        return false;
+    }
+    size_t steps = 0;
+    for (size_t i = 1; i < batch.size(); ++i) {
+        if (std::abs(batch.temp_mC[i] - batch.temp_mC[i - 1]) == 200) {
+            steps++;
+        }
+    }
+    auto range = std::minmax_element(batch.temp_mC.begin(), batch.temp_mC.end());
+    detail = describeRange("ramp", *range.first, *range.second, batch.size()) + ", " +
+             std::to_string(steps) + " steps of 0.200";
+    return steps * 10 >= (batch.size() - 1) * 7 && *range.second - *range.first >= 1000;
+}
+
+bool scenarioThreshold(Instance& in, std::string& detail, bool&) {
+    int32_t threshold = in.options.threshold_mC;
+    if (!in.set("mode", "ramp", detail) || !in.set("sampling_ms", in.options.sampling_ms, detail) ||
+        !in.set("threshold_mC", threshold, detail)) {
+        return false;
+    }
+    in.drain();
+
+    SampleBatch batch;
+    long at = in.waitFlag(FLAG_THRESHOLD_CROSSED, batch);
+    if (at < 0) {
+        detail = "no THRESHOLD_CROSSED in " + std::to_string(batch.size()) + " samples";
+        return false;
+    }
+    char temp[32];
+    formatTemperature(temp, sizeof(temp), batch.temp_mC[at]);
+    detail = "crossed at sample " + std::to_string(at + 1) + " (" + temp + ")";
+    if (at > 0 && (batch.temp_mC[at] > threshold) == (batch.temp_mC[at - 1] > threshold)) {
+        detail += ", but the previous sample is on the same side";
+        return false;
+    }
+    return true;
+}
+
+bool scenarioConfigChange(Instance& in, std::string& detail, bool&) {
+    uint32_t period = in.options.sampling_ms;
+    uint32_t doubled = period * 2;
+    if (!in.set("mode", "normal", detail) || !in.set("sampling_ms", period, detail)) {
+        return false;
+    }
+    in.drain();
+
+    // The first sample under the new period is marked; the ones after it
+    // follow the new period
+    SampleBatch batch;
+    if (!in.set("sampling_ms", doubled, detail)) {
+        return false;
+    }
+    long at = in.waitFlag(FLAG_CONFIG_CHANGED, batch);
+    if (at < 0) {
+        detail = "no CONFIG_CHANGED in " + std::to_string(batch.size()) + " samples";
+        return false;
+    }
+    if (!in.collect(at + 11, batch)) {
+        detail = "too few samples after the change";
+        return false;
+    }
+    if (!checkTiming(batch, at, doubled, detail)) {
+        return false;
+    }
+    detail = "marked after " + std::to_string(at) + " samples, then " + std::to_string(doubled) +
+             " ms intervals";
+    return true;
+}
+
+bool scenarioOverflow(Instance& in, std::string& detail, bool& skipped) {
+    if (!in.extended()) {
+        skipped = true;
+        detail = "driver has no sequence numbers";
+        return false;
+    }
+    // The ring size comes from the driver, not from a copy of its constant
+    RingStats ring;
+    if (!in.ringStats(ring)) {
+        skipped = errno == ENOTTY;
+        detail = std::string("cannot read ring statistics: ") + strerror(errno);
+        return false;
+    }
+    size_t capacity = ring.capacity;
+    if (!in.set("mode", "normal", detail) || !in.set("sampling_ms", 1, detail)) {
+        return false;
+    }
+    in.drain();
+    if (in.last_seq == 0) {
+        // Nothing buffered yet: the loss count needs a starting point
+        SampleBatch first;
+        if (!in.collect(1, first)) {
+            detail = "no samples at 1 ms";
+            return false;
+        }
+        in.last_seq = first.seq.back();
+    }
+
+    // POLLRDBAND at a full ring, then the driver wake-up that overwrote
+    // the oldest sample
+    if (!in.resetRing()) {
+        detail = std::string("cannot reset ring statistics: ") + strerror(errno);
+        return false;
+    }
+    if (in.waitFill(static_cast<uint32_t>(capacity)) <= 0) {
+        detail = "ring did not fill before the timeout";
+        return false;
+    }
+    if (!in.waitOverwrite(ring)) {
+        detail = "no sample overwritten before the timeout";
+        return false;
+    }
+
+    SampleBatch batch;
+    in.arm();
+    while (batch.size() < 2 * capacity &&
+           in.next(batch, READ_MAX) == static_cast<ssize_t>(READ_MAX)) {
+    }
+    size_t delivered = batch.size();
+    SequenceCursor cursor(in.last_seq);
+    cursor.advance(batch);
+    detail = std::to_string(delivered) + " samples delivered, " + std::to_string(cursor.samplesLost()) +
+             " overwritten, driver high-watermark " + std::to_string(ring.high_watermark) + "/" +
+             std::to_string(ring.capacity) + " overwritten " + std::to_string(ring.overwritten);
+    return cursor.samplesLost() > 0 && delivered >= capacity &&
+           ring.high_watermark == ring.capacity && ring.overwritten > 0;
+}
+
+typedef bool (*ScenarioFn)(Instance& in, std::string& detail, bool& skipped);
+
+struct Scenario {
+    const char* name;
+    ScenarioFn run;
+};
+
+const Scenario SCENARIOS[] = {
+    { "mode-normal", scenarioNormal },
+    { "mode-noisy", scenarioNoisy },
+    { "mode-ramp", scenarioRamp },
+    { "threshold", scenarioThreshold },
+    { "config-change", scenarioConfigChange },
+    { "overflow", scenarioOverflow },
+};
+const size_t SCENARIO_COUNT = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
+
+const Scenario* findScenario(const std::string& name) {
+    for (size_t i = 0; i < SCENARIO_COUNT; ++i) {
+        if (name == SCENARIOS[i].name) {
+            return &SCENARIOS[i];
+        }
+    }
+    return NULL;
+}
+
+void runOne(const Scenario* scenario, const SelfTestOptions& options, SelfTestResult& result) {
+    Clock::time_point start = Clock::now();
+    result.passed = false;
+    result.skipped = false;
+    if (!scenario) {
+        result.detail = "unknown scenario";
+    } else {
+        Instance in(result.device, options);
+        if (in.open(result.detail)) {
+            result.passed = scenario->run(in, result.detail, result.skipped);
+        }
+    }
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // namespace
+
+std::vector<std::string> selfTestScenarios() {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < SCENARIO_COUNT; ++i) {
+        names.push_back(SCENARIOS[i].name);
+    }
+    return names;
+}
+
+bool isSelfTestScenario(const std::string& name) {
+    return findScenario(name) != NULL;
+}
+
+std::vector<SelfTestResult> runSelfTests(const std::vector<std::string>& devices,
+                                         const std::vector<std::string>& scenarios,
+                                         const SelfTestOptions& options) {
+    std::vector<std::string> names = scenarios.empty() ? selfTestScenarios() : scenarios;
+    std::vector<SelfTestResult> results(names.size());
+    if (devices.empty()) {
+        for (size_t i = 0; i < names.size(); ++i) {
+            results[i].scenario = names[i];
+            results[i].passed = false;
+            results[i].skipped = false;
+            results[i].elapsed_ms = 0.0;
+            results[i].detail = "no device";
+        }
+        return results;
+    }
+
+    for (size_t i = 0; i < names.size(); ++i) {
+        results[i].scenario = names[i];
+        results[i].device = devices[i % devices.size()];
+    }
+
+    // Each worker owns the result slots of its device, so no locking
+    std::vector<std::thread> workers;
+    size_t used = std::min(devices.size(), names.size());
+    for (size_t d = 0; d < used; ++d) {
+        workers.push_back(std::thread([&, d]() {
+            for (size_t i = d; i < names.size(); i += devices.size()) {
+                runOne(findScenario(names[i]), options, results[i]);
+            }
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+    return results;
+}
+
+} // namespace simtemp
@@ -0,0 +1,57 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Functional self-test of the driver. Each scenario (simulation modes,
+ * threshold crossing, configuration change, ring overflow) configures one
+ * instance, waits for the samples that prove or disprove the behaviour and
+ * puts the configuration back. Waits are driven by the device: a scenario
+ * blocks in poll() until samples arrive and stops at the first sample that
+ * decides it, with a timeout only as an upper bound. Scenarios are spread
+ * over the given instances and the instances are tested concurrently, one
+ * thread each, so the suite takes about as long as its slowest instance.
+ */
+
+#ifndef SIMTEMP_SELFTEST_H
+#define SIMTEMP_SELFTEST_H
+
+#include "simtemp.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace simtemp {
+
+struct SelfTestOptions {
+    uint32_t timeout_ms;        // upper bound of each wait for samples
+    uint32_t sampling_ms;       // period used by the scenarios
+    int32_t threshold_mC;       // crossed by the ramp (base 25 C, +-2 C)
+
+    SelfTestOptions() : timeout_ms(3000), sampling_ms(10), threshold_mC(26000) {}
+};
+
+struct SelfTestResult {
+    std::string scenario;
+    std::string device;
+    bool passed;
+    bool skipped;               // not applicable to this driver (passed is false)
+    double elapsed_ms;
+    std::string detail;         // what was observed, or why it failed
+};
+
+// Built-in scenario names, in their default order
+std::vector<std::string> selfTestScenarios();
+bool isSelfTestScenario(const std::string& name);
+
+/*
+ * Run scenarios (all when empty) on devices. Scenario i goes to device
+ * i % devices.size(); each device runs its scenarios one after the other
+ * in its own thread. Results are returned in scenario order.
+ */
+std::vector<SelfTestResult> runSelfTests(const std::vector<std::string>& devices,
+                                         const std::vector<std::string>& scenarios,
+                                         const SelfTestOptions& options = SelfTestOptions());
+
+} // namespace simtemp
+
+#endif // SIMTEMP_SELFTEST_H
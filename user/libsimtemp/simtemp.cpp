@@ -0,0 +1,333 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Device access: batched reads and sysfs configuration.
+ */
+
+#include "simtemp.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <dirent.h>
+
+namespace simtemp {
+
+// Records transferred per read() call when draining into a batch
+static const size_t READ_CHUNK = 64;
+
+// One directory per instance, named like its device node
+static const char SYSFS_CLASS_DIR[] = "/sys/class/simtemp";
+
+bool setRecordFormat(int fd, RecordFormat format) {
+    uint32_t value = static_cast<uint32_t>(format);
+    return ioctl(fd, SIMTEMP_IOC_SET_FORMAT, &value) == 0;
+}
+
+bool setReaderThreshold(int fd, int32_t threshold_mC, uint32_t hysteresis_mC) {
+    ReaderThreshold threshold;
+    threshold.threshold_mC = threshold_mC;
+    threshold.hysteresis_mC = hysteresis_mC;
+    threshold.enabled = 1;
+    return ioctl(fd, SIMTEMP_IOC_SET_THRESHOLD, &threshold) == 0;
+}
+
+bool clearReaderThreshold(int fd) {
+    ReaderThreshold threshold;
+    memset(&threshold, 0, sizeof(threshold));
+    return ioctl(fd, SIMTEMP_IOC_SET_THRESHOLD, &threshold) == 0;
+}
+
+bool getReaderAlert(int fd, ReaderAlert& alert) {
+    return ioctl(fd, SIMTEMP_IOC_GET_ALERT, &alert) == 0;
+}
+
+bool getRingStats(int fd, RingStats& stats) {
+    return ioctl(fd, SIMTEMP_IOC_GET_RING, &stats) == 0;
+}
+
+bool resetRingStats(int fd) {
+    return ioctl(fd, SIMTEMP_IOC_RESET_RING) == 0;
+}
+
+bool setFillLevel(int fd, uint32_t samples) {
+    return ioctl(fd, SIMTEMP_IOC_SET_FILL_LEVEL, &samples) == 0;
+}
+
+template <typename Record>
+static ssize_t drainRecords(int fd, SampleBatch& batch, size_t max_samples) {
+    Record chunk[READ_CHUNK];
+    size_t total = 0;
+
+    while (total < max_samples) {
+        size_t want = max_samples - total;
+        if (want > READ_CHUNK) {
+            want = READ_CHUNK;
+        }
+
+        ssize_t bytes_read = ::read(fd, chunk, want * sizeof(Record));
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return total > 0 ? static_cast<ssize_t>(total) : -1;
+        }
+
+        size_t got = static_cast<size_t>(bytes_read) / sizeof(Record);
+        if (got == 0) {
+            break;
+        }
+        for (size_t i = 0; i < got; ++i) {
+            batch.push_back(chunk[i]);
+        }
+        total += got;
+    }
+
+    return static_cast<ssize_t>(total);
+}
+
+ssize_t readBatch(int fd, SampleBatch& batch, size_t max_samples, int timeout_ms,
+                  RecordFormat format) {
+    if (max_samples == 0) {
+        return 0;
+    }
+
+    if (timeout_ms >= 0) {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int ret = poll(&pfd, 1, timeout_ms);
+        if (ret == 0) {
+            return 0;
+        } else if (ret < 0) {
+            return -1;
+        }
+    }
+
+    batch.reserve(batch.size() + max_samples);
+    if (format == RECORD_EXTENDED) {
+        return drainRecords<SimTempSampleExt>(fd, batch, max_samples);
+    }
+    return drainRecords<SimTempSample>(fd, batch, max_samples);
+}
+
+std::string sysfsBaseFor(const std::string& device_path) {
+    size_t slash = device_path.rfind('/');
+    std::string name = slash == std::string::npos ? device_path : device_path.substr(slash + 1);
+    return std::string(SYSFS_CLASS_DIR) + "/" + name;
+}
+
+std::vector<std::string> findDevices() {
+    std::vector<std::string> devices;
+    DIR* dir = opendir(SYSFS_CLASS_DIR);
+    if (!dir) {
+        return devices;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        std::string path = std::string("/dev/") + entry->d_name;
+        if (access(path.c_str(), F_OK) == 0) {
+            devices.push_back(path);
+        }
+    }
+    closedir(dir);
+    // "simtemp" sorts before "simtemp1"; "simtemp10" after "simtemp9"
+    std::sort(devices.begin(), devices.end(), [](const std::string& a, const std::string& b) {
+        return a.size() != b.size() ? a.size() < b.size() : a < b;
+    });
+    return devices;
+}
+
+SimTempDevice::SimTempDevice(const std::string& path)
+    : device_path(path), sysfs_base(sysfsBaseFor(path)), device_fd(-1), is_open(false),
+      format(RECORD_BASIC) {}
+
+SimTempDevice::~SimTempDevice() {
+    close();
+}
+
+bool SimTempDevice::open() {
+    device_fd = ::open(device_path.c_str(), O_RDONLY | O_NONBLOCK);
+    if (device_fd < 0) {
+        fprintf(stderr, "Failed to open device %s: %s\n", device_path.c_str(), strerror(errno));
+        return false;
+    }
+    is_open = true;
+    format = setRecordFormat(device_fd, RECORD_EXTENDED) ? RECORD_EXTENDED : RECORD_BASIC;
+    return true;
+}
+
+void SimTempDevice::adopt(int fd, RecordFormat record_format) {
+    close();
+    device_fd = fd;
+    is_open = true;
+    format = record_format;
+}
+
+bool SimTempDevice::setThreshold(int32_t threshold_mC, uint32_t hysteresis_mC) {
+    if (!is_open) {
+        errno = EBADF;
+        return false;
+    }
+    return setReaderThreshold(device_fd, threshold_mC, hysteresis_mC);
+}
+
+bool SimTempDevice::ringStats(RingStats& stats) {
+    if (!is_open) {
+        errno = EBADF;
+        return false;
+    }
+    return getRingStats(device_fd, stats);
+}
+
+bool SimTempDevice::setFillLevel(uint32_t samples) {
+    if (!is_open) {
+        errno = EBADF;
+        return false;
+    }
+    return simtemp::setFillLevel(device_fd, samples);
+}
+
+void SimTempDevice::close() {
+    if (is_open && device_fd >= 0) {
+        ::close(device_fd);
+        device_fd = -1;
+        is_open = false;
+    }
+}
+
+bool SimTempDevice::readSample(SimTempSample& sample, double timeout_sec) {
+    if (!is_open) {
+        fprintf(stderr, "Device not open\n");
+        return false;
+    }
+
+    if (timeout_sec > 0.0) {
+        // Use poll for timeout
+        struct pollfd pfd;
+        pfd.fd = device_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int timeout_ms = static_cast<int>(timeout_sec * 1000);
+        int ret = poll(&pfd, 1, timeout_ms);
+
+        if (ret == 0) {
+            fprintf(stderr, "Read timeout\n");
+            return false;
+        } else if (ret < 0) {
+            fprintf(stderr, "Poll error: %s\n", strerror(errno));
+            return false;
+        }
+    }
+
+    ssize_t bytes_read;
+    if (format == RECORD_EXTENDED) {
+        SimTempSampleExt ext;
+        bytes_read = ::read(device_fd, &ext, sizeof(ext));
+        if (bytes_read == sizeof(ext)) {
+            sample.timestamp_ns = ext.timestamp_ns;
+            sample.temp_mC = ext.temp_mC;
+            sample.flags = ext.flags;
+            bytes_read = sizeof(sample);
+        }
+    } else {
+        bytes_read = ::read(device_fd, &sample, sizeof(sample));
+    }
+    if (bytes_read != sizeof(sample)) {
+        if (errno == EAGAIN) {
+            fprintf(stderr, "No data available\n");
+        } else {
+            fprintf(stderr, "Read error: %s\n", strerror(errno));
+        }
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<SimTempSample> SimTempDevice::readSamples(int count, double timeout_sec) {
+    std::vector<SimTempSample> samples;
+    samples.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        SimTempSample sample;
+        if (readSample(sample, timeout_sec)) {
+            samples.push_back(sample);
+        } else {
+            break;
+        }
+    }
+
+    return samples;
+}
+
+ssize_t SimTempDevice::readBatch(SampleBatch& batch, size_t max_samples, double timeout_sec) {
+    if (!is_open) {
+        fprintf(stderr, "Device not open\n");
+        return -1;
+    }
+
+    int timeout_ms = timeout_sec > 0.0 ? static_cast<int>(timeout_sec * 1000) : -1;
+    ssize_t ret = simtemp::readBatch(device_fd, batch, max_samples, timeout_ms, format);
+    if (ret < 0) {
+        fprintf(stderr, "Read error: %s\n", strerror(errno));
+    }
+    return ret;
+}
+
+// First line of a sysfs attribute (without the newline), "" on error
+static std::string readAttributeLine(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open %s: %s\n", path.c_str(), strerror(errno));
+        return "";
+    }
+
+    char buf[4096];
+    ssize_t n;
+    do {
+        n = ::read(fd, buf, sizeof(buf));
+    } while (n < 0 && errno == EINTR);
+    ::close(fd);
+    if (n <= 0) {
+        return "";
+    }
+    const char* end = static_cast<const char*>(memchr(buf, '\n', n));
+    return std::string(buf, end ? static_cast<size_t>(end - buf) : static_cast<size_t>(n));
+}
+
+bool SimTempDevice::configure(const std::string& param, const std::string& value) {
+    std::string sysfs_path = sysfs_base + "/" + param;
+    int fd = ::open(sysfs_path.c_str(), O_WRONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open %s: %s\n", sysfs_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    ssize_t n = ::write(fd, value.data(), value.size());
+    ::close(fd);
+    return n == static_cast<ssize_t>(value.size());
+}
+
+std::string SimTempDevice::getConfig(const std::string& param) {
+    return readAttributeLine(sysfs_base + "/" + param);
+}
+
+std::string SimTempDevice::getStats() {
+    return readAttributeLine(sysfs_base + "/stats");
+}
+
+} // namespace simtemp
@@ -0,0 +1,255 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * libsimtemp wraps the /dev/simtemp character device and its sysfs attributes
+ * and provides the building blocks shared by the CLI applications: batched
+ * sample reads into column-oriented (SoA) batches, statistics and detector
+ * kernels, and recording files.
+ */
+
+#ifndef SIMTEMP_H
+#define SIMTEMP_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include <sys/ioctl.h>
+
+namespace simtemp {
+
+// Device paths
+const std::string DEVICE_PATH = "/dev/simtemp";
+const std::string SYSFS_BASE = "/sys/class/simtemp/simtemp";
+const std::string AGGREGATE_PATH = "/dev/simtemp-all";    // every instance in one stream
+
+// Sysfs directory of a device node: "/dev/simtemp3" -> "/sys/class/simtemp/simtemp3"
+std::string sysfsBaseFor(const std::string& device_path);
+// Device nodes of all instances ("/dev/simtemp", "/dev/simtemp1", ...), sorted
+std::vector<std::string> findDevices();
+
+// Binary record format (matches kernel structure)
+struct SimTempSample {
+    uint64_t timestamp_ns;
+    int32_t temp_mC;
+    uint32_t flags;
+} __attribute__((packed));
+
+// Extended record format (matches struct simtemp_sample_ext)
+struct SimTempSampleExt {
+    uint64_t timestamp_ns;
+    int32_t temp_mC;
+    uint32_t flags;
+    uint64_t seq;
+    uint32_t config_gen;
+    uint32_t queue_delay_us;    // shared bus wait before the conversion, 0 off-bus
+} __attribute__((packed));
+
+// Aggregate node record (matches struct simtemp_sample_tagged)
+struct SimTempSampleTagged {
+    uint64_t timestamp_ns;
+    int32_t temp_mC;
+    uint32_t flags;
+    uint64_t seq;               // the instance's sequence number
+    uint32_t device_id;         // instance number: 0 = simtemp, N = simtempN
+    uint32_t config_gen;
+} __attribute__((packed));
+
+// Flag definitions
+const uint32_t FLAG_NEW_SAMPLE = 0x01;
+const uint32_t FLAG_THRESHOLD_CROSSED = 0x02;
+const uint32_t FLAG_CONFIG_CHANGED = 0x04;     // first sample under a new configuration
+const uint32_t FLAG_DEGRADED = 0x08;           // produced while the driver's CPU governor is active
+
+// Record formats (selected per open file)
+enum RecordFormat {
+    RECORD_BASIC = 0,       // SimTempSample, no sequence numbers
+    RECORD_EXTENDED = 1     // SimTempSampleExt
+};
+
+// Per-file threshold (matches struct simtemp_threshold)
+struct ReaderThreshold {
+    int32_t threshold_mC;
+    uint32_t hysteresis_mC;     // band below the level a sample must reach to re-arm
+    uint32_t enabled;           // 0: follow the device threshold_mC
+};
+
+// Oldest pending crossing of a per-file threshold (matches struct simtemp_alert)
+struct ReaderAlert {
+    uint64_t seq;               // crossing sample, 0 = none pending
+    uint64_t timestamp_ns;
+    int32_t temp_mC;
+    uint32_t pending;           // crossings still pending after this one
+    uint32_t dropped;           // crossings lost while too many were pending
+    uint32_t reserved;
+};
+
+// Ring occupancy (matches struct simtemp_ring_stats); counters run from
+// the last reset
+struct RingStats {
+    uint32_t depth;             // samples queued now
+    uint32_t capacity;          // ring size in samples
+    uint32_t high_watermark;    // deepest queue
+    uint32_t fill_level;        // this fd's POLLRDBAND level, 0 = off
+    uint64_t high_ns;           // time spent at least 75% full
+    uint64_t overwritten;       // samples lost to a full ring
+};
+
+// Instances feeding an aggregate file (matches struct simtemp_select)
+const uint32_t AGGREGATE_MAX_DEVICES = 1024;
+struct AggregateSelect {
+    uint32_t all;               // 1: every instance, present and future
+    uint32_t reserved;
+    uint64_t mask[AGGREGATE_MAX_DEVICES / 64];  // bit N selects instance N
+};
+
+// IOCTL commands (match the driver header)
+const unsigned long SIMTEMP_IOC_SET_FORMAT = _IOW('s', 4, uint32_t);
+const unsigned long SIMTEMP_IOC_SET_THRESHOLD = _IOW('s', 5, ReaderThreshold);
+const unsigned long SIMTEMP_IOC_GET_THRESHOLD = _IOR('s', 6, ReaderThreshold);
+const unsigned long SIMTEMP_IOC_GET_RING = _IOR('s', 7, RingStats);
+const unsigned long SIMTEMP_IOC_RESET_RING = _IO('s', 8);
+const unsigned long SIMTEMP_IOC_SET_FILL_LEVEL = _IOW('s', 9, uint32_t);
+const unsigned long SIMTEMP_IOC_SET_SELECT = _IOW('s', 10, AggregateSelect);
+const unsigned long SIMTEMP_IOC_GET_SELECT = _IOR('s', 11, AggregateSelect);
+const unsigned long SIMTEMP_IOC_GET_ALERT = _IOR('s', 12, ReaderAlert);
+
+// Select the record format returned by read() on fd. Fails with ENOTTY on
+// drivers without extended record support.
+bool setRecordFormat(int fd, RecordFormat format);
+
+// Give fd its own threshold: THRESHOLD_CROSSED on samples read from fd and
+// POLLPRI on fd then follow this threshold instead of the device one, so
+// consumers with different limits can share a device. The driver evaluates
+// it on every sample, whichever fd reads it; POLLPRI stays up until each
+// crossing is read from fd or fetched with getReaderAlert(). Fails with
+// ENOTTY on drivers without per-file thresholds.
+bool setReaderThreshold(int fd, int32_t threshold_mC, uint32_t hysteresis_mC = 0);
+// Return fd to the device-wide threshold
+bool clearReaderThreshold(int fd);
+// Fetch and acknowledge the oldest crossing pending on fd (seq 0 if none),
+// e.g. one whose sample another consumer of the device read
+bool getReaderAlert(int fd, ReaderAlert& alert);
+
+// Ring occupancy of the device behind fd, with fd's fill level
+bool getRingStats(int fd, RingStats& stats);
+// Restart the high-watermark, time at 75% and overwritten counters
+bool resetRingStats(int fd);
+// POLLRDBAND on fd while at least samples are queued (0 disables), so a
+// consumer can sleep until the ring fills to a level, or notice it filling
+// and read larger batches before samples are overwritten. The ioctls fail
+// with ENOTTY on drivers without ring telemetry.
+bool setFillLevel(int fd, uint32_t samples);
+
+// Column-oriented batch of samples. Each column is contiguous so consumers
+// can run vectorizable loops over temperatures without touching timestamps.
+// seq holds driver sequence numbers (starting at 1), or 0 for samples read in
+// the basic record format.
+struct SampleBatch {
+    std::vector<uint64_t> timestamp_ns;
+    std::vector<int32_t> temp_mC;
+    std::vector<uint32_t> flags;
+    std::vector<uint64_t> seq;
+
+    size_t size() const { return temp_mC.size(); }
+    bool empty() const { return temp_mC.empty(); }
+
+    void clear() {
+        timestamp_ns.clear();
+        temp_mC.clear();
+        flags.clear();
+        seq.clear();
+    }
+
+    void reserve(size_t n) {
+        timestamp_ns.reserve(n);
+        temp_mC.reserve(n);
+        flags.reserve(n);
+        seq.reserve(n);
+    }
+
+    void push_back(const SimTempSample& sample) {
+        timestamp_ns.push_back(sample.timestamp_ns);
+        temp_mC.push_back(sample.temp_mC);
+        flags.push_back(sample.flags);
+        seq.push_back(0);
+    }
+
+    void push_back(const SimTempSampleExt& sample) {
+        timestamp_ns.push_back(sample.timestamp_ns);
+        temp_mC.push_back(sample.temp_mC);
+        flags.push_back(sample.flags);
+        seq.push_back(sample.seq);
+    }
+
+    void swap(SampleBatch& other) {
+        timestamp_ns.swap(other.timestamp_ns);
+        temp_mC.swap(other.temp_mC);
+        flags.swap(other.flags);
+        seq.swap(other.seq);
+    }
+
+    // Keep only the samples [first, size()) (used when dropping a prefix)
+    void erasePrefix(size_t first) {
+        timestamp_ns.erase(timestamp_ns.begin(), timestamp_ns.begin() + first);
+        temp_mC.erase(temp_mC.begin(), temp_mC.begin() + first);
+        flags.erase(flags.begin(), flags.begin() + first);
+        seq.erase(seq.begin(), seq.begin() + first);
+    }
+};
+
+/*
+ * Read up to max_samples records from an open device fd into batch (appended).
+ * Waits up to timeout_ms for the first sample (negative: do not wait; the fd
+ * is expected to be nonblocking), then drains whatever is ready without
+ * blocking. The driver returns as many whole records as fit in one read(),
+ * so a full batch usually costs a single syscall. format must match the
+ * format selected on fd.
+ *
+ * Returns the number of samples appended, 0 on timeout or no data, -1 on
+ * error (errno is preserved).
+ */
+ssize_t readBatch(int fd, SampleBatch& batch, size_t max_samples, int timeout_ms = -1,
+                  RecordFormat format = RECORD_BASIC);
+
+class SimTempDevice {
+private:
+    std::string device_path;
+    std::string sysfs_base;
+    int device_fd;
+    bool is_open;
+    RecordFormat format;
+
+public:
+    SimTempDevice(const std::string& path = DEVICE_PATH);
+    ~SimTempDevice();
+
+    bool open();
+    // Take ownership of an already open device file (e.g. received from a
+    // collector handoff) whose record format is already selected
+    void adopt(int fd, RecordFormat format);
+    void close();
+    bool isOpen() const { return is_open; }
+    int fd() const { return device_fd; }
+    // Extended records (with sequence numbers) are enabled on open() when the
+    // driver supports them
+    RecordFormat recordFormat() const { return format; }
+    const std::string& path() const { return device_path; }
+
+    bool readSample(SimTempSample& sample, double timeout_sec = -1.0);
+    std::vector<SimTempSample> readSamples(int count, double timeout_sec = -1.0);
+    ssize_t readBatch(SampleBatch& batch, size_t max_samples, double timeout_sec = -1.0);
+    // Alerts for this open file only (see setReaderThreshold())
+    bool setThreshold(int32_t threshold_mC, uint32_t hysteresis_mC = 0);
+    bool ringStats(RingStats& stats);
+    bool setFillLevel(uint32_t samples);
+
+    bool configure(const std::string& param, const std::string& value);
+    std::string getConfig(const std::string& param);
+    std::string getStats();
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_H
@@ -0,0 +1,317 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Recording and text sinks, bounded queue with drop policies.
+ */
+
+#include "sink.h"
+#include "format.h"
+
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+namespace simtemp {
+
+// Memory held by a queued batch (all four columns)
+static size_t batchBytes(const SampleBatch& batch) {
+    return batch.size() * (sizeof(uint64_t) + sizeof(int32_t) + sizeof(uint32_t) + sizeof(uint64_t));
+}
+
+static bool writeAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool RecordingSink::write(const SampleBatch& batch) {
+    return writer.append(batch);
+}
+
+bool RecordingSink::writeSummary(const SampleSummary&) {
+    errno = ENOTSUP;
+    return false;
+}
+
+bool RecordingSink::flush() {
+    return writer.flush();
+}
+
+bool TextSink::write(const SampleBatch& batch) {
+    char line[96];
+    char temp[32];
+
+    buffer.clear();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        formatMilli(temp, sizeof(temp), batch.temp_mC[i]);
+        int len = snprintf(line, sizeof(line), "ts_ns=%llu temp=%sC alert=%d\n",
+                           static_cast<unsigned long long>(batch.timestamp_ns[i]), temp,
+                           (batch.flags[i] & FLAG_THRESHOLD_CROSSED) ? 1 : 0);
+        buffer.append(line, len);
+    }
+    return writeAll(fd, buffer.data(), buffer.size());
+}
+
+bool TextSink::writeSummary(const SampleSummary& summary) {
+    char line[192];
+    char min_str[32];
+    char max_str[32];
+    char mean_str[32];
+
+    formatMilli(min_str, sizeof(min_str), summary.stats.min_mC);
+    formatMilli(max_str, sizeof(max_str), summary.stats.max_mC);
+    formatMilli(mean_str, sizeof(mean_str), static_cast<int64_t>(summary.stats.mean_mC));
+    int len = snprintf(line, sizeof(line),
+                       "summary first_ns=%llu last_ns=%llu count=%zu min=%sC max=%sC mean=%sC alerts=%zu\n",
+                       static_cast<unsigned long long>(summary.first_ns),
+                       static_cast<unsigned long long>(summary.last_ns),
+                       summary.stats.count, min_str, max_str, mean_str, summary.stats.alerts);
+    return writeAll(fd, line, len);
+}
+
+bool parseSinkPolicy(const std::string& text, SinkConfig& config) {
+    if (text == "block") {
+        config.policy = SINK_BLOCK;
+    } else if (text == "drop-oldest") {
+        config.policy = SINK_DROP_OLDEST;
+    } else if (text == "summarize") {
+        config.policy = SINK_SUMMARIZE;
+    } else if (text.compare(0, 6, "spill:") == 0) {
+        char* end = NULL;
+        unsigned long mb = strtoul(text.c_str() + 6, &end, 10);
+        if (end == text.c_str() + 6 || *end != '\0' || mb == 0) {
+            return false;
+        }
+        config.policy = SINK_SPILL;
+        config.spill_limit_bytes = static_cast<size_t>(mb) << 20;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* sinkPolicyName(SinkPolicy policy) {
+    switch (policy) {
+    case SINK_BLOCK:
+        return "block";
+    case SINK_DROP_OLDEST:
+        return "drop-oldest";
+    case SINK_SPILL:
+        return "spill";
+    case SINK_SUMMARIZE:
+        return "summarize";
+    }
+    return "unknown";
+}
+
+QueuedSink::QueuedSink(SampleSink& sink, const SinkConfig& config)
+    : sink(sink), config(config), queued_batches(0), closing(false) {
+    memset(&stats, 0, sizeof(stats));
+    worker = std::thread(&QueuedSink::run, this);
+}
+
+QueuedSink::~QueuedSink() {
+    close();
+}
+
+bool QueuedSink::push(SampleBatch& batch) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (closing) {
+        return false;
+    }
+    if (batch.empty()) {
+        return true;
+    }
+
+    stats.batches_in++;
+    stats.samples_in += batch.size();
+
+    if (queued_batches < config.max_batches) {
+        enqueue(batch, false);
+        return true;
+    }
+
+    switch (config.policy) {
+    case SINK_BLOCK: {
+        auto start = std::chrono::steady_clock::now();
+        stats.blocked++;
+        not_full.wait(lock, [this] { return queued_batches < config.max_batches || closing; });
+        stats.blocked_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        if (closing) {
+            // Closed while waiting: the worker may already be gone
+            stats.batches_dropped++;
+            stats.samples_dropped += batch.size();
+            batch.clear();
+            return false;
+        }
+        enqueue(batch, false);
+        break;
+    }
+    case SINK_SPILL:
+        if (stats.spill_bytes + batchBytes(batch) <= config.spill_limit_bytes) {
+            enqueue(batch, true);
+            break;
+        }
+        dropOldest();
+        enqueue(batch, false);
+        break;
+    case SINK_DROP_OLDEST:
+        dropOldest();
+        enqueue(batch, false);
+        break;
+    case SINK_SUMMARIZE:
+        summarize(batch);
+        break;
+    }
+    return true;
+}
+
+void QueuedSink::enqueue(SampleBatch& batch, bool spilled) {
+    queue.push_back(Item());
+    Item& item = queue.back();
+    item.batch.swap(batch);
+    item.is_summary = false;
+    item.spilled = spilled;
+    queued_batches++;
+
+    if (spilled) {
+        stats.batches_spilled++;
+        stats.spill_bytes += batchBytes(item.batch);
+        if (stats.spill_bytes > stats.spill_peak_bytes) {
+            stats.spill_peak_bytes = stats.spill_bytes;
+        }
+    }
+
+    // Hand the caller recycled storage for its next read
+    if (!spare.empty()) {
+        batch.swap(spare.back());
+        spare.pop_back();
+    }
+
+    if (queue.size() > stats.peak_depth) {
+        stats.peak_depth = queue.size();
+    }
+    not_empty.notify_one();
+}
+
+void QueuedSink::dropOldest() {
+    for (std::deque<Item>::iterator it = queue.begin(); it != queue.end(); ++it) {
+        if (it->is_summary) {
+            continue;
+        }
+        stats.batches_dropped++;
+        stats.samples_dropped += it->batch.size();
+        if (it->spilled) {
+            stats.spill_bytes -= batchBytes(it->batch);
+        }
+        queue.erase(it);
+        queued_batches--;
+        return;
+    }
+}
+
+void QueuedSink::summarize(SampleBatch& batch) {
+    SampleSummary summary;
+    summary.stats = computeStats(batch.temp_mC.data(), batch.flags.data(), batch.size());
+    summary.first_ns = batch.timestamp_ns.front();
+    summary.last_ns = batch.timestamp_ns.back();
+    stats.batches_summarized++;
+    stats.samples_summarized += batch.size();
+    batch.clear();
+
+    // Consecutive overflow collapses into one summary, so summaries stay tiny
+    if (!queue.empty() && queue.back().is_summary) {
+        mergeStats(queue.back().summary.stats, summary.stats);
+        queue.back().summary.last_ns = summary.last_ns;
+        return;
+    }
+
+    queue.push_back(Item());
+    queue.back().is_summary = true;
+    queue.back().spilled = false;
+    queue.back().summary = summary;
+    not_empty.notify_one();
+}
+
+void QueuedSink::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        not_empty.wait(lock, [this] { return !queue.empty() || closing; });
+        if (queue.empty()) {
+            break;
+        }
+
+        Item item = std::move(queue.front());
+        queue.pop_front();
+        if (!item.is_summary) {
+            queued_batches--;
+            if (item.spilled) {
+                stats.spill_bytes -= batchBytes(item.batch);
+            }
+        }
+        not_full.notify_one();
+
+        if (item.is_summary && !sink.storesSummaries()) {
+            stats.summaries_dropped++;
+            continue;
+        }
+
+        // The sink may stall (slow disk, blocked pipe); producers keep going
+        lock.unlock();
+        bool ok = item.is_summary ? sink.writeSummary(item.summary) : sink.write(item.batch);
+        lock.lock();
+
+        if (!ok) {
+            stats.write_errors++;
+        } else if (item.is_summary) {
+            stats.summaries_written++;
+        } else {
+            stats.batches_written++;
+            stats.samples_written += item.batch.size();
+        }
+
+        if (!item.is_summary && spare.size() < config.max_batches) {
+            item.batch.clear();
+            spare.push_back(SampleBatch());
+            spare.back().swap(item.batch);
+        }
+    }
+
+    lock.unlock();
+    sink.flush();
+}
+
+void QueuedSink::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    not_empty.notify_all();
+    not_full.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+SinkCounters QueuedSink::counters() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    SinkCounters snapshot = stats;
+    snapshot.depth = queue.size();
+    return snapshot;
+}
+
+} // namespace simtemp
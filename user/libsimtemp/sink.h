@@ -0,0 +1,170 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Sample sinks and backpressure. A SampleSink consumes batches (a recording
+ * file, a text stream, ...). QueuedSink puts any sink behind a bounded queue
+ * drained by its own thread, so a stalled disk or terminal never stalls the
+ * device reader; when the queue is full the configured policy decides where
+ * samples are lost, and every decision is counted.
+ */
+
+#ifndef SIMTEMP_SINK_H
+#define SIMTEMP_SINK_H
+
+#include "simtemp.h"
+#include "stats.h"
+#include "recording.h"
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+// Samples reduced to statistics when the queue could not hold them
+struct SampleSummary {
+    BatchStats stats;
+    uint64_t first_ns;
+    uint64_t last_ns;
+};
+
+class SampleSink {
+public:
+    virtual ~SampleSink() {}
+
+    virtual bool write(const SampleBatch& batch) = 0;
+    virtual bool writeSummary(const SampleSummary& summary) = 0;
+    virtual bool flush() { return true; }
+    // false when the sink has nowhere to put summaries: QueuedSink then
+    // counts them as dropped instead of calling writeSummary()
+    virtual bool storesSummaries() const { return true; }
+};
+
+// Appends batches to a recording. Recordings hold raw samples only, so
+// summaries cannot be stored: writeSummary() fails with ENOTSUP, and under
+// the summarize policy the summarized samples are lost (and counted so).
+class RecordingSink : public SampleSink {
+private:
+    RecordingWriter& writer;
+
+public:
+    explicit RecordingSink(RecordingWriter& writer) : writer(writer) {}
+
+    bool write(const SampleBatch& batch);
+    bool writeSummary(const SampleSummary& summary);
+    bool flush();
+    bool storesSummaries() const { return false; }
+};
+
+// One text line per sample ("ts_ns=... temp=25.000C alert=0") or summary,
+// written with write(2) to fd
+class TextSink : public SampleSink {
+private:
+    int fd;
+    std::string buffer;
+
+public:
+    explicit TextSink(int fd) : fd(fd) {}
+
+    bool write(const SampleBatch& batch);
+    bool writeSummary(const SampleSummary& summary);
+};
+
+enum SinkPolicy {
+    SINK_BLOCK,             // wait for room (the reader stalls, the ring may overflow)
+    SINK_DROP_OLDEST,       // discard the oldest queued batch
+    SINK_SPILL,             // queue beyond the bound up to spill_limit_bytes, then drop oldest
+    SINK_SUMMARIZE          // keep only statistics of batches that do not fit
+};
+
+struct SinkConfig {
+    SinkPolicy policy;
+    size_t max_batches;         // queue bound
+    size_t spill_limit_bytes;   // SINK_SPILL only
+
+    SinkConfig(SinkPolicy policy = SINK_BLOCK, size_t max_batches = 8,
+               size_t spill_limit_bytes = 0)
+        : policy(policy), max_batches(max_batches ? max_batches : 1),
+          spill_limit_bytes(spill_limit_bytes) {}
+};
+
+// Parse "block", "drop-oldest", "spill:MB" or "summarize"
+bool parseSinkPolicy(const std::string& text, SinkConfig& config);
+const char* sinkPolicyName(SinkPolicy policy);
+
+struct SinkCounters {
+    uint64_t batches_in;
+    uint64_t samples_in;
+    uint64_t batches_written;
+    uint64_t samples_written;
+    uint64_t blocked;               // pushes that had to wait for room
+    uint64_t blocked_ns;            // total time spent waiting
+    uint64_t batches_dropped;
+    uint64_t samples_dropped;
+    uint64_t batches_spilled;       // batches queued beyond the bound
+    uint64_t spill_bytes;           // memory currently held beyond the bound
+    uint64_t spill_peak_bytes;
+    uint64_t batches_summarized;
+    uint64_t samples_summarized;
+    uint64_t summaries_written;
+    uint64_t summaries_dropped;     // the sink cannot store summaries
+    uint64_t write_errors;
+    size_t depth;                   // queued items right now
+    size_t peak_depth;
+};
+
+class QueuedSink {
+private:
+    struct Item {
+        SampleBatch batch;
+        bool is_summary;
+        bool spilled;
+        SampleSummary summary;
+    };
+
+    SampleSink& sink;
+    SinkConfig config;
+    std::deque<Item> queue;
+    size_t queued_batches;          // non-summary items in queue
+    std::vector<SampleBatch> spare; // recycled batch storage
+    SinkCounters stats;
+    bool closing;
+    mutable std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::thread worker;
+
+    QueuedSink(const QueuedSink&);
+    QueuedSink& operator=(const QueuedSink&);
+
+    void run();
+    void dropOldest();
+    void summarize(SampleBatch& batch);
+    void enqueue(SampleBatch& batch, bool spilled);
+
+public:
+    QueuedSink(SampleSink& sink, const SinkConfig& config = SinkConfig());
+    ~QueuedSink();
+
+    /*
+     * Queue the contents of batch; batch is handed back empty (reusing the
+     * storage of an already written batch). Returns false only after
+     * close(). Whether the samples are written, dropped or summarized is
+     * decided by the policy and reflected in counters().
+     */
+    bool push(SampleBatch& batch);
+    // Write everything still queued and stop the worker thread
+    void close();
+
+    SinkCounters counters() const;
+    const SinkConfig& configuration() const { return config; }
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_SINK_H
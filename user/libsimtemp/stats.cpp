@@ -0,0 +1,98 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Batch statistics and threshold detector kernels.
+ */
+
+#include "stats.h"
+#include "simtemp.h"
+
+#include <cmath>
+
+namespace simtemp {
+
+BatchStats computeStats(const int32_t* temp_mC, const uint32_t* flags, size_t n) {
+    BatchStats stats = {0, 0, 0, 0.0, 0.0, 0};
+    if (n == 0) {
+        return stats;
+    }
+
+    // Integer accumulation keeps the loop free of conversions so it vectorizes
+    int32_t min_mC = temp_mC[0];
+    int32_t max_mC = temp_mC[0];
+    int64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int32_t t = temp_mC[i];
+        min_mC = t < min_mC ? t : min_mC;
+        max_mC = t > max_mC ? t : max_mC;
+        sum += t;
+    }
+
+    double mean = static_cast<double>(sum) / n;
+    double sq = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double d = temp_mC[i] - mean;
+        sq += d * d;
+    }
+
+    size_t alerts = 0;
+    if (flags) {
+        for (size_t i = 0; i < n; ++i) {
+            alerts += (flags[i] & FLAG_THRESHOLD_CROSSED) ? 1 : 0;
+        }
+    }
+
+    stats.count = n;
+    stats.min_mC = min_mC;
+    stats.max_mC = max_mC;
+    stats.mean_mC = mean;
+    stats.stddev_mC = std::sqrt(sq / n);
+    stats.alerts = alerts;
+    return stats;
+}
+
+void mergeStats(BatchStats& into, const BatchStats& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (into.count == 0) {
+        into = other;
+        return;
+    }
+
+    double n1 = static_cast<double>(into.count);
+    double n2 = static_cast<double>(other.count);
+    double n = n1 + n2;
+    double mean = (n1 * into.mean_mC + n2 * other.mean_mC) / n;
+    double d1 = into.mean_mC - mean;
+    double d2 = other.mean_mC - mean;
+    double var = (n1 * (into.stddev_mC * into.stddev_mC + d1 * d1) +
+                  n2 * (other.stddev_mC * other.stddev_mC + d2 * d2)) / n;
+
+    into.count += other.count;
+    into.min_mC = other.min_mC < into.min_mC ? other.min_mC : into.min_mC;
+    into.max_mC = other.max_mC > into.max_mC ? other.max_mC : into.max_mC;
+    into.mean_mC = mean;
+    into.stddev_mC = std::sqrt(var);
+    into.alerts += other.alerts;
+}
+
+size_t detectCrossings(const int32_t* temp_mC, size_t n, int32_t threshold_mC,
+                       int32_t* last_mC, uint32_t* indices) {
+    size_t found = 0;
+    bool above = *last_mC > threshold_mC;
+
+    for (size_t i = 0; i < n; ++i) {
+        bool now_above = temp_mC[i] > threshold_mC;
+        indices[found] = static_cast<uint32_t>(i);
+        found += (now_above != above) ? 1 : 0;
+        above = now_above;
+    }
+
+    if (n > 0) {
+        *last_mC = temp_mC[n - 1];
+    }
+    return found;
+}
+
+} // namespace simtemp
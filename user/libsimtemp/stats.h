@@ -0,0 +1,47 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Batch statistics and threshold detector kernels. Both operate on raw
+ * column pointers so they can be applied to SampleBatch columns, recording
+ * chunks or foreign buffers (e.g. Python memoryviews) without copying.
+ */
+
+#ifndef SIMTEMP_STATS_H
+#define SIMTEMP_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+struct BatchStats {
+    size_t count;
+    int32_t min_mC;
+    int32_t max_mC;
+    double mean_mC;
+    double stddev_mC;
+    size_t alerts;      // samples carrying FLAG_THRESHOLD_CROSSED
+};
+
+/*
+ * Compute min/max/mean/stddev of n temperatures. flags may be NULL, in which
+ * case alerts is reported as 0.
+ */
+BatchStats computeStats(const int32_t* temp_mC, const uint32_t* flags, size_t n);
+
+// Fold other into into, as if both had been computed over one batch
+void mergeStats(BatchStats& into, const BatchStats& other);
+
+/*
+ * Threshold crossing detector with the same semantics as the driver: a sample
+ * crosses when (temp > threshold) differs from (previous temp > threshold).
+ * last_mC carries the previous temperature across batches and is updated to
+ * the final sample. Indices of crossing samples are written to indices (which
+ * must hold n entries); the number of crossings is returned.
+ */
+size_t detectCrossings(const int32_t* temp_mC, size_t n, int32_t threshold_mC,
+                       int32_t* last_mC, uint32_t* indices);
+
+} // namespace simtemp
+
+#endif // SIMTEMP_STATS_H
@@ -0,0 +1,287 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Held sysfs attributes and driver stats parsing.
+ */
+
+#include "sysfs.h"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+
+namespace simtemp {
+
+SysfsAttribute::~SysfsAttribute() {
+    close();
+}
+
+bool SysfsAttribute::open(const std::string& path, bool writable) {
+    close();
+    attr_fd = ::open(path.c_str(), (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    return attr_fd >= 0;
+}
+
+void SysfsAttribute::close() {
+    if (attr_fd >= 0) {
+        ::close(attr_fd);
+        attr_fd = -1;
+    }
+}
+
+ssize_t SysfsAttribute::read(char* buf, size_t size) const {
+    if (size == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    ssize_t n;
+    do {
+        n = ::pread(attr_fd, buf, size - 1, 0);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        return -1;
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+bool SysfsAttribute::readInt(int64_t& value) const {
+    char buf[32];
+    ssize_t n = read(buf, sizeof(buf));
+    if (n <= 0) {
+        return false;
+    }
+
+    const char* p = buf;
+    bool negative = (*p == '-');
+    if (negative) {
+        p++;
+    }
+    if (*p < '0' || *p > '9') {
+        errno = EINVAL;
+        return false;
+    }
+    int64_t v = 0;
+    while (*p >= '0' && *p <= '9') {
+        v = v * 10 + (*p++ - '0');
+    }
+    value = negative ? -v : v;
+    return true;
+}
+
+bool SysfsAttribute::write(const char* value, size_t len) const {
+    ssize_t n;
+    do {
+        n = ::pwrite(attr_fd, value, len, 0);
+    } while (n < 0 && errno == EINTR);
+    return n == static_cast<ssize_t>(len);
+}
+
+// Parse a decimal (optionally negative) at p; advances p
+static bool parseDecimal(const char*& p, const char* end, int64_t& value) {
+    bool negative = (p < end && *p == '-');
+    if (negative) {
+        p++;
+    }
+    if (p >= end || *p < '0' || *p > '9') {
+        return false;
+    }
+    uint64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + static_cast<uint64_t>(*p++ - '0');
+    }
+    value = negative ? -static_cast<int64_t>(v) : static_cast<int64_t>(v);
+    return true;
+}
+
+static bool keyIs(const char* key, size_t key_len, const char* name) {
+    return strlen(name) == key_len && memcmp(key, name, key_len) == 0;
+}
+
+bool parseDriverStats(const char* text, size_t len, DriverStats& stats) {
+    const char* p = text;
+    const char* end = text + len;
+    bool have_updates = false;
+
+    memset(&stats, 0, sizeof(stats));
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\t')) {
+            p++;
+        }
+        const char* key = p;
+        while (p < end && *p != '=' && *p != ' ' && *p != '\n') {
+            p++;
+        }
+        if (p >= end || *p != '=') {
+            // Bare word or trailing garbage: skip it
+            while (p < end && *p != ' ' && *p != '\n') {
+                p++;
+            }
+            continue;
+        }
+        size_t key_len = static_cast<size_t>(p - key);
+        p++;
+
+        int64_t value = 0;
+        const char* value_start = p;
+        bool numeric = parseDecimal(p, end, value);
+        if (!numeric) {
+            p = value_start;
+            while (p < end && *p != ' ' && *p != '\n') {
+                p++;
+            }
+        }
+
+        if (keyIs(key, key_len, "updates")) {
+            if (!numeric) {
+                return false;
+            }
+            stats.updates = static_cast<uint64_t>(value);
+            have_updates = true;
+        } else if (keyIs(key, key_len, "alerts")) {
+            if (!numeric) {
+                return false;
+            }
+            stats.alerts = static_cast<uint64_t>(value);
+        } else if (keyIs(key, key_len, "errors")) {
+            if (!numeric) {
+                return false;
+            }
+            stats.errors = static_cast<uint64_t>(value);
+        } else if (keyIs(key, key_len, "last_error")) {
+            if (!numeric) {
+                return false;
+            }
+            stats.last_error = static_cast<int32_t>(value);
+        } else if (numeric && keyIs(key, key_len, "gov_level")) {
+            stats.gov_level = static_cast<uint32_t>(value);
+        } else if (numeric && keyIs(key, key_len, "batch")) {
+            stats.batch = static_cast<uint32_t>(value);
+        } else if (numeric && keyIs(key, key_len, "rate_div")) {
+            stats.rate_div = static_cast<uint32_t>(value);
+        } else if (numeric && keyIs(key, key_len, "cb_us")) {
+            stats.cb_us = static_cast<uint64_t>(value);
+        } else if (numeric && keyIs(key, key_len, "throttles")) {
+            stats.throttles = static_cast<uint64_t>(value);
+        }
+    }
+    return have_updates;
+}
+
+StatsDelta statsDelta(const DriverStats& prev, const DriverStats& cur, double interval_s) {
+    StatsDelta delta;
+    // Counters only move forward unless the module was reloaded
+    delta.interval_s = interval_s;
+    delta.updates = cur.updates >= prev.updates ? cur.updates - prev.updates : cur.updates;
+    delta.alerts = cur.alerts >= prev.alerts ? cur.alerts - prev.alerts : cur.alerts;
+    delta.errors = cur.errors >= prev.errors ? cur.errors - prev.errors : cur.errors;
+    double scale = interval_s > 0.0 ? 1.0 / interval_s : 0.0;
+    delta.updates_per_s = delta.updates * scale;
+    delta.alerts_per_s = delta.alerts * scale;
+    delta.errors_per_s = delta.errors * scale;
+    return delta;
+}
+
+bool StatsWatcher::open(const std::string& sysfs_base) {
+    return stats_attr.open(sysfs_base + "/stats");
+}
+
+bool StatsWatcher::sample(DriverStats& stats) {
+    ssize_t n = stats_attr.read(buffer, sizeof(buffer));
+    if (n < 0) {
+        return false;
+    }
+    if (!parseDriverStats(buffer, static_cast<size_t>(n), stats)) {
+        errno = EINVAL;
+        return false;
+    }
+    return true;
+}
+
+bool ConfigCache::open(const std::string& base) {
+    sysfs_base = base;
+    if (!gen_attr.open(base + "/config_gen") ||
+        !sampling_attr.open(base + "/sampling_ms") ||
+        !threshold_attr.open(base + "/threshold_mC") ||
+        !mode_attr.open(base + "/mode")) {
+        int saved = errno;
+        close();
+        errno = saved;
+        return false;
+    }
+    return refresh();
+}
+
+void ConfigCache::close() {
+    sampling_attr.close();
+    threshold_attr.close();
+    mode_attr.close();
+    gen_attr.close();
+}
+
+bool ConfigCache::refresh() {
+    // A write racing with the refresh moves the generation; try again
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        int64_t gen_before;
+        int64_t gen_after;
+        int64_t sampling;
+        int64_t threshold;
+        char mode[sizeof(cached.mode)];
+
+        if (!gen_attr.readInt(gen_before) || !sampling_attr.readInt(sampling) ||
+            !threshold_attr.readInt(threshold) || mode_attr.read(mode, sizeof(mode)) < 0 ||
+            !gen_attr.readInt(gen_after)) {
+            return false;
+        }
+        if (gen_before != gen_after) {
+            continue;
+        }
+
+        char* newline = strchr(mode, '\n');
+        if (newline) {
+            *newline = '\0';
+        }
+        cached.sampling_ms = static_cast<uint32_t>(sampling);
+        cached.threshold_mC = static_cast<int32_t>(threshold);
+        memcpy(cached.mode, mode, sizeof(cached.mode));
+        cached.generation = static_cast<uint32_t>(gen_after);
+        refreshes++;
+        return true;
+    }
+    errno = EAGAIN;
+    return false;
+}
+
+bool ConfigCache::poll(int timeout_ms) {
+    struct pollfd pfd;
+    pfd.fd = gen_attr.fd();
+    pfd.events = POLLPRI;
+    pfd.revents = 0;
+
+    int ret = ::poll(&pfd, 1, timeout_ms);
+    if (ret <= 0 || !(pfd.revents & (POLLPRI | POLLERR))) {
+        return false;
+    }
+
+    uint32_t previous = cached.generation;
+    return refresh() && cached.generation != previous;
+}
+
+bool ConfigCache::noteBatch(const SampleBatch& batch) {
+    uint32_t changed = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        changed |= batch.flags[i] & FLAG_CONFIG_CHANGED;
+    }
+    if (!changed) {
+        return false;
+    }
+
+    uint32_t previous = cached.generation;
+    return refresh() && cached.generation != previous;
+}
+
+} // namespace simtemp
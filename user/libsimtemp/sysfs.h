@@ -0,0 +1,138 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Held sysfs attributes. An attribute is opened once and re-read with
+ * pread(fd, buf, n, 0), which makes the driver regenerate the value, so
+ * periodic polling costs one syscall and no allocation per read.
+ */
+
+#ifndef SIMTEMP_SYSFS_H
+#define SIMTEMP_SYSFS_H
+
+#include "simtemp.h"
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+class SysfsAttribute {
+private:
+    int attr_fd;
+
+    SysfsAttribute(const SysfsAttribute&);
+    SysfsAttribute& operator=(const SysfsAttribute&);
+
+public:
+    SysfsAttribute() : attr_fd(-1) {}
+    ~SysfsAttribute();
+
+    bool open(const std::string& path, bool writable = false);
+    void close();
+    bool isOpen() const { return attr_fd >= 0; }
+    int fd() const { return attr_fd; }
+
+    // Current value into buf (NUL-terminated, trailing newline kept);
+    // returns its length or -1
+    ssize_t read(char* buf, size_t size) const;
+    bool readInt(int64_t& value) const;
+    bool write(const char* value, size_t len) const;
+};
+
+// Counters from the driver's stats attribute
+struct DriverStats {
+    uint64_t updates;
+    uint64_t alerts;
+    uint64_t errors;
+    int32_t last_error;
+    // CPU budget governor; zero from drivers without one
+    uint32_t gov_level;
+    uint32_t batch;
+    uint32_t rate_div;
+    uint64_t cb_us;             // timer callback time in the last second
+    uint64_t throttles;
+};
+
+/*
+ * Parse "key=value ..." text from the stats attribute into stats without
+ * allocating. Unknown keys are skipped, so newer drivers with more fields
+ * still parse. Returns false if a known field is malformed or updates is
+ * missing.
+ */
+bool parseDriverStats(const char* text, size_t len, DriverStats& stats);
+
+// Counter deltas and per-second rates between two snapshots
+struct StatsDelta {
+    double interval_s;
+    uint64_t updates;
+    uint64_t alerts;
+    uint64_t errors;
+    double updates_per_s;
+    double alerts_per_s;
+    double errors_per_s;
+};
+
+StatsDelta statsDelta(const DriverStats& prev, const DriverStats& cur, double interval_s);
+
+class StatsWatcher {
+private:
+    SysfsAttribute stats_attr;
+    char buffer[256];
+
+public:
+    bool open(const std::string& sysfs_base = SYSFS_BASE);
+    void close() { stats_attr.close(); }
+    // One pread() of the stats attribute, parsed into stats
+    bool sample(DriverStats& stats);
+};
+
+struct DeviceConfig {
+    uint32_t sampling_ms;
+    int32_t threshold_mC;
+    char mode[16];
+    uint32_t generation;        // driver's config_gen
+};
+
+/*
+ * Cached device configuration. The driver bumps config_gen and calls
+ * sysfs_notify() on every configuration write, and flags the first sample
+ * produced under the new configuration with FLAG_CONFIG_CHANGED, so the
+ * cache is only refreshed when one of those signals arrives: poll() on
+ * pollFd() reports POLLPRI, or a batch contains a flagged sample.
+ */
+class ConfigCache {
+private:
+    std::string sysfs_base;
+    SysfsAttribute sampling_attr;
+    SysfsAttribute threshold_attr;
+    SysfsAttribute mode_attr;
+    SysfsAttribute gen_attr;
+    DeviceConfig cached;
+    uint64_t refreshes;
+
+public:
+    ConfigCache() : refreshes(0) { cached = DeviceConfig(); }
+
+    // Open the attributes and load the current configuration
+    bool open(const std::string& sysfs_base = SYSFS_BASE);
+    void close();
+
+    // Reread all attributes (retried if the generation moves meanwhile)
+    bool refresh();
+    // Wait up to timeout_ms for a change notification and refresh if one
+    // arrived; returns true when the configuration changed
+    bool poll(int timeout_ms = 0);
+    // Refresh if batch contains a sample flagged FLAG_CONFIG_CHANGED;
+    // returns true when the configuration changed
+    bool noteBatch(const SampleBatch& batch);
+
+    // config_gen fd: poll for POLLPRI, then call refresh()
+    int pollFd() const { return gen_attr.fd(); }
+    const DeviceConfig& config() const { return cached; }
+    uint64_t refreshCount() const { return refreshes; }
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_SYSFS_H
@@ -0,0 +1,234 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Top-K index with lazy bounds and per-device rolling metrics.
+ */
+
+#include "topk.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace simtemp {
+
+TopK::TopK(size_t k) : k(k ? k : 1), promotions(0) {
+    top.reserve(this->k);
+}
+
+void TopK::place(size_t i, uint32_t device) {
+    top[i] = device;
+    slots[device].top_pos = static_cast<int32_t>(i);
+}
+
+void TopK::siftUp(size_t i) {
+    uint32_t device = top[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!weaker(device, top[parent])) {
+            break;
+        }
+        place(i, top[parent]);
+        i = parent;
+    }
+    place(i, device);
+}
+
+void TopK::siftDown(size_t i) {
+    uint32_t device = top[i];
+    size_t n = top.size();
+    while (true) {
+        size_t child = 2 * i + 1;
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n && weaker(top[child + 1], top[child])) {
+            child++;
+        }
+        if (!weaker(top[child], device)) {
+            break;
+        }
+        place(i, top[child]);
+        i = child;
+    }
+    place(i, device);
+}
+
+// rest is a max-heap: higher bound first, ties towards the lower id
+template <typename Bound>
+static bool boundLess(const Bound& a, const Bound& b) {
+    return a.bound < b.bound || (a.bound == b.bound && a.device > b.device);
+}
+
+void TopK::pushRest(uint32_t device) {
+    Bound b;
+    b.bound = slots[device].bound;
+    b.device = device;
+    rest.push_back(b);
+    std::push_heap(rest.begin(), rest.end(), boundLess<Bound>);
+
+    // Superseded bounds pile up; drop them once they dominate
+    if (rest.size() > 2 * slots.size() + 64) {
+        compactRest();
+    }
+}
+
+void TopK::popRest() {
+    std::pop_heap(rest.begin(), rest.end(), boundLess<Bound>);
+    rest.pop_back();
+}
+
+void TopK::compactRest() {
+    size_t kept = 0;
+    for (size_t i = 0; i < rest.size(); ++i) {
+        const Slot& s = slots[rest[i].device];
+        if (s.top_pos < 0 && rest[i].bound == s.bound) {
+            rest[kept++] = rest[i];
+        }
+    }
+    rest.resize(kept);
+    std::make_heap(rest.begin(), rest.end(), boundLess<Bound>);
+}
+
+void TopK::rebalance() {
+    // Promote from rest while its best device beats the weakest member
+    while (!rest.empty() && top.size() == k) {
+        Bound b = rest.front();
+        Slot& s = slots[b.device];
+        if (s.top_pos >= 0 || b.bound != s.bound) {
+            popRest();
+            continue;
+        }
+
+        uint32_t weakest = top[0];
+        int64_t floor = slots[weakest].value;
+        if (b.bound < floor || (b.bound == floor && b.device > weakest)) {
+            break;
+        }
+        if (s.value != b.bound) {
+            // Bound went stale while the device sat outside; tighten it
+            popRest();
+            s.bound = s.value;
+            pushRest(b.device);
+            continue;
+        }
+
+        popRest();
+        slots[weakest].top_pos = -1;
+        slots[weakest].bound = slots[weakest].value;
+        place(0, b.device);
+        siftDown(0);
+        pushRest(weakest);
+        promotions++;
+    }
+}
+
+void TopK::update(uint32_t device, int64_t value) {
+    if (device >= slots.size()) {
+        Slot empty = { 0, 0, -1, false };
+        slots.resize(device + 1, empty);
+    }
+
+    Slot& s = slots[device];
+    if (!s.known) {
+        s.known = true;
+        s.value = value;
+        s.bound = value;
+        if (top.size() < k) {
+            top.push_back(device);
+            siftUp(top.size() - 1);
+            return;
+        }
+        pushRest(device);
+        rebalance();
+        return;
+    }
+
+    int64_t old = s.value;
+    s.value = value;
+    if (s.top_pos >= 0) {
+        if (value > old) {
+            siftDown(s.top_pos);
+        } else if (value < old) {
+            siftUp(s.top_pos);
+            rebalance();
+        }
+        return;
+    }
+
+    // Outside the top: only a rise above the recorded bound matters
+    if (value <= s.bound) {
+        return;
+    }
+    s.bound = value;
+    if (top.size() == k && weaker(top[0], device)) {
+        uint32_t weakest = top[0];
+        slots[weakest].top_pos = -1;
+        slots[weakest].bound = slots[weakest].value;
+        place(0, device);
+        siftDown(0);
+        pushRest(weakest);
+        promotions++;
+    } else {
+        pushRest(device);
+    }
+}
+
+size_t TopK::query(std::vector<RankedValue>& out, bool sorted) const {
+    out.resize(top.size());
+    for (size_t i = 0; i < top.size(); ++i) {
+        out[i].device = top[i];
+        out[i].value = slots[top[i]].value;
+    }
+    if (!sorted) {
+        return out.size();
+    }
+    std::sort(out.begin(), out.end(), [](const RankedValue& a, const RankedValue& b) {
+        return a.value > b.value || (a.value == b.value && a.device < b.device);
+    });
+    return out.size();
+}
+
+SensorRanking::SensorRanking(size_t k, double rise_alpha)
+    : rise_alpha(rise_alpha > 0.0 && rise_alpha <= 1.0 ? rise_alpha : 0.05),
+      hottest_k(k), rising_k(k) {}
+
+void SensorRanking::update(uint32_t device, uint64_t timestamp_ns, int32_t temp_mC) {
+    if (device >= metrics.size()) {
+        Metrics empty = { 0, 0, 0.0, false };
+        metrics.resize(device + 1, empty);
+    }
+
+    Metrics& m = metrics[device];
+    if (m.primed && timestamp_ns > m.last_ns) {
+        double rate = (temp_mC - m.temp_mC) * 1e9 / static_cast<double>(timestamp_ns - m.last_ns);
+        m.rise += rise_alpha * (rate - m.rise);
+    }
+    m.primed = true;
+    m.last_ns = timestamp_ns;
+    m.temp_mC = temp_mC;
+
+    hottest_k.update(device, temp_mC);
+    // Rank on micro-degrees per second so slow rises do not all tie
+    rising_k.update(device, static_cast<int64_t>(std::llround(m.rise * 1000.0)));
+}
+
+void SensorRanking::updateBatch(uint32_t device, const SampleBatch& batch) {
+    for (size_t i = 0; i < batch.size(); ++i) {
+        update(device, batch.timestamp_ns[i], batch.temp_mC[i]);
+    }
+}
+
+void SensorRanking::fill(const TopK& index, std::vector<RankedSensor>& out, bool sorted) const {
+    std::vector<RankedValue> ranked;
+    index.query(ranked, sorted);
+    out.resize(ranked.size());
+    for (size_t i = 0; i < ranked.size(); ++i) {
+        const Metrics& m = metrics[ranked[i].device];
+        out[i].device = ranked[i].device;
+        out[i].temp_mC = m.temp_mC;
+        out[i].rise_mC_per_s = static_cast<int32_t>(std::lround(m.rise));
+        out[i].timestamp_ns = m.last_ns;
+    }
+}
+
+} // namespace simtemp
@@ -0,0 +1,125 @@
+/*
+ * NXP Simulated Temperature Sensor - User Space Library
+ *
+ * Streaming top-K across many devices. TopK keeps the K strongest devices
+ * in an indexed min-heap (root = weakest member) and everyone else in a
+ * lazy max-heap of upper bounds. A device outside the top only touches a
+ * heap when it beats the weakest member (promotion, O(log K)) or rises
+ * above its own recorded bound. Decreases outside the top cost nothing;
+ * stale bounds are tightened only when they compete for a slot. Queries
+ * copy the K members in heap order, O(K); ranking them is opt-in.
+ *
+ * SensorRanking feeds two TopK indexes from per-device rolling metrics:
+ * latest temperature and a smoothed rise rate.
+ */
+
+#ifndef SIMTEMP_TOPK_H
+#define SIMTEMP_TOPK_H
+
+#include "simtemp.h"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace simtemp {
+
+struct RankedValue {
+    uint32_t device;
+    int64_t value;
+};
+
+class TopK {
+private:
+    struct Slot {
+        int64_t value;
+        int64_t bound;          // >= value while outside the top
+        int32_t top_pos;        // index in top, -1 outside
+        bool known;
+    };
+
+    struct Bound {
+        int64_t bound;
+        uint32_t device;
+    };
+
+    size_t k;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> top;      // min-heap, weakest at top[0]
+    std::vector<Bound> rest;        // max-heap, may hold stale entries
+    uint64_t promotions;
+
+    // a ranks below b: lower value, ties broken towards the higher id
+    bool weaker(uint32_t a, uint32_t b) const {
+        return slots[a].value < slots[b].value ||
+               (slots[a].value == slots[b].value && a > b);
+    }
+    void place(size_t i, uint32_t device);
+    void siftUp(size_t i);
+    void siftDown(size_t i);
+    void pushRest(uint32_t device);
+    void popRest();
+    void rebalance();
+    void compactRest();
+
+public:
+    explicit TopK(size_t k);
+
+    // Set the metric of device (ids are dense, 0..N-1)
+    void update(uint32_t device, int64_t value);
+    // The members in heap order: out[0] is the weakest, the rest carry no
+    // order. sorted ranks them strongest first (ties towards the lower id)
+    // at O(K log K). Returns the number of entries (min(K, devices))
+    size_t query(std::vector<RankedValue>& out, bool sorted = false) const;
+
+    bool contains(uint32_t device) const {
+        return device < slots.size() && slots[device].top_pos >= 0;
+    }
+    size_t size() const { return top.size(); }
+    size_t capacity() const { return k; }
+    uint64_t promotionCount() const { return promotions; }
+};
+
+struct RankedSensor {
+    uint32_t device;
+    int32_t temp_mC;
+    int32_t rise_mC_per_s;
+    uint64_t timestamp_ns;
+};
+
+class SensorRanking {
+private:
+    struct Metrics {
+        uint64_t last_ns;
+        int32_t temp_mC;
+        double rise;            // EMA of the derivative, mC/s
+        bool primed;
+    };
+
+    std::vector<Metrics> metrics;
+    double rise_alpha;
+    TopK hottest_k;
+    TopK rising_k;
+
+    void fill(const TopK& index, std::vector<RankedSensor>& out, bool sorted) const;
+
+public:
+    // rise_alpha weights each new derivative in the rise-rate EMA
+    SensorRanking(size_t k, double rise_alpha = 0.05);
+
+    void update(uint32_t device, uint64_t timestamp_ns, int32_t temp_mC);
+    void updateBatch(uint32_t device, const SampleBatch& batch);
+
+    // Same order contract as TopK::query()
+    void hottest(std::vector<RankedSensor>& out, bool sorted = false) const {
+        fill(hottest_k, out, sorted);
+    }
+    void fastestRising(std::vector<RankedSensor>& out, bool sorted = false) const {
+        fill(rising_k, out, sorted);
+    }
+    size_t deviceCount() const { return metrics.size(); }
+};
+
+} // namespace simtemp
+
+#endif // SIMTEMP_TOPK_H